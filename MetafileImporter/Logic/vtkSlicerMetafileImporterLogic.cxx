@@ -40,6 +40,7 @@
 
 // VTK includes
 #include <vtkAddonMathUtilities.h>
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -52,11 +53,96 @@
 #endif
 
 // STD includes
+#include <fstream>
 #include <sstream>
 #include <algorithm>
 
 static const char IMAGE_NODE_BASE_NAME[]="Image";
 
+//----------------------------------------------------------------------------
+// Create a reader that reads the uncompressed pixel data of a metafile one frame at a time, using the image information
+// of the metafile reader. Returns nullptr if the pixel data is compressed or is not stored in a single file.
+static vtkSmartPointer<vtkImageReader2> CreateMetafileFrameReader(const std::string& fileName, vtkMetaImageReader* imageReader)
+{
+  std::ifstream headerStream(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!headerStream)
+  {
+    return nullptr;
+  }
+
+  bool bigEndian = false;
+  long headerSize = 0;
+  std::string line;
+  while (std::getline(headerStream, line))
+  {
+    size_t separatorPosition = line.find('=');
+    if (separatorPosition == std::string::npos)
+    {
+      continue;
+    }
+    std::string name = vtksys::SystemTools::TrimWhitespace(line.substr(0, separatorPosition));
+    std::string value = vtksys::SystemTools::TrimWhitespace(line.substr(separatorPosition + 1));
+    if (name == "CompressedData")
+    {
+      if (vtksys::SystemTools::UpperCase(value) == "TRUE")
+      {
+        return nullptr;
+      }
+    }
+    else if (name == "BinaryDataByteOrderMSB" || name == "ElementByteOrderMSB")
+    {
+      bigEndian = (vtksys::SystemTools::UpperCase(value) == "TRUE");
+    }
+    else if (name == "HeaderSize")
+    {
+      std::stringstream headerSizeSS(value);
+      headerSizeSS >> headerSize;
+    }
+    else if (name == "ElementDataFile")
+    {
+      // The element data file is the last field of the header
+      vtkSmartPointer<vtkImageReader2> frameReader = vtkSmartPointer<vtkImageReader2>::New();
+      if (value == "LOCAL")
+      {
+        // The pixel data starts right after the header
+        frameReader->SetFileName(fileName.c_str());
+        frameReader->SetHeaderSize(static_cast<unsigned long>(headerStream.tellg()));
+      }
+      else if (value.compare(0, 4, "LIST") == 0 || value.find('%') != std::string::npos)
+      {
+        // The frames are stored in separate files
+        return nullptr;
+      }
+      else
+      {
+        std::string dataFileName = vtksys::SystemTools::CollapseFullPath(value, vtksys::SystemTools::GetFilenamePath(fileName));
+        frameReader->SetFileName(dataFileName.c_str());
+        if (headerSize >= 0)
+        {
+          // If the header size is -1, the reader skips to the pixel data at the end of the file
+          frameReader->SetHeaderSize(static_cast<unsigned long>(headerSize));
+        }
+      }
+      frameReader->SetFileDimensionality(3);
+      frameReader->SetDataExtent(imageReader->GetDataExtent());
+      frameReader->SetDataSpacing(imageReader->GetDataSpacing());
+      frameReader->SetDataScalarType(imageReader->GetDataScalarType());
+      frameReader->SetNumberOfScalarComponents(imageReader->GetNumberOfScalarComponents());
+      frameReader->FileLowerLeftOn();
+      if (bigEndian)
+      {
+        frameReader->SetDataByteOrderToBigEndian();
+      }
+      else
+      {
+        frameReader->SetDataByteOrderToLittleEndian();
+      }
+      return frameReader;
+    }
+  }
+  return nullptr;
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerMetafileImporterLogic);
 
@@ -135,13 +221,11 @@ vtkMRMLSequenceNode* vtkSlicerMetafileImporterLogic::ReadSequenceMetafileImages(
   vtkNew<vtkTimerLog> timer;
   timer->StartTimer();
 #endif
+  // Only the header is read here. Uncompressed pixel data is read one frame at a time while the frames are added to
+  // the sequence, so that the frames are not kept in memory twice.
   vtkNew< vtkMetaImageReader > imageReader;
   imageReader->SetFileName( fileName.c_str() );
-  imageReader->Update();
-#ifdef ENABLE_PERFORMANCE_PROFILING
-  timer->StopTimer();
-  vtkInfoMacro("Image reading: " << timer->GetElapsedTime() << "sec\n");
-#endif
+  imageReader->UpdateInformation();
 
   // check for loading error
   int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
@@ -163,6 +247,17 @@ vtkMRMLSequenceNode* vtkSlicerMetafileImporterLogic::ReadSequenceMetafileImages(
     return NULL;
   }
 
+  vtkSmartPointer<vtkImageReader2> frameReader = CreateMetafileFrameReader(fileName, imageReader);
+  if (!frameReader)
+  {
+    // Compressed pixel data cannot be read by frame, so all frames are read at once
+    imageReader->Update();
+  }
+#ifdef ENABLE_PERFORMANCE_PROFILING
+  timer->StopTimer();
+  vtkInfoMacro("Image reading: " << timer->GetElapsedTime() << "sec\n");
+#endif
+
   // Create sequence node
   vtkSmartPointer<vtkMRMLSequenceNode> imagesSequenceNode = nullptr;
   if (this->GetMRMLScene())
@@ -183,21 +278,43 @@ vtkMRMLSequenceNode* vtkSlicerMetafileImporterLogic::ReadSequenceMetafileImages(
   int imagesSequenceNodeDisableModify = imagesSequenceNode->StartModify();
 
   // Grab the image data from the mha file
-  vtkImageData* imageData = imageReader->GetOutput();
+  int dimensions[3] = { imageExtent[1] - imageExtent[0] + 1, imageExtent[3] - imageExtent[2] + 1, imageExtent[5] - imageExtent[4] + 1 };
+  int scalarType = imageReader->GetDataScalarType();
+  int numberOfScalarComponents = imageReader->GetNumberOfScalarComponents();
   vtkSmartPointer<vtkImageData> emptySliceImageData=vtkSmartPointer<vtkImageData>::New();
-  int* dimensions = imageData->GetDimensions();
   emptySliceImageData->SetDimensions(dimensions[0],dimensions[1],1);
-  double* spacing = imageData->GetSpacing();
+  double* spacing = imageReader->GetDataSpacing();
   emptySliceImageData->SetSpacing(spacing[0],spacing[1],1);
   emptySliceImageData->SetOrigin(0,0,0);
 
-  int sliceSize=imageData->GetIncrements()[2] * imageData->GetScalarSize();
+  size_t sliceSize = static_cast<size_t>(dimensions[0]) * dimensions[1] * numberOfScalarComponents * vtkDataArray::GetDataTypeSize(scalarType);
   for ( int frameNumber = 0; frameNumber < dimensions[2]; frameNumber++ )
   {
+    unsigned char* startPtr = NULL;
+    if (frameReader)
+    {
+      // The reader output only holds the current frame
+      int frameExtent[6] = { imageExtent[0], imageExtent[1], imageExtent[2], imageExtent[3],
+        imageExtent[4] + frameNumber, imageExtent[4] + frameNumber };
+      frameReader->UpdateExtent(frameExtent);
+      startPtr = (unsigned char*)frameReader->GetOutput()->GetScalarPointer(imageExtent[0], imageExtent[2], frameExtent[4]);
+    }
+    else
+    {
+      startPtr = (unsigned char*)imageReader->GetOutput()->GetScalarPointer(imageExtent[0], imageExtent[2], imageExtent[4] + frameNumber);
+    }
+    if (!startPtr)
+    {
+      vtkErrorMacro("ReadSequenceMetafileImages: Failed to read frame " << frameNumber << " from " << fileName);
+      imagesSequenceNode->EndModify(imagesSequenceNodeDisableModify);
+      this->GetMRMLScene()->RemoveNode(imagesSequenceNode);
+      return NULL;
+    }
+
     // Add the image slice to scene as a volume
 
     vtkSmartPointer< vtkMRMLScalarVolumeNode > slice;
-    if (imageData->GetNumberOfScalarComponents() > 1)
+    if (numberOfScalarComponents > 1)
     {
       slice = vtkSmartPointer< vtkMRMLVectorVolumeNode >::New();
     }
@@ -209,9 +326,7 @@ vtkMRMLSequenceNode* vtkSlicerMetafileImporterLogic::ReadSequenceMetafileImages(
     vtkSmartPointer<vtkImageData> sliceImageData=vtkSmartPointer<vtkImageData>::New();
     sliceImageData->DeepCopy(emptySliceImageData);
 
-    sliceImageData->AllocateScalars(imageData->GetScalarType(), imageData->GetNumberOfScalarComponents());
-
-    unsigned char* startPtr=(unsigned char*)imageData->GetScalarPointer(0, 0, frameNumber);
+    sliceImageData->AllocateScalars(scalarType, numberOfScalarComponents);
     memcpy(sliceImageData->GetScalarPointer(), startPtr, sliceSize);
 
     // Generating a unique name is important because that will be used to generate the filename by default
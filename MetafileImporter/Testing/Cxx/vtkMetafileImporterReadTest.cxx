@@ -0,0 +1,208 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// std includes
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLVolumeNode.h>
+
+// MetafileImporter includes
+#include <vtkSlicerMetafileImporterLogic.h>
+
+namespace
+{
+  const int WIDTH = 320;
+  const int HEIGHT = 240;
+  const int NUMBER_OF_COMPONENTS = 3;
+  const int NUMBER_OF_FRAMES = 128;
+
+  //---------------------------------------------------------------------------
+  unsigned char GetPixelValue(int frameNumber, int x, int y, int component)
+  {
+    return static_cast<unsigned char>(frameNumber + 3 * x + 5 * y + 7 * component);
+  }
+
+  //---------------------------------------------------------------------------
+  // Write an uncompressed sequence metafile one frame at a time, so that the whole image is never in memory.
+  bool WriteSequenceMetafile(const std::string& fileName)
+  {
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    if (!file)
+    {
+      return false;
+    }
+    file << "ObjectType = Image\n"
+      << "NDims = 3\n"
+      << "AnatomicalOrientation = RAI\n"
+      << "BinaryData = True\n"
+      << "BinaryDataByteOrderMSB = False\n"
+      << "CenterOfRotation = 0 0 0\n"
+      << "CompressedData = False\n"
+      << "DimSize = " << WIDTH << " " << HEIGHT << " " << NUMBER_OF_FRAMES << "\n"
+      << "ElementNumberOfChannels = " << NUMBER_OF_COMPONENTS << "\n"
+      << "ElementSpacing = 1 1 1\n"
+      << "Offset = 0 0 0\n"
+      << "TransformMatrix = 1 0 0 0 1 0 0 0 1\n"
+      << "ElementType = MET_UCHAR\n";
+    for (int frameNumber = 0; frameNumber < NUMBER_OF_FRAMES; ++frameNumber)
+    {
+      std::string prefix = "Seq_Frame";
+      file << prefix << std::setw(4) << std::setfill('0') << frameNumber << "_ProbeToTrackerTransform = 1 0 0 " << frameNumber
+        << " 0 1 0 0 0 0 1 0 0 0 0 1\n";
+      file << prefix << std::setw(4) << std::setfill('0') << frameNumber << "_ProbeToTrackerTransformStatus = OK\n";
+      file << prefix << std::setw(4) << std::setfill('0') << frameNumber << "_Timestamp = " << 0.1 * frameNumber << "\n";
+    }
+    file << "UltrasoundImageOrientation = MF\n"
+      << "ElementDataFile = LOCAL\n";
+
+    std::vector<unsigned char> frame(WIDTH * HEIGHT * NUMBER_OF_COMPONENTS);
+    for (int frameNumber = 0; frameNumber < NUMBER_OF_FRAMES; ++frameNumber)
+    {
+      unsigned char* pixel = frame.data();
+      for (int y = 0; y < HEIGHT; ++y)
+      {
+        for (int x = 0; x < WIDTH; ++x)
+        {
+          for (int c = 0; c < NUMBER_OF_COMPONENTS; ++c)
+          {
+            *pixel++ = GetPixelValue(frameNumber, x, y, c);
+          }
+        }
+      }
+      file.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    }
+    return file.good();
+  }
+
+  //---------------------------------------------------------------------------
+  // Peak resident memory of the process in bytes, or 0 if it cannot be measured on this platform.
+  long long GetPeakMemoryUsage()
+  {
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+      return 1024LL * usage.ru_maxrss;
+    }
+#endif
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  bool CheckFrame(vtkMRMLSequenceNode* sequenceNode, int frameNumber)
+  {
+    vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(frameNumber));
+    vtkImageData* imageData = volumeNode ? volumeNode->GetImageData() : nullptr;
+    if (!imageData || imageData->GetScalarType() != VTK_UNSIGNED_CHAR || imageData->GetNumberOfScalarComponents() != NUMBER_OF_COMPONENTS)
+    {
+      std::cerr << "Invalid image for frame " << frameNumber << std::endl;
+      return false;
+    }
+    int* dimensions = imageData->GetDimensions();
+    if (dimensions[0] != WIDTH || dimensions[1] != HEIGHT || dimensions[2] != 1)
+    {
+      std::cerr << "Invalid dimensions for frame " << frameNumber << std::endl;
+      return false;
+    }
+    const unsigned char* pixel = static_cast<const unsigned char*>(imageData->GetScalarPointer());
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+      for (int x = 0; x < WIDTH; ++x)
+      {
+        for (int c = 0; c < NUMBER_OF_COMPONENTS; ++c)
+        {
+          if (*pixel++ != GetPixelValue(frameNumber, x, y, c))
+          {
+            std::cerr << "Unexpected pixel value in frame " << frameNumber << " at (" << x << ", " << y << ", " << c << ")" << std::endl;
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkMetafileImporterReadTest(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: vtkMetafileImporterReadTest <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string fileName = std::string(argv[1]) + "/vtkMetafileImporterReadTest.seq.mha";
+  if (!WriteSequenceMetafile(fileName))
+  {
+    std::cerr << "Could not write " << fileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLSequenceNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLSequenceBrowserNode>::New());
+  vtkNew<vtkSlicerMetafileImporterLogic> logic;
+  logic->SetMRMLScene(scene);
+
+  long long peakMemoryBefore = GetPeakMemoryUsage();
+  vtkMRMLSequenceBrowserNode* browserNode = logic->ReadSequenceFile(fileName);
+  long long peakMemoryIncrease = GetPeakMemoryUsage() - peakMemoryBefore;
+
+  vtkMRMLSequenceNode* imagesSequenceNode = browserNode ? browserNode->GetMasterSequenceNode() : nullptr;
+  if (!imagesSequenceNode || imagesSequenceNode->GetNumberOfDataNodes() != NUMBER_OF_FRAMES)
+  {
+    std::cerr << "Expected an image sequence with " << NUMBER_OF_FRAMES << " frames" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFrame(imagesSequenceNode, 0) || !CheckFrame(imagesSequenceNode, NUMBER_OF_FRAMES / 2)
+    || !CheckFrame(imagesSequenceNode, NUMBER_OF_FRAMES - 1))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // The frames are read one at a time, so the peak memory is close to the size of the images that are kept in the
+  // sequence. Reading the whole image before copying the frames would need about twice as much.
+  long long imageDataSize = static_cast<long long>(WIDTH) * HEIGHT * NUMBER_OF_COMPONENTS * NUMBER_OF_FRAMES;
+  std::cout << "Image data size: " << imageDataSize / (1024 * 1024) << " MB, peak memory increase: "
+    << peakMemoryIncrease / (1024 * 1024) << " MB" << std::endl;
+  if (peakMemoryBefore > 0 && peakMemoryIncrease > 1.5 * imageDataSize)
+  {
+    std::cerr << "Peak memory increase is more than 1.5 times the image data size" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
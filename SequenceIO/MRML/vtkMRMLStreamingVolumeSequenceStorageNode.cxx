@@ -30,6 +30,7 @@ Care Ontario.
 
 // SlicerIGSIOCommon includes
 #include "vtkSlicerIGSIOCommon.h"
+#include "vtkSlicerIGSIOEncoderState.h"
 
 // IGSIOCommon includes
 #include <vtkIGSIOTrackedFrameList.h>
@@ -46,6 +47,7 @@ vtkMRMLNodeNewMacro(vtkMRMLStreamingVolumeSequenceStorageNode);
 //----------------------------------------------------------------------------
 vtkMRMLStreamingVolumeSequenceStorageNode::vtkMRMLStreamingVolumeSequenceStorageNode()
   : CodecFourCC("")
+  , EncoderState(vtkSmartPointer<vtkSlicerIGSIOEncoderState>::New())
 {
 }
 
@@ -54,6 +56,12 @@ vtkMRMLStreamingVolumeSequenceStorageNode::~vtkMRMLStreamingVolumeSequenceStorag
 {
 }
 
+//----------------------------------------------------------------------------
+vtkSlicerIGSIOEncoderState* vtkMRMLStreamingVolumeSequenceStorageNode::GetEncoderState()
+{
+  return this->EncoderState;
+}
+
 //----------------------------------------------------------------------------
 bool vtkMRMLStreamingVolumeSequenceStorageNode::CanReadInReferenceNode(vtkMRMLNode* refNode)
 {
@@ -85,8 +93,16 @@ int vtkMRMLStreamingVolumeSequenceStorageNode::ReadDataInternal(vtkMRMLNode* ref
   vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
   if (vtkIGSIOSequenceIO::Read(this->FileName, trackedFrameList) == IGSIO_SUCCESS)
   {
-    vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, sequenceNode);
+    // The tracked frames are consumed by the conversion, so the codec is read from the list first
     trackedFrameList->GetEncodingFourCC(this->CodecFourCC);
+    vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, sequenceNode, true);
+
+    // The decode mode can be specified for the file using an attribute of the storage node
+    const char* decodeMode = this->GetAttribute(vtkSlicerIGSIOCommon::GetDecodeModeAttributeName());
+    if (decodeMode)
+    {
+      sequenceNode->SetAttribute(vtkSlicerIGSIOCommon::GetDecodeModeAttributeName(), decodeMode);
+    }
   }
   else
   {
@@ -153,7 +169,8 @@ int vtkMRMLStreamingVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode* re
     }
   }
 
-  vtkSlicerIGSIOCommon::ReEncodeVideoSequence(videoStreamSequenceNode, 0, -1, this->CodecFourCC, parameters, false, true);
+  // Only the frames that were added since the last save are encoded, unless the sequence was changed in some other way
+  vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(videoStreamSequenceNode, this->CodecFourCC, parameters, this->EncoderState);
 
   vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer <vtkIGSIOTrackedFrameList>::New();
   vtkSlicerIGSIOCommon::VolumeSequenceToTrackedFrameList(videoStreamSequenceNode, trackedFrameList);
@@ -24,12 +24,14 @@ Care Ontario.
 #include "vtkSlicerSequenceIOModuleMRMLExport.h"
 
 #include "vtkMRMLStorageNode.h"
+#include <vtkSmartPointer.h>
 #include <string>
 
 class vtkIGSIOTrackedFrameList;
 class vtkGenericVideoReader;
 class vtkGenericVideoWriter;
 class vtkMRMLSequenceNode;
+class vtkSlicerIGSIOEncoderState;
 
 /// \ingroup Slicer_QtModules_Sequences
 class VTK_SLICER_SEQUENCEIO_MODULE_MRML_EXPORT vtkMRMLStreamingVolumeSequenceStorageNode : public vtkMRMLStorageNode
@@ -61,6 +63,10 @@ public:
   vtkSetMacro(CodecFourCC, std::string);
   vtkGetMacro(CodecFourCC, std::string);
 
+  /// State of the encoder between saves. Frames that were appended since the last save are encoded
+  /// without re-encoding the rest of the sequence.
+  vtkSlicerIGSIOEncoderState* GetEncoderState();
+
   /// Read node attributes from XML file
   void ReadXMLAttributes(const char** atts) override;
   /// Write this node's information to a MRML file in XML format.
@@ -94,6 +100,7 @@ protected:
   void UpdateCompressionPresets() override;
 
   std::string CodecFourCC;
+  vtkSmartPointer<vtkSlicerIGSIOEncoderState> EncoderState;
 };
 
 #endif
@@ -135,7 +135,7 @@ bool qSlicerSequenceIOReader::load(const IOProperties& properties)
 
   vtkSmartPointer<vtkMRMLSequenceBrowserNode> sequenceBrowserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(
     this->mrmlScene()->AddNewNodeByClass("vtkMRMLSequenceBrowserNode", fileNameNoExtension));
-  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, sequenceBrowserNode))
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, sequenceBrowserNode, true))
   {
     this->mrmlScene()->RemoveNode(sequenceBrowserNode);
     qCritical() << Q_FUNC_INFO << " could not convert tracked frame list to sequence browser node";
@@ -0,0 +1,118 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOBoundedQueue_h
+#define __vtkSlicerIGSIOBoundedQueue_h
+
+// STD includes
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/// Thread safe first-in first-out queue with a maximum size.
+/// Used to pass items between the stages of a producer/consumer pipeline.
+/// Push blocks while the queue is full, and Pop blocks while the queue is empty.
+/// Once the queue is closed, Push fails immediately and Pop fails after the remaining items have been removed.
+template<typename T>
+class vtkSlicerIGSIOBoundedQueue
+{
+public:
+  vtkSlicerIGSIOBoundedQueue(size_t maximumSize)
+    : MaximumSize(maximumSize > 0 ? maximumSize : 1)
+    , Closed(false)
+  {
+  }
+
+  /// Add an item to the back of the queue.
+  /// Returns false if the queue was closed before the item could be added.
+  bool Push(const T& item)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (this->Items.size() >= this->MaximumSize && !this->Closed)
+    {
+      this->NotFull.wait(lock);
+    }
+    if (this->Closed)
+    {
+      return false;
+    }
+    this->Items.push_back(item);
+    lock.unlock();
+    this->NotEmpty.notify_one();
+    return true;
+  }
+
+  /// Remove an item from the front of the queue.
+  /// Returns false if the queue is closed and there are no more items.
+  bool Pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (this->Items.empty() && !this->Closed)
+    {
+      this->NotEmpty.wait(lock);
+    }
+    if (this->Items.empty())
+    {
+      return false;
+    }
+    item = this->Items.front();
+    this->Items.pop_front();
+    lock.unlock();
+    this->NotFull.notify_one();
+    return true;
+  }
+
+  /// Stop accepting new items and wake up all waiting threads.
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Closed = true;
+    }
+    this->NotEmpty.notify_all();
+    this->NotFull.notify_all();
+  }
+
+  /// Close the queue and discard the remaining items.
+  void Abort()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Closed = true;
+      this->Items.clear();
+    }
+    this->NotEmpty.notify_all();
+    this->NotFull.notify_all();
+  }
+
+protected:
+  std::deque<T>           Items;
+  size_t                  MaximumSize;
+  bool                    Closed;
+  std::mutex              Mutex;
+  std::condition_variable NotEmpty;
+  std::condition_variable NotFull;
+
+private:
+  vtkSlicerIGSIOBoundedQueue(const vtkSlicerIGSIOBoundedQueue&); // Not implemented
+  void operator=(const vtkSlicerIGSIOBoundedQueue&);             // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOBoundedQueue_h
@@ -0,0 +1,222 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOBufferPool.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOBufferPool);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOBufferPool::vtkInternal
+{
+public:
+  vtkInternal()
+    : MaximumPooledBytes(256 * 1024 * 1024)
+    , PooledBytes(0)
+    , NumberOfImageHits(0)
+    , NumberOfImageMisses(0)
+  {
+  }
+
+  // Dimensions, scalar type and number of components
+  typedef std::tuple<int, int, int, int, int> ImageKey;
+
+  static ImageKey GetImageKey(int dimensions[3], int scalarType, int numberOfComponents)
+  {
+    return std::make_tuple(dimensions[0], dimensions[1], dimensions[2], scalarType, numberOfComponents);
+  }
+
+  static vtkIdType GetImageSize(vtkImageData* imageData)
+  {
+    vtkDataArray* scalars = imageData->GetPointData() ? imageData->GetPointData()->GetScalars() : nullptr;
+    return scalars ? scalars->GetDataSize() * scalars->GetDataTypeSize() : 0;
+  }
+
+  std::mutex Mutex;
+  std::map<ImageKey, std::vector<vtkSmartPointer<vtkImageData> > > Images;
+  vtkIdType MaximumPooledBytes;
+  vtkIdType PooledBytes;
+  vtkIdType NumberOfImageHits;
+  vtkIdType NumberOfImageMisses;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOBufferPool::vtkSlicerIGSIOBufferPool()
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOBufferPool::~vtkSlicerIGSIOBufferPool()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOBufferPool::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumPooledBytes: " << this->GetMaximumPooledBytes() << "\n";
+  os << indent << "PooledBytes: " << this->GetPooledBytes() << "\n";
+  os << indent << "ImageHits: " << this->GetNumberOfImageHits() << "\n";
+  os << indent << "ImageMisses: " << this->GetNumberOfImageMisses() << "\n";
+  os << indent << "ImageHitRate: " << this->GetImageHitRate() << "\n";
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOBufferPool* vtkSlicerIGSIOBufferPool::GetInstance()
+{
+  static vtkSmartPointer<vtkSlicerIGSIOBufferPool> instance = vtkSmartPointer<vtkSlicerIGSIOBufferPool>::New();
+  return instance;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkSlicerIGSIOBufferPool::AcquireImageData(int dimensions[3], int scalarType, int numberOfComponents)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    std::vector<vtkSmartPointer<vtkImageData> >& images = this->Internal->Images[vtkInternal::GetImageKey(dimensions, scalarType, numberOfComponents)];
+    if (!images.empty())
+    {
+      vtkSmartPointer<vtkImageData> imageData = images.back();
+      images.pop_back();
+      this->Internal->PooledBytes -= vtkInternal::GetImageSize(imageData);
+      ++this->Internal->NumberOfImageHits;
+      return imageData;
+    }
+    ++this->Internal->NumberOfImageMisses;
+  }
+
+  vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+  imageData->SetDimensions(dimensions);
+  imageData->AllocateScalars(scalarType, numberOfComponents);
+  return imageData;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOBufferPool::ReleaseImageData(vtkImageData* imageData)
+{
+  if (!imageData || imageData->GetReferenceCount() > 1)
+  {
+    // Image is still used somewhere else
+    return;
+  }
+
+  vtkDataArray* scalars = imageData->GetPointData() ? imageData->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || scalars->GetReferenceCount() > 1)
+  {
+    // Scalars are shared with another object
+    return;
+  }
+
+  int dimensions[3] = { 0, 0, 0 };
+  imageData->GetDimensions(dimensions);
+  vtkIdType imageSize = vtkInternal::GetImageSize(imageData);
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (this->Internal->PooledBytes + imageSize > this->Internal->MaximumPooledBytes)
+  {
+    return;
+  }
+  this->Internal->Images[vtkInternal::GetImageKey(dimensions, imageData->GetScalarType(), imageData->GetNumberOfScalarComponents())].push_back(imageData);
+  this->Internal->PooledBytes += imageSize;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOBufferPool::Clear()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Images.clear();
+  this->Internal->PooledBytes = 0;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOBufferPool::SetMaximumPooledBytes(vtkIdType maximumPooledBytes)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    if (this->Internal->MaximumPooledBytes == maximumPooledBytes)
+    {
+      return;
+    }
+    this->Internal->MaximumPooledBytes = maximumPooledBytes;
+  }
+  if (this->GetPooledBytes() > maximumPooledBytes)
+  {
+    this->Clear();
+  }
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOBufferPool::GetMaximumPooledBytes()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->MaximumPooledBytes;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOBufferPool::GetPooledBytes()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->PooledBytes;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOBufferPool::GetNumberOfImageHits()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfImageHits;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOBufferPool::GetNumberOfImageMisses()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfImageMisses;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOBufferPool::GetImageHitRate()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  vtkIdType total = this->Internal->NumberOfImageHits + this->Internal->NumberOfImageMisses;
+  return total > 0 ? static_cast<double>(this->Internal->NumberOfImageHits) / total : 0.0;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOBufferPool::ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->NumberOfImageHits = 0;
+  this->Internal->NumberOfImageMisses = 0;
+}
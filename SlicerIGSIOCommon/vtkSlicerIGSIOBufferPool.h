@@ -0,0 +1,94 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOBufferPool_h
+#define __vtkSlicerIGSIOBufferPool_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+/// Pool of image buffers that are reused between frames during encoding and decoding.
+///
+/// Decoded images are pooled by dimensions, scalar type and number of components, so an acquired image
+/// already has correctly sized scalars and decoding into it does not allocate memory.
+///
+/// Buffers are only returned to the pool if the caller holds the only reference to them.
+/// The total size of the pooled buffers is limited by MaximumPooledBytes; buffers that would exceed the limit are freed.
+/// All methods are thread safe.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOBufferPool : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOBufferPool* New();
+  vtkTypeMacro(vtkSlicerIGSIOBufferPool, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Pool that is shared by the encoding and decoding functions of SlicerIGSIO.
+  static vtkSlicerIGSIOBufferPool* GetInstance();
+
+  /// Get an image with allocated scalars of the specified size and type.
+  /// The contents of the image are undefined.
+  vtkSmartPointer<vtkImageData> AcquireImageData(int dimensions[3], int scalarType, int numberOfComponents);
+
+  /// Return an image to the pool. The caller must release its own reference to the image after calling this method.
+  /// The image is not pooled if it is referenced anywhere else.
+  void ReleaseImageData(vtkImageData* imageData);
+
+  /// Free all of the pooled buffers.
+  /// The encoding and decoding functions clear the shared pool when they finish, so the buffers are only kept during a job.
+  void Clear();
+
+  /// Maximum total size of the buffers that are kept in the pool. Default is 256 MB.
+  void SetMaximumPooledBytes(vtkIdType maximumPooledBytes);
+  vtkIdType GetMaximumPooledBytes();
+
+  /// Total size of the buffers that are currently kept in the pool.
+  vtkIdType GetPooledBytes();
+
+  //@{
+  /// Number of acquired images that were reused from the pool (hits) or newly allocated (misses).
+  vtkIdType GetNumberOfImageHits();
+  vtkIdType GetNumberOfImageMisses();
+  //@}
+
+  /// Ratio of acquired images that were reused from the pool. 0 if nothing has been acquired.
+  double GetImageHitRate();
+
+  /// Reset the hit and miss counters.
+  void ResetStatistics();
+
+protected:
+  vtkSlicerIGSIOBufferPool();
+  ~vtkSlicerIGSIOBufferPool() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOBufferPool(const vtkSlicerIGSIOBufferPool&); // Not implemented
+  void operator=(const vtkSlicerIGSIOBufferPool&);           // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOBufferPool_h
@@ -25,7 +25,18 @@ Care Ontario.
 #include <vtkIGSIOTransformRepository.h>
 
 // SlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOBoundedQueue.h"
+#include "vtkSlicerIGSIOBufferPool.h"
 #include "vtkSlicerIGSIOCommon.h"
+#include "vtkSlicerIGSIOEncoderState.h"
+#include "vtkSlicerIGSIOEncodingJob.h"
+#include "vtkSlicerIGSIOEncodingPlan.h"
+#include "vtkSlicerIGSIOEncodingStatistics.h"
+#include "vtkSlicerIGSIOKeyFrameIndex.h"
+#include "vtkSlicerIGSIOKeyFramePolicy.h"
+#include "vtkSlicerIGSIOPixelConversion.h"
+#include "vtkSlicerIGSIOThreadPool.h"
+#include "vtkSlicerIGSIOTransformSequence.h"
 #include "vtkStreamingVolumeCodec.h"
 
 // vtkAddon includes
@@ -44,16 +55,33 @@ Care Ontario.
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
-#include <vtkTransform.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
 
 // vtkSequenceIO includes
 #include <vtkIGSIOMkvSequenceIO.h>
 
-#include <stack>
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 std::string FRAME_STATUS_TRACKNAME = "FrameStatus";
 std::string TRACKNAME_FIELD_NAME = "TrackName";
+std::string MONOCHROME_FIELD_NAME = "Monochrome";
 enum FrameStatus
 {
   Frame_OK,
@@ -66,6 +94,9 @@ struct FrameBlock
   int StartFrame;
   int EndFrame;
   bool ReEncodingRequired;
+  // Start frames of the planned blocks that were merged into this block, after the first one.
+  // The input starts a new keyframe at each of these frames, so the block can be split there without adding keyframes.
+  std::vector<int> MergedBlockStartFrames;
   FrameBlock()
     : StartFrame(-1)
     , EndFrame(-1)
@@ -74,60 +105,520 @@ struct FrameBlock
   }
 };
 
-//----------------------------------------------------------------------------
-bool vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* sequenceNode)
+namespace
 {
-  if (!trackedFrameList || !sequenceNode)
+  // Tracked frames are prepared for insertion into a sequence in parallel, in chunks of at least this many frames.
+  const int MINIMUM_PREPARATION_CHUNK_LENGTH = 256;
+
+  // Maximum number of frames that can be waiting between the decode, pixel conversion and encode stages,
+  // if no encoding job is specified. See vtkSlicerIGSIOEncodingJob::SetPipelineQueueDepth.
+  const int DEFAULT_ENCODING_PIPELINE_QUEUE_DEPTH = 4;
+
+  // Codec that only accepts 8-bit RGB images, if no encoding job is specified.
+  // See vtkSlicerIGSIOEncodingJob::SetCodecRequiresRGBInput.
+  const std::string DEFAULT_RGB_INPUT_CODEC_FOURCC = "RV24";
+
+  // Optional pixel conversion that is applied to each image before it is encoded.
+  typedef std::function<vtkSmartPointer<vtkImageData>(vtkImageData*)> PixelConversionFunction;
+
+  //----------------------------------------------------------------------------
+  // Input for a single frame that will be encoded.
+  // The contents are collected on the calling thread so that the encoding threads don't need to access MRML nodes.
+  struct EncodingInputFrame
   {
-    vtkErrorWithObjectMacro(trackedFrameList, "Invalid arguments");
-    return false;
+    vtkSmartPointer<vtkStreamingVolumeFrame> Frame;
+    vtkSmartPointer<vtkImageData> ImageData;
+    vtkSmartPointer<vtkMatrix4x4> IJKToRASMatrix;
+    std::string IndexValue;
+  };
+
+  //----------------------------------------------------------------------------
+  // Frame that is passed between the stages of the encoding pipeline.
+  struct EncodingPipelineItem
+  {
+    size_t FrameIndex;
+    vtkSmartPointer<vtkImageData> ImageData;
+    EncodingPipelineItem()
+      : FrameIndex(0)
+    {
+    }
+  };
+
+  typedef vtkSlicerIGSIOBoundedQueue<EncodingPipelineItem> EncodingPipelineQueue;
+
+  //----------------------------------------------------------------------------
+  // Range of frames that is encoded in order by a single codec instance.
+  // Pass-through chunks are not encoded. Their existing frames are copied to the output sequence as they are.
+  struct EncodingChunk
+  {
+    vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+    std::map<std::string, vtkSmartPointer<vtkStreamingVolumeCodec> > Decoders;
+    std::vector<EncodingInputFrame> InputFrames;
+    std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > OutputFrames;
+    PixelConversionFunction ConvertImageData;
+    vtkSlicerIGSIOEncodingStatistics* Statistics;
+
+    // Keyframes that are requested from the codec by the keyframe policy. The forced keyframes are indices of the input frames,
+    // and a keyframe is also forced if the previous keyframe is at the maximum distance.
+    std::set<size_t> ForcedKeyFrames;
+    int MaximumKeyFrameDistance;
+    int KeyFrameDistance;
+
+    int PipelineQueueDepth;
+    bool PassThrough;
+    bool Completed;
+    bool Success;
+    std::string ErrorMessage;
+
+    // Queues between the decode, pixel conversion and encode stages, if the stages are run as separate tasks
+    std::unique_ptr<EncodingPipelineQueue> DecodedQueue;
+    std::unique_ptr<EncodingPipelineQueue> ConvertedQueue;
+    std::string DecodeErrorMessage;
+    std::string ConvertErrorMessage;
+    std::atomic<int> NumberOfRunningStages;
+
+    EncodingChunk()
+      : Statistics(nullptr)
+      , MaximumKeyFrameDistance(0)
+      , KeyFrameDistance(0)
+      , PipelineQueueDepth(0)
+      , PassThrough(false)
+      , Completed(false)
+      , Success(false)
+      , NumberOfRunningStages(0)
+    {
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // Data node that was stored in the output sequence before it was replaced by an encoded frame.
+  struct OutputRollbackItem
+  {
+    std::string IndexValue;
+    vtkSmartPointer<vtkMRMLNode> PreviousDataNode;
+  };
+
+  //----------------------------------------------------------------------------
+  // Adds the time since it was created to a stage of the encoding statistics. Does nothing if there are no statistics.
+  class EncodingStageTimer
+  {
+  public:
+    EncodingStageTimer(vtkSlicerIGSIOEncodingStatistics* statistics, int stage)
+      : Statistics(statistics)
+      , Stage(stage)
+      , StartTime(std::chrono::steady_clock::now())
+    {
+    }
+    ~EncodingStageTimer()
+    {
+      if (this->Statistics)
+      {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->StartTime;
+        this->Statistics->AddStageSample(this->Stage, elapsed.count());
+      }
+    }
+  private:
+    vtkSlicerIGSIOEncodingStatistics* Statistics;
+    int Stage;
+    std::chrono::steady_clock::time_point StartTime;
+  };
+
+  //----------------------------------------------------------------------------
+  // Get the dimensions of the encoded frame, or the image data if the volume is not encoded.
+  void GetVolumeNodeDimensions(vtkMRMLVolumeNode* volumeNode, int dimensions[3])
+  {
+    dimensions[0] = 0;
+    dimensions[1] = 0;
+    dimensions[2] = 0;
+
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(volumeNode);
+    if (streamingVolumeNode && streamingVolumeNode->GetFrame())
+    {
+      streamingVolumeNode->GetFrame()->GetDimensions(dimensions);
+    }
+    else if (volumeNode && volumeNode->GetImageData())
+    {
+      volumeNode->GetImageData()->GetDimensions(dimensions);
+    }
   }
 
-  std::string trackedFrameName = "Video";
-  if (!trackedFrameList->GetCustomString(TRACKNAME_FIELD_NAME).empty())
+  //----------------------------------------------------------------------------
+  // Get the item numbers of the frames in the range that must be keyframes according to the keyframe policy.
+  std::set<int> GetForcedKeyFrameItemNumbers(vtkMRMLSequenceNode* sequenceNode, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy,
+    int startIndex, int endIndex)
   {
-    trackedFrameName = trackedFrameList->GetCustomString(TRACKNAME_FIELD_NAME);
+    std::set<int> forcedKeyFrameItemNumbers;
+    if (!keyFramePolicy)
+    {
+      return forcedKeyFrameItemNumbers;
+    }
+    for (int n = 0; n < keyFramePolicy->GetNumberOfForcedKeyFrameIndexValues(); ++n)
+    {
+      int itemNumber = sequenceNode->GetItemNumberFromIndexValue(keyFramePolicy->GetNthForcedKeyFrameIndexValue(n));
+      if (itemNumber >= startIndex && itemNumber <= endIndex)
+      {
+        forcedKeyFrameItemNumbers.insert(itemNumber);
+      }
+    }
+    return forcedKeyFrameItemNumbers;
   }
 
-  sequenceNode->SetIndexName("time");
-  sequenceNode->SetIndexUnit("s");
+  //----------------------------------------------------------------------------
+  // Get the image that should be encoded for the specified input frame.
+  // If the input frame is encoded, it is decoded into a new image.
+  bool GetEncodingChunkInputImage(EncodingChunk* chunk, const EncodingInputFrame& inputFrame, vtkSmartPointer<vtkImageData>& imageData, std::string& errorMessage)
+  {
+    if (!inputFrame.Frame)
+    {
+      imageData = inputFrame.ImageData;
+    }
+    else
+    {
+      EncodingStageTimer timer(chunk->Statistics, vtkSlicerIGSIOEncodingStatistics::StageDecode);
+
+      // Decoded images are reused from the pool, so that a new image does not need to be allocated for every frame
+      int dimensions[3] = { 0, 0, 0 };
+      inputFrame.Frame->GetDimensions(dimensions);
+      imageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(dimensions,
+        inputFrame.Frame->GetVTKScalarType(), inputFrame.Frame->GetNumberOfComponents());
+      vtkStreamingVolumeCodec* decoder = chunk->Decoders[inputFrame.Frame->GetCodecFourCC()];
+      if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(decoder, inputFrame.Frame, imageData))
+      {
+        errorMessage = "Error decoding frame at index " + inputFrame.IndexValue;
+        return false;
+      }
+    }
 
-  std::string encodingFourCC;
-  trackedFrameList->GetEncodingFourCC(encodingFourCC);
-  if (!encodingFourCC.empty())
+    if (!imageData)
+    {
+      errorMessage = "No image data for frame at index " + inputFrame.IndexValue;
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ConvertEncodingChunkImage(EncodingChunk* chunk, const EncodingInputFrame& inputFrame, vtkSmartPointer<vtkImageData>& imageData, std::string& errorMessage)
   {
-    vtkSmartPointer<vtkStreamingVolumeCodec> codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
-      vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(encodingFourCC));
-    if (!codec)
+    if (!chunk->ConvertImageData)
     {
-      vtkErrorWithObjectMacro(sequenceNode, "Could not find codec: " << encodingFourCC);
+      return true;
+    }
+
+    EncodingStageTimer timer(chunk->Statistics, vtkSlicerIGSIOEncodingStatistics::StageConvert);
+    vtkSmartPointer<vtkImageData> convertedImageData = chunk->ConvertImageData(imageData);
+    if (convertedImageData != imageData)
+    {
+      // The decoded image is no longer needed, so it can be reused for the next frame
+      vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(imageData);
+    }
+    imageData = convertedImageData;
+    if (!imageData)
+    {
+      errorMessage = "Error converting pixels of frame at index " + inputFrame.IndexValue;
       return false;
     }
+    return true;
   }
 
-  vtkSmartPointer<vtkMRMLScene> mrmlScene = sequenceNode->GetScene();
+  //----------------------------------------------------------------------------
+  bool EncodeEncodingChunkImage(EncodingChunk* chunk, const EncodingInputFrame& inputFrame, vtkImageData* imageData, std::string& errorMessage)
+  {
+    EncodingStageTimer timer(chunk->Statistics, vtkSlicerIGSIOEncodingStatistics::StageEncode);
 
-  // How many digits are required to represent the frame numbers
-  int frameNumberMaxLength = std::floor(std::log10(trackedFrameList->GetNumberOfTrackedFrames())) + 1;
+    // The frames are encoded in order, so the number of output frames is the index of this frame in the chunk
+    bool forceKeyFrame = chunk->ForcedKeyFrames.count(chunk->OutputFrames.size()) > 0
+      || (chunk->MaximumKeyFrameDistance > 0 && chunk->KeyFrameDistance >= chunk->MaximumKeyFrameDistance);
+    vtkSmartPointer<vtkStreamingVolumeFrame> outputFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    if (!chunk->Codec->EncodeImageData(imageData, outputFrame, forceKeyFrame))
+    {
+      errorMessage = "Error encoding frame at index " + inputFrame.IndexValue;
+      return false;
+    }
+    chunk->KeyFrameDistance = outputFrame->IsKeyFrame() ? 1 : chunk->KeyFrameDistance + 1;
+    chunk->OutputFrames.push_back(outputFrame);
+    return true;
+  }
 
-  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  //----------------------------------------------------------------------------
+  // Decode, convert and encode each frame one after the other on the current thread.
+  void RunEncodingChunkSequential(EncodingChunk* chunk, std::atomic<bool>* abortEncoding, std::atomic<int>* numberOfFramesEncoded)
+  {
+    for (EncodingInputFrame& inputFrame : chunk->InputFrames)
+    {
+      if (*abortEncoding)
+      {
+        chunk->ErrorMessage = "Encoding aborted";
+        return;
+      }
+
+      vtkSmartPointer<vtkImageData> imageData;
+      if (!GetEncodingChunkInputImage(chunk, inputFrame, imageData, chunk->ErrorMessage)
+        || !ConvertEncodingChunkImage(chunk, inputFrame, imageData, chunk->ErrorMessage)
+        || !EncodeEncodingChunkImage(chunk, inputFrame, imageData, chunk->ErrorMessage))
+      {
+        return;
+      }
+      vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(imageData);
+      imageData = nullptr;
+      ++(*numberOfFramesEncoded);
+    }
+    chunk->Success = true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Decode stage of a pipelined chunk. The input images are passed to the next stage in order.
+  void RunEncodingChunkDecodeStage(EncodingChunk* chunk, std::atomic<bool>* abortEncoding)
+  {
+    for (size_t i = 0; i < chunk->InputFrames.size(); ++i)
+    {
+      if (*abortEncoding)
+      {
+        break;
+      }
+
+      EncodingPipelineItem item;
+      item.FrameIndex = i;
+      if (!GetEncodingChunkInputImage(chunk, chunk->InputFrames[i], item.ImageData, chunk->DecodeErrorMessage))
+      {
+        break;
+      }
+      if (!chunk->DecodedQueue->Push(item))
+      {
+        // Later stage has stopped
+        break;
+      }
+    }
+    chunk->DecodedQueue->Close();
+  }
+
+  //----------------------------------------------------------------------------
+  // Pixel conversion stage of a pipelined chunk.
+  void RunEncodingChunkConvertStage(EncodingChunk* chunk)
+  {
+    EncodingPipelineItem item;
+    while (chunk->DecodedQueue->Pop(item))
+    {
+      if (!ConvertEncodingChunkImage(chunk, chunk->InputFrames[item.FrameIndex], item.ImageData, chunk->ConvertErrorMessage)
+        || !chunk->ConvertedQueue->Push(item))
+      {
+        chunk->DecodedQueue->Abort();
+        break;
+      }
+    }
+    chunk->ConvertedQueue->Close();
+  }
+
+  //----------------------------------------------------------------------------
+  // Encode stage of a pipelined chunk. Decoding and encoding are sequential within each stage,
+  // so inter-frame codecs receive the frames in order.
+  void RunEncodingChunkEncodeStage(EncodingChunk* chunk, std::atomic<bool>* abortEncoding, std::atomic<int>* numberOfFramesEncoded)
+  {
+    EncodingPipelineQueue* encodeQueue = chunk->ConvertedQueue ? chunk->ConvertedQueue.get() : chunk->DecodedQueue.get();
+    EncodingPipelineItem item;
+    while (encodeQueue->Pop(item))
+    {
+      if (*abortEncoding)
+      {
+        chunk->ErrorMessage = "Encoding aborted";
+        break;
+      }
+      if (!EncodeEncodingChunkImage(chunk, chunk->InputFrames[item.FrameIndex], item.ImageData, chunk->ErrorMessage))
+      {
+        break;
+      }
+      vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(item.ImageData);
+      item.ImageData = nullptr;
+      ++(*numberOfFramesEncoded);
+    }
+
+    // Unblock the earlier stages if the encoder stopped before reaching the end
+    chunk->DecodedQueue->Abort();
+    if (chunk->ConvertedQueue)
+    {
+      chunk->ConvertedQueue->Abort();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Collect the result of the stages of a pipelined chunk. Called by the last stage that completes.
+  void FinishEncodingChunkPipeline(EncodingChunk* chunk)
+  {
+    if (!chunk->DecodeErrorMessage.empty())
+    {
+      chunk->ErrorMessage = chunk->DecodeErrorMessage;
+    }
+    else if (!chunk->ConvertErrorMessage.empty())
+    {
+      chunk->ErrorMessage = chunk->ConvertErrorMessage;
+    }
+    else if (chunk->ErrorMessage.empty() && chunk->OutputFrames.size() != chunk->InputFrames.size())
+    {
+      chunk->ErrorMessage = "Encoding aborted";
+    }
+    chunk->Success = chunk->ErrorMessage.empty();
+    chunk->DecodedQueue.reset();
+    chunk->ConvertedQueue.reset();
+  }
+
+  //----------------------------------------------------------------------------
+  // Submit the tasks that encode the chunk to the thread pool. The completion callback is called once by the last task of the chunk.
+  // If the pipeline is enabled and the pool has a thread for each stage, the decode, pixel conversion and encode stages are
+  // submitted as consecutive tasks that are connected by bounded queues, so encoding is limited by the slowest stage
+  // instead of the sum of all stages. The pool starts the tasks in order and tasks of other chunks never wait for this chunk,
+  // so all stages of the chunk will be running at the same time, and the queues between them cannot deadlock.
+  // Otherwise, the stages are run sequentially by a single task.
+  void SubmitEncodingChunk(vtkSlicerIGSIOThreadPool* threadPool, EncodingChunk* chunk, std::atomic<bool>* abortEncoding,
+    std::atomic<int>* numberOfFramesEncoded, std::function<void()> completeChunk)
+  {
+    int numberOfStages = chunk->ConvertImageData ? 3 : 2;
+    if (chunk->PipelineQueueDepth < 1 || numberOfStages > threadPool->GetNumberOfThreads())
+    {
+      threadPool->Submit([chunk, abortEncoding, numberOfFramesEncoded, completeChunk]()
+        {
+          RunEncodingChunkSequential(chunk, abortEncoding, numberOfFramesEncoded);
+          completeChunk();
+        });
+      return;
+    }
+
+    chunk->DecodedQueue.reset(new EncodingPipelineQueue(chunk->PipelineQueueDepth));
+    if (chunk->ConvertImageData)
+    {
+      chunk->ConvertedQueue.reset(new EncodingPipelineQueue(chunk->PipelineQueueDepth));
+    }
+    chunk->NumberOfRunningStages = numberOfStages;
+    std::function<void()> completeStage = [chunk, completeChunk]()
+      {
+        if (--chunk->NumberOfRunningStages == 0)
+        {
+          FinishEncodingChunkPipeline(chunk);
+          completeChunk();
+        }
+      };
+
+    threadPool->Submit([chunk, abortEncoding, completeStage]()
+      {
+        RunEncodingChunkDecodeStage(chunk, abortEncoding);
+        completeStage();
+      });
+    if (chunk->ConvertImageData)
+    {
+      threadPool->Submit([chunk, completeStage]()
+        {
+          RunEncodingChunkConvertStage(chunk);
+          completeStage();
+        });
+    }
+    threadPool->Submit([chunk, abortEncoding, numberOfFramesEncoded, completeStage]()
+      {
+        RunEncodingChunkEncodeStage(chunk, abortEncoding, numberOfFramesEncoded);
+        completeStage();
+      });
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the number of worker threads for the requested number. Values less than 1 use one thread per core.
+  int GetNumberOfEncodingThreadsToUse(int numberOfThreads)
+  {
+    if (numberOfThreads < 1)
+    {
+      numberOfThreads = vtkSlicerIGSIOThreadPool::GetDefaultNumberOfThreads();
+    }
+    return numberOfThreads;
+  }
+
+  //----------------------------------------------------------------------------
+  // Parse the status field of the tracked frame. Frames without a status are valid.
+  int GetTrackedFrameStatus(igsioTrackedFrame* trackedFrame)
   {
-    igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
     std::string frameStatus = trackedFrame->GetFrameField(FRAME_STATUS_TRACKNAME);
-    int frameStatusInt = vtkVariant(frameStatus.c_str()).ToInt();
-    if (frameStatusInt != FrameStatus::Frame_OK)
+    return static_cast<int>(std::strtol(frameStatus.c_str(), nullptr, 10));
+  }
+
+  //----------------------------------------------------------------------------
+  // Format the timestamp the same way as the default formatting of a stream (6 significant digits)
+  std::string FormatTimestampIndexValue(double timestamp)
+  {
+    char indexValue[32];
+    snprintf(indexValue, sizeof(indexValue), "%g", timestamp);
+    return indexValue;
+  }
+
+  //----------------------------------------------------------------------------
+  // Content of the data node of a tracked frame, prepared outside of the main thread before the data node is created
+  struct PreparedSequenceItem
+  {
+    bool Valid;
+    bool VectorVolume;
+    vtkSmartPointer<vtkImageData> ImageData;
+    vtkSmartPointer<vtkStreamingVolumeFrame> EncodedFrame;
+    vtkSmartPointer<vtkMatrix4x4> IJKToRASMatrix;
+    std::string Name;
+    std::string IndexValue;
+    PreparedSequenceItem()
+      : Valid(false)
+      , VectorVolume(false)
     {
-      continue;
     }
+  };
 
-    std::stringstream timestampSS;
-    timestampSS << trackedFrame->GetTimestamp();
+  //----------------------------------------------------------------------------
+  // Settings that are shared by all of the frames that are prepared
+  struct SequenceItemPreparation
+  {
+    igsioTransformName ImageToPhysicalTransformName;
+    std::string ImageToPhysicalFieldName;
+    int FrameNumberMaxLength;
+  };
+
+  //----------------------------------------------------------------------------
+  // Read the image, geometry and index value of a tracked frame. Does not access MRML, so it can be run on any thread.
+  void PrepareSequenceItem(igsioTrackedFrame* trackedFrame, unsigned int frameNumber, const SequenceItemPreparation& preparation,
+    PreparedSequenceItem& preparedItem)
+  {
+    if (GetTrackedFrameStatus(trackedFrame) != FrameStatus::Frame_OK)
+    {
+      return;
+    }
 
-    vtkSmartPointer<vtkMRMLVolumeNode> volumeNode;
     if (!trackedFrame->GetImageData()->IsFrameEncoded())
     {
       unsigned int numberOfScalarComponents = 0;
-      if (trackedFrame->GetNumberOfScalarComponents(numberOfScalarComponents) && numberOfScalarComponents > 1)
+      preparedItem.VectorVolume = trackedFrame->GetNumberOfScalarComponents(numberOfScalarComponents) && numberOfScalarComponents > 1;
+      preparedItem.ImageData = trackedFrame->GetImageData()->GetImage();
+    }
+    else
+    {
+      preparedItem.EncodedFrame = trackedFrame->GetImageData()->GetEncodedFrame();
+    }
+
+    if (!trackedFrame->GetFrameField(preparation.ImageToPhysicalFieldName).empty())
+    {
+      vtkSmartPointer<vtkMatrix4x4> ijkToRASTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      if (trackedFrame->GetFrameTransform(preparation.ImageToPhysicalTransformName, ijkToRASTransformMatrix) == IGSIO_SUCCESS)
+      {
+        preparedItem.IJKToRASMatrix = ijkToRASTransformMatrix;
+      }
+    }
+
+    // Generating a unique name is important because that will be used to generate the filename by default.
+    // The frame number is padded to the maximum number of digits (FrameNumberMaxLength), ex. 0, 1, 2 or 0000, 0001, 0002.
+    char volumeName[64];
+    snprintf(volumeName, sizeof(volumeName), "Image_%0*u", preparation.FrameNumberMaxLength, frameNumber);
+    preparedItem.Name = volumeName;
+    preparedItem.IndexValue = FormatTimestampIndexValue(trackedFrame->GetTimestamp());
+    preparedItem.Valid = true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Create the data node of a prepared tracked frame
+  vtkSmartPointer<vtkMRMLVolumeNode> CreatePreparedVolumeNode(const PreparedSequenceItem& preparedItem, vtkMRMLScene* mrmlScene)
+  {
+    vtkSmartPointer<vtkMRMLVolumeNode> volumeNode;
+    if (preparedItem.ImageData)
+    {
+      if (preparedItem.VectorVolume)
       {
         if (mrmlScene)
         {
@@ -150,61 +641,188 @@ bool vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrame
           volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
         }
       }
-      volumeNode->SetAndObserveImageData(trackedFrame->GetImageData()->GetImage());
+      volumeNode->SetAndObserveImageData(preparedItem.ImageData);
     }
     else
     {
       vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = nullptr;
-      if (sequenceNode->GetScene())
+      if (mrmlScene)
       {
-        streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::Take(vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetScene()->CreateNodeByClass("vtkMRMLStreamingVolumeNode")));
+        streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::Take(vtkMRMLStreamingVolumeNode::SafeDownCast(mrmlScene->CreateNodeByClass("vtkMRMLStreamingVolumeNode")));
       }
       if (!streamingVolumeNode)
       {
         streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
       }
 
-      vtkSmartPointer<vtkStreamingVolumeFrame> currentFrame = trackedFrame->GetImageData()->GetEncodedFrame();
-
       // The previous frame is only relevant if the current frame is not a keyframe
-      streamingVolumeNode->SetAndObserveFrame(currentFrame);
+      streamingVolumeNode->SetAndObserveFrame(preparedItem.EncodedFrame);
       volumeNode = streamingVolumeNode;
     }
 
-    vtkSmartPointer<vtkMatrix4x4> ijkToRASTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    igsioTransformName imageToPhysicalTransformName;
-    imageToPhysicalTransformName.SetTransformName(trackedFrameName + "ToPhysical");
-    if (!trackedFrame->GetFrameField(imageToPhysicalTransformName.GetTransformName() + "Transform").empty())
+    if (preparedItem.IJKToRASMatrix)
+    {
+      volumeNode->SetIJKToRASMatrix(preparedItem.IJKToRASMatrix);
+    }
+    volumeNode->SetName(preparedItem.Name.c_str());
+    return volumeNode;
+  }
+
+  //----------------------------------------------------------------------------
+  // Transform of a tracked frame list and the sequence node that it is added to
+  struct TransformSlot
+  {
+    igsioTransformName FrameTransformName;
+    std::string NodeNamePrefix;
+    vtkSmartPointer<vtkMRMLSequenceNode> SequenceNode;
+    vtkSmartPointer<vtkSlicerIGSIOTransformSequence> CompactTransforms;
+    int WasModifying;
+    TransformSlot()
+      : WasModifying(0)
+    {
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // Returns true if the tracked frame list contains frames that are added to the video sequence
+  bool HasValidTrackedFrames(vtkIGSIOTrackedFrameList* trackedFrameList)
+  {
+    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
     {
-      if (trackedFrame->GetFrameTransform(imageToPhysicalTransformName, ijkToRASTransformMatrix) == IGSIO_SUCCESS)
+      if (GetTrackedFrameStatus(trackedFrameList->GetTrackedFrame(i)) == FrameStatus::Frame_OK)
       {
-        if (volumeNode)
-        {
-          volumeNode->SetIJKToRASMatrix(ijkToRASTransformMatrix);
-        }
+        return true;
       }
     }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  // Fill the video sequence from the tracked frame list and add it to the browser.
+  // If the list contains no images, the video sequence is removed from the scene.
+  void AddVideoSequenceToBrowser(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* videoSequenceNode,
+    vtkMRMLSequenceBrowserNode* sequenceBrowserNode, bool consumeTrackedFrames)
+  {
+    vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, videoSequenceNode, consumeTrackedFrames);
+    if (videoSequenceNode->GetNumberOfDataNodes() < 1)
+    {
+      // No images in tracked frame list
+      sequenceBrowserNode->GetScene()->RemoveNode(videoSequenceNode);
+    }
+    else
+    {
+      sequenceBrowserNode->AddSynchronizedSequenceNode(videoSequenceNode);
+    }
+  }
+}
 
-    // Convert frame to a string with the maximum number of digits (frameNumberMaxLength)
-    // ex. 0, 1, 2, 3 or 0000, 0001, 0002, 0003 etc.
-    std::stringstream frameNumberSS;
-    frameNumberSS << std::setw(frameNumberMaxLength) << std::setfill('0') << i;
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* sequenceNode,
+  bool consumeTrackedFrames/*=false*/)
+{
+  if (!trackedFrameList || !sequenceNode)
+  {
+    vtkErrorWithObjectMacro(trackedFrameList, "Invalid arguments");
+    return false;
+  }
+
+  std::string trackedFrameName = "Video";
+  if (!trackedFrameList->GetCustomString(TRACKNAME_FIELD_NAME).empty())
+  {
+    trackedFrameName = trackedFrameList->GetCustomString(TRACKNAME_FIELD_NAME);
+  }
+
+  sequenceNode->SetIndexName("time");
+  sequenceNode->SetIndexUnit("s");
+
+  std::string encodingFourCC;
+  trackedFrameList->GetEncodingFourCC(encodingFourCC);
+  if (!encodingFourCC.empty())
+  {
+    vtkSmartPointer<vtkStreamingVolumeCodec> codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+      vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(encodingFourCC));
+    if (!codec)
+    {
+      vtkErrorWithObjectMacro(sequenceNode, "Could not find codec: " << encodingFourCC);
+      return false;
+    }
+  }
+
+  vtkSmartPointer<vtkMRMLScene> mrmlScene = sequenceNode->GetScene();
+
+  unsigned int numberOfTrackedFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  SequenceItemPreparation preparation;
+  // How many digits are required to represent the frame numbers
+  preparation.FrameNumberMaxLength = std::floor(std::log10(numberOfTrackedFrames)) + 1;
+  preparation.ImageToPhysicalTransformName.SetTransformName(trackedFrameName + "ToPhysical");
+  preparation.ImageToPhysicalFieldName = preparation.ImageToPhysicalTransformName.GetTransformName() + "Transform";
+
+  // The images, geometry and index values of the frames are read in parallel.
+  // Each task prepares a contiguous range of frames, and the tracked frame list is not modified until all tasks are complete.
+  std::vector<PreparedSequenceItem> preparedItems(numberOfTrackedFrames);
+  int numberOfThreads = GetNumberOfEncodingThreadsToUse(0);
+  int chunkLength = std::max(MINIMUM_PREPARATION_CHUNK_LENGTH, static_cast<int>((numberOfTrackedFrames + numberOfThreads - 1) / numberOfThreads));
+  int numberOfChunks = (numberOfTrackedFrames + chunkLength - 1) / chunkLength;
+  if (numberOfChunks > 1)
+  {
+    vtkSlicerIGSIOThreadPool threadPool(std::min(numberOfThreads, numberOfChunks));
+    for (unsigned int chunkStart = 0; chunkStart < numberOfTrackedFrames; chunkStart += chunkLength)
+    {
+      unsigned int chunkEnd = std::min(numberOfTrackedFrames, chunkStart + chunkLength);
+      threadPool.Submit([trackedFrameList, chunkStart, chunkEnd, &preparation, &preparedItems]()
+        {
+          for (unsigned int i = chunkStart; i < chunkEnd; ++i)
+          {
+            PrepareSequenceItem(trackedFrameList->GetTrackedFrame(i), i, preparation, preparedItems[i]);
+          }
+        });
+    }
+    threadPool.Wait();
+  }
+  else
+  {
+    for (unsigned int i = 0; i < numberOfTrackedFrames; ++i)
+    {
+      PrepareSequenceItem(trackedFrameList->GetTrackedFrame(i), i, preparation, preparedItems[i]);
+    }
+  }
 
-    // Generating a unique name is important because that will be used to generate the filename by default
-    std::ostringstream nameStr;
-    nameStr << "Image_" << frameNumberSS.str() << std::ends;
-    std::string volumeName = nameStr.str();
-    volumeNode->SetName(volumeName.c_str());
-    sequenceNode->SetDataNodeAtValue(volumeNode, timestampSS.str());
+  // The data nodes are created and inserted on the main thread with the modified events of the sequence suppressed,
+  // so that observers are only notified once instead of once per frame.
+  // The prepared item is released after its node is inserted, since the sequence keeps its own copy.
+  int wasModifying = sequenceNode->StartModify();
+  for (PreparedSequenceItem& preparedItem : preparedItems)
+  {
+    if (consumeTrackedFrames)
+    {
+      // The prepared item now holds the last reference to the image. The sequence deep copies the data node,
+      // and the original image is released below, so only the frame that is being inserted is in memory twice.
+      trackedFrameList->RemoveTrackedFrame(0);
+    }
+    if (preparedItem.Valid)
+    {
+      sequenceNode->SetDataNodeAtValue(CreatePreparedVolumeNode(preparedItem, mrmlScene), preparedItem.IndexValue);
+    }
+    preparedItem = PreparedSequenceItem();
   }
+  sequenceNode->EndModify(wasModifying);
 
   sequenceNode->SetAttribute("Sequences.Source", "Image");
 
+  // Monochrome streams are decoded as luma unless a decode mode is specified for the sequence
+  std::string monochrome = trackedFrameList->GetCustomString(MONOCHROME_FIELD_NAME);
+  std::transform(monochrome.begin(), monochrome.end(), monochrome.begin(), ::toupper);
+  if (!encodingFourCC.empty() && monochrome == "TRUE")
+  {
+    sequenceNode->SetAttribute(vtkSlicerIGSIOCommon::GetMonochromeAttributeName(), "true");
+  }
+
   return true;
 }
 
 //----------------------------------------------------------------------------
-bool vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceBrowserNode* sequenceBrowserNode)
+bool vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+  bool consumeTrackedFrames/*=false*/, bool compactTransformSequences/*=false*/)
 {
   if (!trackedFrameList || !sequenceBrowserNode)
   {
@@ -225,470 +843,2126 @@ bool vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(vtkIGSIOTrackedFram
     trackedFrameName = trackedFrameList->GetCustomString(TRACKNAME_FIELD_NAME);
   }
 
+  // The video sequence is the master sequence of the browser, so it is synchronized before the transform sequences
   std::string imagesSequenceName = vtkMRMLSequenceStorageNode::GetSequenceNodeName(trackedFrameName, "Image");
   vtkSmartPointer<vtkMRMLSequenceNode> videoSequenceNode = vtkMRMLSequenceNode::SafeDownCast(
     scene->AddNewNodeByClass("vtkMRMLSequenceNode", imagesSequenceName.c_str()));
-  vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, videoSequenceNode);
-
-  if (videoSequenceNode->GetNumberOfDataNodes() < 1)
+  if (!consumeTrackedFrames)
   {
-    // No images in tracked frame list
-    scene->RemoveNode(videoSequenceNode);
+    AddVideoSequenceToBrowser(trackedFrameList, videoSequenceNode, sequenceBrowserNode, false);
   }
-  else
+
+  // The master sequence of the browser must contain data nodes. If there is no video, the first transform is not compact.
+  bool masterSequenceAdded = HasValidTrackedFrames(trackedFrameList);
+
+  // The transforms of a file are resolved once to slots that hold the sequence nodes, so that no names are built or
+  // looked up for each frame. Tools can appear after the first frame, so the slots are created for the transforms
+  // of all frames, in the order in which they first appear.
+  std::vector<TransformSlot> transformSlots;
+  std::set<std::string> transformSlotNames;
+  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
-    sequenceBrowserNode->AddSynchronizedSequenceNode(videoSequenceNode);
-  }
+    std::vector<igsioTransformName> transformNames;
+    trackedFrameList->GetTrackedFrame(i)->GetFrameTransformNameList(transformNames);
+    for (igsioTransformName& frameTransformName : transformNames)
+    {
+      std::string transformName;
+      frameTransformName.GetTransformName(transformName);
+      if (transformName == trackedFrameName + "ToPhysical" || !transformSlotNames.insert(transformName).second)
+      {
+        continue;
+      }
 
-  std::map<std::string, vtkSmartPointer<vtkMRMLSequenceNode>> transformSequenceNodes;
+      TransformSlot transformSlot;
+      transformSlot.FrameTransformName = frameTransformName;
+      transformSlot.NodeNamePrefix = transformName + "Transform_";
+
+      std::string transformSequenceName = vtkMRMLSequenceStorageNode::GetSequenceNodeName(trackedFrameName, transformName);
+      transformSlot.SequenceNode = vtkMRMLSequenceNode::SafeDownCast(
+        scene->AddNewNodeByClass("vtkMRMLSequenceNode", transformSequenceName.c_str()));
+      transformSlot.SequenceNode->SetIndexName("time");
+      transformSlot.SequenceNode->SetIndexUnit("s");
+      // Save transform name to Sequences.Source attribute so that modules can
+      // find a transform by matching the original the transform name.
+      transformSlot.SequenceNode->SetAttribute("Sequences.Source", transformName.c_str());
+      sequenceBrowserNode->AddSynchronizedSequenceNode(transformSlot.SequenceNode);
+
+      if (compactTransformSequences && masterSequenceAdded)
+      {
+        // The sequence has no data nodes, so the proxy node is added here and set by vtkSlicerIGSIOTransformSequence
+        transformSlot.CompactTransforms = vtkSmartPointer<vtkSlicerIGSIOTransformSequence>::New();
+        transformSlot.CompactTransforms->SetTransformName(transformName);
+        transformSlot.CompactTransforms->Reserve(trackedFrameList->GetNumberOfTrackedFrames());
+        vtkSlicerIGSIOTransformSequence::SetSequenceTransforms(transformSlot.SequenceNode, transformSlot.CompactTransforms);
+
+        vtkMRMLNode* proxyNode = scene->AddNewNodeByClass("vtkMRMLLinearTransformNode", transformName.c_str());
+        sequenceBrowserNode->AddProxyNode(proxyNode, transformSlot.SequenceNode, false);
+      }
+      else
+      {
+        transformSlot.WasModifying = transformSlot.SequenceNode->StartModify();
+      }
+      masterSequenceAdded = true;
+      transformSlots.push_back(transformSlot);
+    }
+  }
 
   int frameNumberMaxLength = std::floor(std::log10(trackedFrameList->GetNumberOfTrackedFrames())) + 1;
+  vtkNew<vtkMatrix4x4> transformMatrix;
   for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
     igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
-    std::stringstream timestampSS;
-    timestampSS << trackedFrame->GetTimestamp();
+    std::string indexValue = FormatTimestampIndexValue(trackedFrame->GetTimestamp());
 
-    std::vector<igsioTransformName> transformNames;
-    trackedFrame->GetFrameTransformNameList(transformNames);
-    for (std::vector<igsioTransformName>::iterator transformNameIt = transformNames.begin(); transformNameIt != transformNames.end(); ++transformNameIt)
+    // Convert frame to a string with the a maximum number of digits (frameNumberMaxLength)
+    // ex. 0, 1, 2, 3 or 0000, 0001, 0002, 0003 etc.
+    char frameNumber[32];
+    snprintf(frameNumber, sizeof(frameNumber), "%0*u", frameNumberMaxLength, i);
+
+    for (TransformSlot& transformSlot : transformSlots)
+    {
+      if (trackedFrame->GetFrameTransform(transformSlot.FrameTransformName, transformMatrix) != IGSIO_SUCCESS)
+      {
+        continue;
+      }
+
+      if (transformSlot.CompactTransforms)
+      {
+        ToolStatus status = TOOL_INVALID;
+        trackedFrame->GetFrameTransformStatus(transformSlot.FrameTransformName, status);
+        transformSlot.CompactTransforms->AddTransform(trackedFrame->GetTimestamp(), transformMatrix, status == TOOL_OK);
+        continue;
+      }
+
+      vtkSmartPointer<vtkMRMLLinearTransformNode> transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::Take(
+        vtkMRMLLinearTransformNode::SafeDownCast(scene->CreateNodeByClass("vtkMRMLLinearTransformNode")));
+      if (!transformNode)
+      {
+        transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+      }
+      transformNode->SetMatrixTransformToParent(transformMatrix);
+
+      // Generating a unique name is important because that will be used to generate the filename by default
+      std::string transformNodeName = transformSlot.NodeNamePrefix;
+      transformNodeName += frameNumber;
+      transformNode->SetName(transformNodeName.c_str());
+      transformSlot.SequenceNode->SetDataNodeAtValue(transformNode, indexValue);
+    }
+  }
+
+  for (TransformSlot& transformSlot : transformSlots)
+  {
+    if (!transformSlot.CompactTransforms)
+    {
+      transformSlot.SequenceNode->EndModify(transformSlot.WasModifying);
+    }
+  }
+
+  if (consumeTrackedFrames)
+  {
+    // The transforms are read from the frame fields, so the tracked frames can only be consumed after all transforms are added
+    AddVideoSequenceToBrowser(trackedFrameList, videoSequenceNode, sequenceBrowserNode, true);
+    if (videoSequenceNode->GetScene())
+    {
+      sequenceBrowserNode->SetAndObserveMasterSequenceNodeID(videoSequenceNode->GetID());
+    }
+  }
+
+  vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(sequenceBrowserNode);
+
+  sequenceBrowserNode->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::VolumeSequenceToTrackedFrameList(vtkMRMLSequenceNode* sequenceNode, vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  if (!sequenceNode || !trackedFrameList)
+  {
+    vtkErrorWithObjectMacro(sequenceNode, "Invalid arguments");
+    return false;
+  }
+
+  if (sequenceNode->GetNumberOfDataNodes() < 1)
+  {
+    vtkErrorWithObjectMacro(sequenceNode, "No data nodes in sequence");
+    return false;
+  }
+
+  std::string codecFourCC;
+  bool useTimestamp = sequenceNode->GetIndexName() == "time";
+  std::string trackName = sequenceNode->GetName();
+  if (sequenceNode->GetNumberOfDataNodes() > 0)
+  {
+    trackName = sequenceNode->GetNthDataNode(0)->GetName();
+  }
+  if (trackedFrameList->SetCustomString(TRACKNAME_FIELD_NAME, trackName) == IGSIO_FAIL)
+  {
+    vtkErrorWithObjectMacro(sequenceNode, "Could not set track name!");
+    return false;
+  }
+  if (vtkSlicerIGSIOCommon::IsMonochromeSequence(sequenceNode))
+  {
+    trackedFrameList->SetCustomString(MONOCHROME_FIELD_NAME, "TRUE");
+  }
+
+
+  int dimensions[3] = { 0, 0, 0 };
+  vtkStreamingVolumeFrame* lastFrame = nullptr;
+  int lastItemNumber = -1;
+  double timestamp = 0;
+  double lastTimestamp = 0.0;
+  vtkSlicerIGSIOKeyFrameIndex* keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode);
+
+  // Values that are the same for every frame are created once
+  igsioTransformName imageToPhysicalName;
+  imageToPhysicalName.SetTransformName(trackName + "ToPhysical");
+  const std::string frameStatusOK = vtkVariant(Frame_OK).ToString();
+  const std::string frameStatusSkip = vtkVariant(Frame_Skip).ToString();
+  vtkNew<vtkMatrix4x4> ijkToRASTransform;
+
+  // Frames that must be added for the item, from the oldest to the newest. Reused for all items.
+  std::vector<vtkStreamingVolumeFrame*> frameChain;
+  for (int i = 0; i < sequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+    if (!streamingVolumeNode)
+    {
+      continue;
+    }
+
+    vtkStreamingVolumeFrame* frame = streamingVolumeNode->GetFrame();
+    if (!frame)
+    {
+      continue;
+    }
+
+    frame->GetDimensions(dimensions);
+    codecFourCC = streamingVolumeNode->GetCodecFourCC();
+
+    if (useTimestamp)
+    {
+      timestamp = std::strtod(sequenceNode->GetNthIndexValue(i).c_str(), nullptr);
+    }
+    else
+    {
+      timestamp += 0.1;
+    }
+
+    streamingVolumeNode->GetIJKToRASMatrix(ijkToRASTransform);
+
+    frameChain.clear();
+    int keyFrameItemNumber = keyFrameIndex->GetKeyFrameItemNumber(i);
+    if (keyFrameItemNumber == i || (keyFrameItemNumber >= 0 && lastItemNumber == i - 1))
+    {
+      // The frame is a keyframe, or all of the frames that it depends on are in the previous items that have been added
+      frameChain.push_back(frame);
+    }
+    else
+    {
+      vtkStreamingVolumeFrame* currentFrame = frame;
+      while (currentFrame)
+      {
+        frameChain.push_back(currentFrame);
+        if (currentFrame->IsKeyFrame())
+        {
+          // Keyframe -- We have all the info needed to decode the indexed frame.
+          break;
+        }
+
+        currentFrame = currentFrame->GetPreviousFrame();
+        if (currentFrame == lastFrame)
+        {
+          // The next frame is already processed, so we can stop here.
+          break;
+        }
+      }
+      std::reverse(frameChain.begin(), frameChain.end());
+    }
+    lastFrame = frame;
+    lastItemNumber = i;
+
+    // The tracked frames are created in place and moved into the list. The encoded frame is shared, not copied.
+    int chainLength = static_cast<int>(frameChain.size());
+    for (int chainIndex = 0; chainIndex < chainLength; ++chainIndex)
+    {
+      igsioTrackedFrame* trackedFrame = new igsioTrackedFrame();
+      trackedFrame->GetImageData()->SetEncodedFrame(frameChain[chainIndex]);
+      double currentTimestamp = lastTimestamp + (timestamp - lastTimestamp) * ((chainIndex + 1.0) / chainLength);
+      trackedFrame->SetTimestamp(currentTimestamp);
+      trackedFrame->SetFrameTransform(imageToPhysicalName, ijkToRASTransform);
+      trackedFrame->SetFrameField(FRAME_STATUS_TRACKNAME, chainIndex == chainLength - 1 ? frameStatusOK : frameStatusSkip);
+      trackedFrameList->TakeTrackedFrame(trackedFrame);
+    }
+    lastTimestamp = timestamp;
+  }
+  trackedFrameList->GetEncodingFourCC(codecFourCC);
+
+  return true;
+}
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // A synchronized sequence of a browser that is exported by reading its data nodes directly.
+  struct DirectExportSequence
+  {
+    vtkMRMLSequenceNode* SequenceNode{ nullptr };
+    vtkMRMLNode* ProxyNode{ nullptr };
+    vtkSlicerIGSIOTransformSequence* TransformSequence{ nullptr };
+    igsioTransformName TransformName;
+
+    // Transform of the current item
+    vtkSmartPointer<vtkMatrix4x4> ItemMatrix;
+    bool ItemMatrixFound{ false };
+    bool ItemMatrixValid{ false };
+
+    // Encoded frames are decoded in order, so a frame is only decoded once if the items reference consecutive frames
+    vtkSmartPointer<vtkStreamingVolumeCodec> Decoder;
+    vtkSmartPointer<vtkImageData> DecodedImageData;
+    vtkStreamingVolumeFrame* LastDecodedFrame{ nullptr };
+    bool LumaOnly{ false };
+  };
+
+  //----------------------------------------------------------------------------
+  // Decode the frame into the decoded image of the sequence. Previous frames are decoded from the last keyframe
+  // unless they were already decoded for a previous item.
+  bool DecodeDirectExportFrame(DirectExportSequence& exportSequence, vtkStreamingVolumeFrame* frame)
+  {
+    if (frame == exportSequence.LastDecodedFrame)
+    {
+      return true;
+    }
+    if (!exportSequence.Decoder)
+    {
+      exportSequence.Decoder = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+        vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(frame->GetCodecFourCC()));
+      if (!exportSequence.Decoder)
+      {
+        vtkErrorWithObjectMacro(exportSequence.SequenceNode, "Could not find codec: " << frame->GetCodecFourCC());
+        return false;
+      }
+      exportSequence.DecodedImageData = vtkSmartPointer<vtkImageData>::New();
+    }
+
+    std::vector<vtkStreamingVolumeFrame*> frameChain;
+    for (vtkStreamingVolumeFrame* currentFrame = frame; currentFrame; currentFrame = currentFrame->GetPreviousFrame())
+    {
+      frameChain.push_back(currentFrame);
+      if (currentFrame->IsKeyFrame() || currentFrame->GetPreviousFrame() == exportSequence.LastDecodedFrame)
+      {
+        break;
+      }
+    }
+
+    exportSequence.LastDecodedFrame = nullptr;
+    for (std::vector<vtkStreamingVolumeFrame*>::reverse_iterator frameIt = frameChain.rbegin(); frameIt != frameChain.rend(); ++frameIt)
     {
-      vtkSmartPointer<vtkMatrix4x4> transformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      trackedFrame->GetFrameTransform(*transformNameIt, transformMatrix);
+      if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(exportSequence.Decoder, *frameIt, exportSequence.DecodedImageData, exportSequence.LumaOnly))
+      {
+        vtkErrorWithObjectMacro(exportSequence.SequenceNode, "Could not decode frame");
+        return false;
+      }
+    }
+    exportSequence.LastDecodedFrame = frame;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Export the items of the master sequence by reading the data nodes of the synchronized sequences at the index value of each item.
+  // The selected item and the proxy nodes of the browser are not modified. The proxy nodes are only used for the transform names
+  // and the parent transforms of the images.
+  bool SequenceBrowserToTrackedFrameListDirect(vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkIGSIOTrackedFrameList* trackedFrameList)
+  {
+    vtkMRMLSequenceNode* masterSequenceNode = sequenceBrowserNode->GetMasterSequenceNode();
+    int numberOfItems = masterSequenceNode->GetNumberOfDataNodes();
+
+    std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+    sequenceBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+    std::vector<DirectExportSequence> exportSequences(sequenceNodes.size());
+    std::map<vtkMRMLNode*, DirectExportSequence*> proxyTransformSequences;
+    for (size_t sequenceIndex = 0; sequenceIndex < sequenceNodes.size(); ++sequenceIndex)
+    {
+      DirectExportSequence& exportSequence = exportSequences[sequenceIndex];
+      exportSequence.SequenceNode = sequenceNodes[sequenceIndex];
+      exportSequence.ProxyNode = sequenceBrowserNode->GetProxyNode(exportSequence.SequenceNode);
+      exportSequence.TransformSequence = vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(exportSequence.SequenceNode);
+      exportSequence.ItemMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      exportSequence.LumaOnly = vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(exportSequence.SequenceNode);
 
       std::string transformName;
-      transformNameIt->GetTransformName(transformName);
-      if (transformName != trackedFrameName + "ToPhysical")
+      const char* source = exportSequence.SequenceNode->GetAttribute("Sequences.Source");
+      if (exportSequence.ProxyNode && exportSequence.ProxyNode->GetName())
+      {
+        transformName = exportSequence.ProxyNode->GetName();
+      }
+      else if (source)
+      {
+        transformName = source;
+      }
+      else if (exportSequence.SequenceNode->GetName())
+      {
+        transformName = exportSequence.SequenceNode->GetName();
+      }
+      exportSequence.TransformName = igsioTransformName(transformName);
+
+      if (vtkMRMLTransformNode::SafeDownCast(exportSequence.ProxyNode))
+      {
+        proxyTransformSequences[exportSequence.ProxyNode] = &exportSequence;
+      }
+    }
+
+    igsioTransformName imageToWorldName("ImageToWorld");
+    vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+    vtkNew<vtkMatrix4x4> parentToWorldMatrix;
+    vtkNew<vtkMatrix4x4> transformToParentMatrix;
+    for (int i = 0; i < numberOfItems; ++i)
+    {
+      std::string indexValue = masterSequenceNode->GetNthIndexValue(i);
+
+      // Find the data node of every sequence at the item, and the transforms, which may be parents of the images
+      std::vector<vtkMRMLNode*> itemDataNodes(exportSequences.size(), nullptr);
+      for (size_t sequenceIndex = 0; sequenceIndex < exportSequences.size(); ++sequenceIndex)
       {
-        vtkSmartPointer<vtkMRMLLinearTransformNode> transformNode = nullptr;
-        if (scene)
+        DirectExportSequence& exportSequence = exportSequences[sequenceIndex];
+        exportSequence.ItemMatrixFound = false;
+        if (exportSequence.TransformSequence)
+        {
+          int transformNumber = exportSequence.TransformSequence->GetTransformNumberFromTimestamp(std::strtod(indexValue.c_str(), nullptr));
+          exportSequence.ItemMatrixFound = exportSequence.TransformSequence->GetNthTransform(transformNumber, exportSequence.ItemMatrix);
+          exportSequence.ItemMatrixValid = exportSequence.ItemMatrixFound && exportSequence.TransformSequence->GetNthTransformValid(transformNumber);
+          continue;
+        }
+
+        int itemNumber = i;
+        if (exportSequence.SequenceNode != masterSequenceNode)
         {
-          transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::Take(vtkMRMLLinearTransformNode::SafeDownCast(scene->CreateNodeByClass("vtkMRMLLinearTransformNode")));
+          // The browser shows the item with the closest index value, so streams with different timestamps are matched the same way
+          itemNumber = exportSequence.SequenceNode->GetItemNumberFromIndexValue(indexValue, false);
         }
-        if (!transformNode)
+        itemDataNodes[sequenceIndex] = itemNumber >= 0 ? exportSequence.SequenceNode->GetNthDataNode(itemNumber) : nullptr;
+
+        vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(itemDataNodes[sequenceIndex]);
+        if (transformNode)
         {
-          transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+          exportSequence.ItemMatrixFound = transformNode->GetMatrixTransformToParent(exportSequence.ItemMatrix);
+          exportSequence.ItemMatrixValid = exportSequence.ItemMatrixFound;
         }
+      }
 
-        transformNode->SetMatrixTransformToParent(transformMatrix);
+      igsioTrackedFrame* trackedFrame = new igsioTrackedFrame();
+      trackedFrame->SetTimestamp(i);
+      for (size_t sequenceIndex = 0; sequenceIndex < exportSequences.size(); ++sequenceIndex)
+      {
+        DirectExportSequence& exportSequence = exportSequences[sequenceIndex];
+        if (exportSequence.ItemMatrixFound)
+        {
+          trackedFrame->SetFrameTransform(exportSequence.TransformName, exportSequence.ItemMatrix);
+          trackedFrame->SetFrameTransformStatus(exportSequence.TransformName, exportSequence.ItemMatrixValid ? ToolStatus::TOOL_OK : ToolStatus::TOOL_INVALID);
+          continue;
+        }
 
-        // Convert frame to a string with the a maximum number of digits (frameNumberMaxLength)
-        // ex. 0, 1, 2, 3 or 0000, 0001, 0002, 0003 etc.
-        std::stringstream frameNumberSS;
-        frameNumberSS << std::setw(frameNumberMaxLength) << std::setfill('0') << i;
+        vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(itemDataNodes[sequenceIndex]);
+        if (!volumeNode)
+        {
+          continue;
+        }
 
-        // Generating a unique name is important because that will be used to generate the filename by default
-        std::ostringstream nameStr;
-        nameStr << transformName << "Transform_" << frameNumberSS.str() << std::ends;
-        std::string transformNodeName = nameStr.str();
-        transformNode->SetName(transformNodeName.c_str());
+        vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(volumeNode);
+        vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+        vtkImageData* imageData = volumeNode->GetImageData();
+        if (frame)
+        {
+          if (!DecodeDirectExportFrame(exportSequence, frame))
+          {
+            delete trackedFrame;
+            return false;
+          }
+          imageData = exportSequence.DecodedImageData;
+        }
+        trackedFrame->GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF); // TODO: save orientation and type
+        if (imageData)
+        {
+          trackedFrame->GetImageData()->DeepCopyFrom(imageData);
+        }
 
-        if (transformSequenceNodes.find(transformName) == transformSequenceNodes.end())
+        // The parent transforms of the proxy node are evaluated at the item, using the data nodes of the synchronized transform sequences
+        parentToWorldMatrix->Identity();
+        vtkMRMLTransformableNode* proxyNode = vtkMRMLTransformableNode::SafeDownCast(exportSequence.ProxyNode);
+        for (vtkMRMLTransformNode* parentTransformNode = proxyNode ? proxyNode->GetParentTransformNode() : nullptr; parentTransformNode;
+          parentTransformNode = parentTransformNode->GetParentTransformNode())
         {
-          std::string transformSequenceName = vtkMRMLSequenceStorageNode::GetSequenceNodeName(trackedFrameName, transformName);
-          vtkSmartPointer<vtkMRMLSequenceNode> transformSequenceNode = vtkMRMLSequenceNode::SafeDownCast(
-            scene->AddNewNodeByClass("vtkMRMLSequenceNode", transformSequenceName.c_str()));
-          transformSequenceNode->SetIndexName("time");
-          transformSequenceNode->SetIndexUnit("s");
-          // Save transform name to Sequences.Source attribute so that modules can
-          // find a transform by matching the original the transform name.
-          transformSequenceNode->SetAttribute("Sequences.Source", transformName.c_str());
-          sequenceBrowserNode->AddSynchronizedSequenceNode(transformSequenceNode);
-          transformSequenceNodes[transformName] = transformSequenceNode;
+          std::map<vtkMRMLNode*, DirectExportSequence*>::iterator proxyTransformIt = proxyTransformSequences.find(parentTransformNode);
+          if (proxyTransformIt != proxyTransformSequences.end())
+          {
+            if (proxyTransformIt->second->ItemMatrixFound)
+            {
+              transformToParentMatrix->DeepCopy(proxyTransformIt->second->ItemMatrix);
+            }
+            else
+            {
+              transformToParentMatrix->Identity();
+            }
+          }
+          else if (!parentTransformNode->GetMatrixTransformToParent(transformToParentMatrix))
+          {
+            transformToParentMatrix->Identity();
+          }
+          vtkMatrix4x4::Multiply4x4(transformToParentMatrix, parentToWorldMatrix, parentToWorldMatrix);
         }
-        transformSequenceNodes[transformName]->SetDataNodeAtValue(transformNode, timestampSS.str());
+
+        // ImageToWorld = ParentToWorld * IJKToRAS, the same as in the export through the proxy nodes
+        vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        volumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
+        vtkMatrix4x4::Multiply4x4(parentToWorldMatrix, ijkToRASMatrix, imageToWorldMatrix);
+        trackedFrame->SetFrameTransform(imageToWorldName, imageToWorldMatrix);
+        trackedFrame->SetFrameTransformStatus(imageToWorldName, ToolStatus::TOOL_OK); //TODO: Attribute to status
       }
+      trackedFrameList->TakeTrackedFrame(trackedFrame);
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::SequenceBrowserToTrackedFrameList(vtkMRMLSequenceBrowserNode* inputSequenceBrowserNode,
+  vtkIGSIOTrackedFrameList* outputTrackedFrameList, bool directExport)
+{
+  if (!inputSequenceBrowserNode)
+  {
+    LOG_ERROR("Invalid input sequence browser!");
+    return false;
+  }
+
+  if (!outputTrackedFrameList)
+  {
+    LOG_ERROR("Invalid output volume node!");
+    return false;
+  }
+
+
+  vtkMRMLSequenceNode* masterSequenceNode = inputSequenceBrowserNode->GetMasterSequenceNode();
+  if (!masterSequenceNode || masterSequenceNode->GetNumberOfDataNodes() <= 0 || !masterSequenceNode->GetNthDataNode(0)->IsA("vtkMRMLVolumeNode"))
+  {
+    LOG_ERROR("Invalid master sequence node!");
+    return false;
+  }
+  int numberOfDataNodes = masterSequenceNode->GetNumberOfDataNodes();
+
+  if (directExport)
+  {
+    return SequenceBrowserToTrackedFrameListDirect(inputSequenceBrowserNode, outputTrackedFrameList);
+  }
+
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  inputSequenceBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (int i = 0; i < masterSequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    igsioTrackedFrame emptyFrame;
+    outputTrackedFrameList->AddTrackedFrame(&emptyFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+  }
+
+  // Playback is paused, so that the proxy nodes contain the images of the selected item and not of a previous item
+  // that is still shown while the selected item is decoded in the background
+  bool playbackActive = inputSequenceBrowserNode->GetPlaybackActive();
+  inputSequenceBrowserNode->SetPlaybackActive(false);
+
+  int selectedItemNumber = inputSequenceBrowserNode->GetSelectedItemNumber();
+  for (int i = 0; i < numberOfDataNodes; ++i)
+  {
+    igsioTrackedFrame* trackedFrame = outputTrackedFrameList->GetTrackedFrame(i);
+    inputSequenceBrowserNode->SetSelectedItemNumber(i);
+    vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(inputSequenceBrowserNode);
+
+    for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+    {
+      vtkMRMLNode* proxyNode = inputSequenceBrowserNode->GetProxyNode(sequenceNode);
+      vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(proxyNode);
+      vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(proxyNode);
+
+      if (volumeNode)
+      {
+        trackedFrame->GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF); // TODO: save orientation and type
+        //trackedFrame->GetImageData()->SetImageType(US_IMG_RGB_COLOR);
+        trackedFrame->SetTimestamp(i);
+        trackedFrame->GetImageData()->DeepCopyFrom(volumeNode->GetImageData());
+
+        // ImageToWorld = ParentToWorld * IJKToRAS
+        vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+        volumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
+        vtkNew<vtkMatrix4x4> parentToWorldMatrix;
+        vtkMRMLTransformNode* transformNode = volumeNode->GetParentTransformNode();
+        if (transformNode)
+        {
+          transformNode->GetMatrixTransformToWorld(parentToWorldMatrix);
+        }
+
+        vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        vtkMatrix4x4::Multiply4x4(parentToWorldMatrix, ijkToRASMatrix, matrix);
+        igsioTransformName transformName("ImageToWorld");
+        trackedFrame->SetFrameTransform(transformName, matrix);
+        trackedFrame->SetFrameTransformStatus(transformName, ToolStatus::TOOL_OK); //TODO: Attribute to status
+      }
+
+      if (transformNode)
+      {
+        vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        transformNode->GetMatrixTransformToParent(matrix);
+
+        igsioTransformName transformName(transformNode->GetName());
+        trackedFrame->SetFrameTransform(transformName, matrix);
+        trackedFrame->SetFrameTransformStatus(transformName, ToolStatus::TOOL_OK); //TODO: Attribute to status
+      }
+    }
+  }
+  inputSequenceBrowserNode->SetSelectedItemNumber(selectedItemNumber);
+  vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(inputSequenceBrowserNode);
+  inputSequenceBrowserNode->SetPlaybackActive(playbackActive);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::IsMonochromeSequence(vtkMRMLSequenceNode* sequenceNode)
+{
+  const char* monochrome = sequenceNode ? sequenceNode->GetAttribute(vtkSlicerIGSIOCommon::GetMonochromeAttributeName()) : nullptr;
+  return monochrome && std::string(monochrome) == "true";
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(vtkMRMLSequenceNode* sequenceNode)
+{
+  const char* decodeMode = sequenceNode ? sequenceNode->GetAttribute(vtkSlicerIGSIOCommon::GetDecodeModeAttributeName()) : nullptr;
+  if (decodeMode)
+  {
+    return std::string(decodeMode) == "Luma";
+  }
+  return vtkSlicerIGSIOCommon::IsMonochromeSequence(sequenceNode);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(vtkStreamingVolumeCodec* decoder, vtkStreamingVolumeFrame* frame, vtkImageData* imageData,
+  bool lumaOnly)
+{
+  if (!decoder || !frame || !imageData)
+  {
+    return false;
+  }
+
+  int dimensions[3] = { 0, 0, 0 };
+  frame->GetDimensions(dimensions);
+  if (!lumaOnly || frame->GetVTKScalarType() != VTK_UNSIGNED_CHAR || frame->GetNumberOfComponents() != 3)
+  {
+    imageData->SetDimensions(dimensions);
+    imageData->AllocateScalars(frame->GetVTKScalarType(), frame->GetNumberOfComponents());
+    return decoder->DecodeFrame(frame, imageData);
+  }
+
+  // Codecs output color images, so the luma is extracted from a pooled color image
+  vtkSmartPointer<vtkImageData> rgbImageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 3);
+  bool success = decoder->DecodeFrame(frame, rgbImageData) && vtkSlicerIGSIOPixelConversion::RGBToGray(rgbImageData, imageData);
+  vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(rgbImageData);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode,
+  int startIndex, int endIndex, std::string codecFourCC, bool forceReEncoding, bool minimalReEncoding, vtkSlicerIGSIOEncodingPlan* encodingPlan,
+  vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy)
+{
+  if (!inputSequenceNode)
+  {
+    vtkErrorWithObjectMacro(inputSequenceNode, "Input is invalid vtkMRMLSequenceNode");
+    return false;
+  }
+
+  if (!encodingPlan)
+  {
+    vtkErrorWithObjectMacro(inputSequenceNode, "Invalid encoding plan");
+    return false;
+  }
+  encodingPlan->Reset();
+
+  int numberOfFrames = inputSequenceNode->GetNumberOfDataNodes();
+  if (endIndex < 0)
+  {
+    endIndex = numberOfFrames - 1;
+  }
+
+  if (startIndex < 0 || startIndex >= numberOfFrames || startIndex > endIndex
+    || endIndex >= numberOfFrames)
+  {
+    vtkErrorWithObjectMacro(inputSequenceNode, "Invalid start and end indices!");
+    return false;
+  }
+
+  if (codecFourCC == "")
+  {
+    // Keep the codec of the input sequence if possible
+    for (int i = startIndex; i <= endIndex; ++i)
+    {
+      vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+      if (inputStreamingVolumeNode)
+      {
+        codecFourCC = inputStreamingVolumeNode->GetCodecFourCC();
+        break;
+      }
+    }
+  }
+
+  if (codecFourCC == "")
+  {
+    std::vector<std::string> codecFourCCs = vtkStreamingVolumeCodecFactory::GetInstance()->GetStreamingCodecFourCCs();
+    if (codecFourCCs.empty())
+    {
+      vtkErrorWithObjectMacro(nullptr, "Re-encode failed! No codecs registered!");
+      return false;
+    }
+
+    codecFourCC = codecFourCCs.front();
+    vtkDebugWithObjectMacro(nullptr, "Streaming volume codec not specified! Using: " << codecFourCC);
+  }
+  encodingPlan->SetCodecFourCC(codecFourCC);
+
+  int blockStartFrame = startIndex;
+  int blockReEncodingReasons = vtkSlicerIGSIOEncodingPlan::ReEncodingReasonNone;
+  bool blockNewSegment = false;
+  int previousDimensions[3] = { 0, 0, 0 };
+  vtkStreamingVolumeFrame* previousFrame = nullptr;
+  int maximumKeyFrameDistance = keyFramePolicy ? keyFramePolicy->GetEffectiveMaximumKeyFrameDistance() : 0;
+  std::set<int> forcedKeyFrameItemNumbers = GetForcedKeyFrameItemNumbers(inputSequenceNode, keyFramePolicy, startIndex, endIndex);
+  vtkSlicerIGSIOKeyFrameIndex* keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(inputSequenceNode);
+  int keyFrameDistance = 0;
+  for (int i = startIndex; i <= endIndex; ++i)
+  {
+    // TODO: for now, only support sequences of vtkMRMLStreamingVolumeNode
+    // In the future, this could be changed to allow all types of volume nodes to be encoded
+    vtkMRMLVolumeNode* inputVolumeNode = vtkMRMLVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+    if (!inputVolumeNode)
+    {
+      vtkErrorWithObjectMacro(inputSequenceNode, "Invalid data node at index " << i);
+      return false;
+    }
+
+    vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputVolumeNode);
+    vtkStreamingVolumeFrame* currentFrame = inputStreamingVolumeNode ? inputStreamingVolumeNode->GetFrame() : nullptr;
+
+    int currentDimensions[3] = { 0, 0, 0 };
+    GetVolumeNodeDimensions(inputVolumeNode, currentDimensions);
+    bool dimensionsChanged = i != startIndex &&
+      (currentDimensions[0] != previousDimensions[0]
+      || currentDimensions[1] != previousDimensions[1]
+      || currentDimensions[2] != previousDimensions[2]);
+
+    bool keyFrameStart = currentFrame && // Current frame exists
+      previousFrame && // Current frame is not the initial frame
+      currentFrame->IsKeyFrame() && // Current frame is a keyframe
+      !previousFrame->IsKeyFrame(); // Previous frame was not also a keyframe
+
+    if (keyFrameStart || dimensionsChanged)
+    {
+      encodingPlan->AddFrameBlock(blockStartFrame, i - 1, blockReEncodingReasons, blockNewSegment);
+      blockStartFrame = i;
+      blockReEncodingReasons = vtkSlicerIGSIOEncodingPlan::ReEncodingReasonNone;
+      // Frames with different dimensions are encoded as a separate segment, so only this block is affected by the change
+      blockNewSegment = dimensionsChanged;
+    }
+    if (dimensionsChanged && currentFrame && !currentFrame->IsKeyFrame())
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonDimensionChange;
+    }
+    previousDimensions[0] = currentDimensions[0];
+    previousDimensions[1] = currentDimensions[1];
+    previousDimensions[2] = currentDimensions[2];
+
+    if (forceReEncoding)
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonForced;
+    }
+
+    if (!currentFrame)
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonMissingFrame;
+    }
+    else
+    {
+      if (i == startIndex && !currentFrame->IsKeyFrame())
+      {
+        blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonNonKeyFrameStart;
+      }
+      if (codecFourCC != inputStreamingVolumeNode->GetCodecFourCC())
+      {
+        blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonCodecMismatch;
+      }
+      if (!minimalReEncoding && i != startIndex && !currentFrame->IsKeyFrame() && previousFrame != currentFrame->GetPreviousFrame())
+      {
+        blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonBrokenPreviousFrameChain;
+      }
+      if (!currentFrame->IsKeyFrame() && forcedKeyFrameItemNumbers.count(i) > 0)
+      {
+        blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonForcedKeyFrame;
+      }
+    }
+
+    // Number of frames from the last keyframe, including the current frame
+    keyFrameDistance = (currentFrame && currentFrame->IsKeyFrame()) ? 1 : keyFrameDistance + 1;
+    if (maximumKeyFrameDistance > 0 && keyFrameDistance > maximumKeyFrameDistance)
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonKeyFrameDistance;
+    }
+    previousFrame = currentFrame;
+
+    if (!currentFrame)
+    {
+      continue;
+    }
+
+    // The following items that continue the previous frame chain are inter frames of the same stream, so they have the same
+    // codec and dimensions and do not start a new block. They are skipped using the keyframe index, and only checked against
+    // the keyframe policy.
+    int chainRunEndFrame = std::min(keyFrameIndex->GetLastChainRunItemNumber(i), endIndex);
+    if (chainRunEndFrame <= i)
+    {
+      continue;
+    }
+    keyFrameDistance += chainRunEndFrame - i;
+    if (maximumKeyFrameDistance > 0 && keyFrameDistance > maximumKeyFrameDistance)
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonKeyFrameDistance;
+    }
+    std::set<int>::iterator forcedKeyFrameIt = forcedKeyFrameItemNumbers.upper_bound(i);
+    if (forcedKeyFrameIt != forcedKeyFrameItemNumbers.end() && *forcedKeyFrameIt <= chainRunEndFrame)
+    {
+      blockReEncodingReasons |= vtkSlicerIGSIOEncodingPlan::ReEncodingReasonForcedKeyFrame;
+    }
+    vtkMRMLStreamingVolumeNode* chainRunEndStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(chainRunEndFrame));
+    previousFrame = chainRunEndStreamingVolumeNode->GetFrame();
+    i = chainRunEndFrame;
+  }
+  encodingPlan->AddFrameBlock(blockStartFrame, endIndex, blockReEncodingReasons, blockNewSegment);
+
+  int estimatedNumberOfDecodes = 0;
+  int estimatedNumberOfEncodes = 0;
+  int numberOfPassThroughFrames = 0;
+  bool passThroughRequired = inputSequenceNode != outputSequenceNode;
+  for (int blockIndex = 0; blockIndex < encodingPlan->GetNumberOfFrameBlocks(); ++blockIndex)
+  {
+    int numberOfBlockFrames = encodingPlan->GetFrameBlockNumberOfFrames(blockIndex);
+    if (!encodingPlan->GetFrameBlockReEncodingRequired(blockIndex))
+    {
+      if (passThroughRequired)
+      {
+        numberOfPassThroughFrames += numberOfBlockFrames;
+      }
+      continue;
+    }
+
+    estimatedNumberOfEncodes += numberOfBlockFrames;
+    for (int i = encodingPlan->GetFrameBlockStartIndex(blockIndex); i <= encodingPlan->GetFrameBlockEndIndex(blockIndex); ++i)
+    {
+      vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+      if (inputStreamingVolumeNode && inputStreamingVolumeNode->GetFrame())
+      {
+        ++estimatedNumberOfDecodes;
+      }
+    }
+
+    // If the block starts with an inter-frame, the preceding frames must be decoded first
+    int blockStartChainLength = keyFrameIndex->GetChainLength(encodingPlan->GetFrameBlockStartIndex(blockIndex));
+    estimatedNumberOfDecodes += std::max(0, blockStartChainLength - 1);
+  }
+  encodingPlan->SetEstimatedNumberOfDecodes(estimatedNumberOfDecodes);
+  encodingPlan->SetEstimatedNumberOfEncodes(estimatedNumberOfEncodes);
+  encodingPlan->SetNumberOfPassThroughFrames(numberOfPassThroughFrames);
+  return true;
+}
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Encoding of a single sequence. The chunks of several sequences can be encoded by the same worker threads.
+  struct SequenceEncoding
+  {
+    vtkMRMLSequenceNode* InputSequenceNode;
+    vtkMRMLSequenceNode* OutputSequenceNode;
+    std::string CodecFourCC;
+    std::vector<FrameBlock> FrameBlocks;
+    int NumberOfFramesToEncode;
+    std::vector<std::unique_ptr<EncodingChunk> > Chunks;
+
+    // Keyframe policy. The keyframes are forced by the codec of the chunk that contains the frame.
+    int MaximumKeyFrameDistance;
+    std::set<int> ForcedKeyFrames;
+
+    // Window and level that map the 16-bit frames of the sequence to 8 bits. The window is 0 if no mapping is needed.
+    double EncodingWindow;
+    double EncodingLevel;
+
+    // True if all frames of the output sequence will be from a monochrome stream
+    bool Monochrome;
+
+    // Previous contents of the output sequence, used to undo the changes if the encoding is cancelled
+    std::vector<OutputRollbackItem> RollbackItems;
+    bool OriginalCheckpointExists;
+    std::string OriginalCheckpointIndexValue;
+
+    SequenceEncoding()
+      : InputSequenceNode(nullptr)
+      , OutputSequenceNode(nullptr)
+      , NumberOfFramesToEncode(0)
+      , MaximumKeyFrameDistance(0)
+      , EncodingWindow(0.0)
+      , EncodingLevel(0.0)
+      , Monochrome(false)
+      , OriginalCheckpointExists(false)
+    {
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // Returns true if the output sequence will only contain monochrome frames after the range is encoded:
+  // the uncompressed input frames are single component images, the encoded input frames are from a monochrome stream,
+  // and the output frames outside of the range are from a monochrome stream.
+  bool IsMonochromeEncodingOutput(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode, int startIndex, int endIndex)
+  {
+    bool inputMonochrome = vtkSlicerIGSIOCommon::IsMonochromeSequence(inputSequenceNode);
+    for (int i = startIndex; i <= endIndex; ++i)
+    {
+      vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(volumeNode);
+      if (streamingVolumeNode && streamingVolumeNode->GetFrame())
+      {
+        if (!inputMonochrome)
+        {
+          return false;
+        }
+        continue;
+      }
+      if (!volumeNode || !volumeNode->GetImageData() || volumeNode->GetImageData()->GetNumberOfScalarComponents() != 1)
+      {
+        return false;
+      }
+    }
+    return outputSequenceNode->GetNumberOfDataNodes() <= endIndex - startIndex + 1
+      || vtkSlicerIGSIOCommon::IsMonochromeSequence(outputSequenceNode);
+  }
+
+  //----------------------------------------------------------------------------
+  // Find the frame blocks that need to be encoded. Must be called on the main thread.
+  bool PlanSequenceEncoding(SequenceEncoding* sequenceEncoding, int startIndex, int endIndex, std::string codecFourCC,
+    bool forceReEncoding, bool minimalReEncoding, vtkSlicerIGSIOEncodingJob* encodingJob, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy)
+  {
+    vtkMRMLSequenceNode* inputSequenceNode = sequenceEncoding->InputSequenceNode;
+    vtkMRMLSequenceNode* outputSequenceNode = sequenceEncoding->OutputSequenceNode;
+    if (!inputSequenceNode)
+    {
+      vtkErrorWithObjectMacro(inputSequenceNode, "Input is invalid vtkMRMLSequenceNode");
+      return false;
+    }
+
+    if (!outputSequenceNode)
+    {
+      vtkErrorWithObjectMacro(outputSequenceNode, "Output is invalid vtkMRMLSequenceNode");
+      return false;
+    }
+
+    int numberOfFrames = inputSequenceNode->GetNumberOfDataNodes();
+    if (endIndex < 0)
+    {
+      endIndex = numberOfFrames - 1;
+    }
+
+    if (startIndex < 0 || startIndex >= numberOfFrames || startIndex > endIndex
+      || endIndex >= numberOfFrames)
+    {
+      vtkErrorWithObjectMacro(inputSequenceNode, "Invalid start and end indices!");
+      return false;
+    }
+    sequenceEncoding->Monochrome = IsMonochromeEncodingOutput(inputSequenceNode, outputSequenceNode, startIndex, endIndex);
+
+    const char* originalCheckpoint = outputSequenceNode->GetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+    sequenceEncoding->OriginalCheckpointExists = originalCheckpoint != nullptr;
+    sequenceEncoding->OriginalCheckpointIndexValue = originalCheckpoint ? originalCheckpoint : "";
+
+    if (encodingJob && encodingJob->GetResumeFromCheckpoint())
+    {
+      // Skip the frames that were completed by a previous call
+      const char* checkpointIndexValue = outputSequenceNode->GetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+      int checkpointFrame = checkpointIndexValue ? inputSequenceNode->GetItemNumberFromIndexValue(checkpointIndexValue) : -1;
+      if (checkpointFrame >= startIndex && checkpointFrame <= endIndex)
+      {
+        encodingJob->SetCheckpointIndexValue(checkpointIndexValue);
+        if (checkpointFrame == endIndex)
+        {
+          // Everything has already been encoded
+          return true;
+        }
+        startIndex = checkpointFrame + 1;
+      }
+    }
+
+    vtkNew<vtkSlicerIGSIOEncodingPlan> encodingPlan;
+    if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(inputSequenceNode, outputSequenceNode, startIndex, endIndex,
+      codecFourCC, forceReEncoding, minimalReEncoding, encodingPlan, keyFramePolicy))
+    {
+      return false;
+    }
+
+    if (keyFramePolicy)
+    {
+      sequenceEncoding->MaximumKeyFrameDistance = keyFramePolicy->GetEffectiveMaximumKeyFrameDistance();
+      sequenceEncoding->ForcedKeyFrames = GetForcedKeyFrameItemNumbers(inputSequenceNode, keyFramePolicy, startIndex, endIndex);
+    }
+    sequenceEncoding->CodecFourCC = encodingPlan->GetCodecFourCC();
+    sequenceEncoding->NumberOfFramesToEncode = encodingPlan->GetNumberOfFramesToEncode();
+
+    // Adjacent blocks that are handled the same way are merged, so that consecutive re-encoded blocks can share a codec instance.
+    // Blocks that start a new segment with different frame dimensions are always encoded by a new codec instance.
+    for (int i = 0; i < encodingPlan->GetNumberOfFrameBlocks(); ++i)
+    {
+      bool reEncodingRequired = encodingPlan->GetFrameBlockReEncodingRequired(i);
+      if (!sequenceEncoding->FrameBlocks.empty() && sequenceEncoding->FrameBlocks.back().ReEncodingRequired == reEncodingRequired
+        && !encodingPlan->GetFrameBlockStartsNewSegment(i))
+      {
+        sequenceEncoding->FrameBlocks.back().EndFrame = encodingPlan->GetFrameBlockEndIndex(i);
+        sequenceEncoding->FrameBlocks.back().MergedBlockStartFrames.push_back(encodingPlan->GetFrameBlockStartIndex(i));
+        continue;
+      }
+
+      FrameBlock frameBlock;
+      frameBlock.StartFrame = encodingPlan->GetFrameBlockStartIndex(i);
+      frameBlock.EndFrame = encodingPlan->GetFrameBlockEndIndex(i);
+      frameBlock.ReEncodingRequired = reEncodingRequired;
+      sequenceEncoding->FrameBlocks.push_back(frameBlock);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the IJK to RAS matrix of the volume. The volume geometry rarely changes within a sequence,
+  // so if the matrix is the same as the previous one, the previous matrix object is shared instead of allocating a new one.
+  vtkSmartPointer<vtkMatrix4x4> GetSharedIJKToRASMatrix(vtkMRMLVolumeNode* volumeNode, vtkSmartPointer<vtkMatrix4x4>& previousMatrix)
+  {
+    vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+    volumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
+    if (previousMatrix)
+    {
+      bool equal = true;
+      for (int i = 0; i < 4 && equal; ++i)
+      {
+        for (int j = 0; j < 4 && equal; ++j)
+        {
+          equal = ijkToRASMatrix->GetElement(i, j) == previousMatrix->GetElement(i, j);
+        }
+      }
+      if (equal)
+      {
+        return previousMatrix;
+      }
+    }
+    previousMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    previousMatrix->DeepCopy(ijkToRASMatrix);
+    return previousMatrix;
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns true if the codec only accepts 8-bit RGB images. If no encoding job is specified, only the default codec requires RGB input.
+  bool IsRGBInputRequired(const std::string& codecFourCC, vtkSlicerIGSIOEncodingJob* encodingJob)
+  {
+    if (encodingJob)
+    {
+      return encodingJob->GetCodecRequiresRGBInput(codecFourCC);
+    }
+    return codecFourCC == DEFAULT_RGB_INPUT_CODEC_FOURCC;
+  }
+
+  //----------------------------------------------------------------------------
+  // Create the pixel conversion that expands single component 8-bit and 16-bit images to 8-bit RGB before encoding,
+  // for codecs that only accept RGB images. Other images are passed to the codec unchanged.
+  PixelConversionFunction CreateRGBPixelConversion(double window, double level)
+  {
+    return [window, level](vtkImageData* imageData) -> vtkSmartPointer<vtkImageData>
+      {
+        if (!vtkSlicerIGSIOPixelConversion::IsConversionToRGBRequired(imageData->GetScalarType(), imageData->GetNumberOfScalarComponents()))
+        {
+          return imageData;
+        }
+
+        int dimensions[3] = { 0, 0, 0 };
+        imageData->GetDimensions(dimensions);
+        vtkSmartPointer<vtkImageData> rgbImageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 3);
+        if (!vtkSlicerIGSIOPixelConversion::ConvertToRGB(imageData, rgbImageData, window, level))
+        {
+          return nullptr;
+        }
+        return rgbImageData;
+      };
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsWindowLevelRequired(int scalarType, int numberOfComponents)
+  {
+    return numberOfComponents == 1 && (scalarType == VTK_UNSIGNED_SHORT || scalarType == VTK_SHORT);
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the window and level that map the 16-bit frames of the sequence to 8 bits, starting from the specified item.
+  // If no encoding window is set in the encoding job, the combined scalar range of the uncompressed 16-bit frames is used,
+  // so that the same value is mapped to the same gray level in every frame. The window is 0 if there are no 16-bit frames.
+  // Returns false if the window is needed for frames that are already encoded, since their range is not known without decoding.
+  bool GetSequenceEncodingWindowLevel(vtkMRMLSequenceNode* sequenceNode, int startItemNumber, vtkSlicerIGSIOEncodingJob* encodingJob,
+    double& window, double& level)
+  {
+    window = encodingJob ? encodingJob->GetEncodingWindow() : 0.0;
+    level = encodingJob ? encodingJob->GetEncodingLevel() : 0.0;
+    if (window > 0.0)
+    {
+      return true;
+    }
+
+    double range[2] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+    for (int i = startItemNumber; i < sequenceNode->GetNumberOfDataNodes(); ++i)
+    {
+      vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(volumeNode);
+      vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+      if (frame)
+      {
+        if (IsWindowLevelRequired(frame->GetVTKScalarType(), frame->GetNumberOfComponents()))
+        {
+          vtkErrorWithObjectMacro(sequenceNode, "The encoding window and level must be set to re-encode the 16-bit frame at index " << i);
+          return false;
+        }
+        continue;
+      }
+
+      vtkImageData* imageData = volumeNode ? volumeNode->GetImageData() : nullptr;
+      if (!imageData || !IsWindowLevelRequired(imageData->GetScalarType(), imageData->GetNumberOfScalarComponents()))
+      {
+        continue;
+      }
+      double frameRange[2] = { 0.0, 0.0 };
+      imageData->GetScalarRange(frameRange);
+      range[0] = std::min(range[0], frameRange[0]);
+      range[1] = std::max(range[1], frameRange[1]);
+    }
+
+    if (range[0] <= range[1])
+    {
+      window = std::max(range[1] - range[0], 1.0);
+      level = (range[0] + range[1]) / 2.0;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the first and last frame of each chunk that the re-encoded block is split into.
+  // Every chunk is encoded by a new codec instance and starts with a keyframe, so the block is only split where the input
+  // already starts a new keyframe block, once the chunk has reached the chunk length.
+  // Keyframes of the keyframe policy are forced within the chunk, so they do not split it.
+  std::vector<std::pair<int, int> > GetEncodingChunkRanges(const FrameBlock& frameBlock, int chunkLength)
+  {
+    std::vector<std::pair<int, int> > chunkRanges;
+    int chunkStartFrame = frameBlock.StartFrame;
+    std::vector<int>::const_iterator blockStartFrameIt = frameBlock.MergedBlockStartFrames.begin();
+    for (int i = frameBlock.StartFrame + 1; i <= frameBlock.EndFrame; ++i)
+    {
+      bool blockStart = blockStartFrameIt != frameBlock.MergedBlockStartFrames.end() && *blockStartFrameIt == i;
+      if (blockStart)
+      {
+        ++blockStartFrameIt;
+      }
+      if (blockStart && i - chunkStartFrame >= chunkLength)
+      {
+        chunkRanges.push_back(std::make_pair(chunkStartFrame, i - 1));
+        chunkStartFrame = i;
+      }
+    }
+    chunkRanges.push_back(std::make_pair(chunkStartFrame, frameBlock.EndFrame));
+    return chunkRanges;
+  }
+
+  //----------------------------------------------------------------------------
+  // Split the blocks that need to be re-encoded into chunks at the planned block boundaries, so that there is work for each of the threads.
+  // If the output is a different sequence, the blocks that don't need to be re-encoded are added as pass-through chunks.
+  // Must be called on the main thread.
+  bool CreateEncodingChunks(SequenceEncoding* sequenceEncoding, int chunkLength, std::map<std::string, std::string> codecParameters,
+    vtkSlicerIGSIOEncodingJob* encodingJob)
+  {
+    int pipelineQueueDepth = encodingJob ? encodingJob->GetPipelineQueueDepth() : DEFAULT_ENCODING_PIPELINE_QUEUE_DEPTH;
+    vtkMRMLSequenceNode* inputSequenceNode = sequenceEncoding->InputSequenceNode;
+    std::string codecFourCC = sequenceEncoding->CodecFourCC;
+    bool passThroughRequired = sequenceEncoding->InputSequenceNode != sequenceEncoding->OutputSequenceNode;
+    bool rgbInputRequired = IsRGBInputRequired(codecFourCC, encodingJob);
+    double& window = sequenceEncoding->EncodingWindow;
+    double& level = sequenceEncoding->EncodingLevel;
+    vtkSmartPointer<vtkMatrix4x4> previousIJKToRASMatrix;
+    for (const FrameBlock& frameBlock : sequenceEncoding->FrameBlocks)
+    {
+      if (!frameBlock.ReEncodingRequired)
+      {
+        if (passThroughRequired)
+        {
+          // Share the existing frames with the output sequence. The frames keep their references to the previous frames,
+          // so the frames can be decoded from the output sequence without any decoding or encoding here.
+          std::unique_ptr<EncodingChunk> passThroughChunk(new EncodingChunk());
+          passThroughChunk->PassThrough = true;
+          for (int i = frameBlock.StartFrame; i <= frameBlock.EndFrame; ++i)
+          {
+            vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+            if (!inputStreamingVolumeNode || !inputStreamingVolumeNode->GetFrame())
+            {
+              vtkErrorWithObjectMacro(inputSequenceNode, "Invalid streaming volume frame at index " << i);
+              return false;
+            }
+
+            EncodingInputFrame inputFrame;
+            inputFrame.IndexValue = inputSequenceNode->GetNthIndexValue(i);
+            inputFrame.IJKToRASMatrix = GetSharedIJKToRASMatrix(inputStreamingVolumeNode, previousIJKToRASMatrix);
+            inputFrame.Frame = inputStreamingVolumeNode->GetFrame();
+            passThroughChunk->InputFrames.push_back(inputFrame);
+            passThroughChunk->OutputFrames.push_back(inputFrame.Frame);
+          }
+          passThroughChunk->Completed = true;
+          passThroughChunk->Success = true;
+          sequenceEncoding->Chunks.push_back(std::move(passThroughChunk));
+        }
+        continue;
+      }
+
+      std::vector<std::pair<int, int> > chunkRanges = GetEncodingChunkRanges(frameBlock, chunkLength);
+      for (const std::pair<int, int>& chunkRange : chunkRanges)
+      {
+        int chunkStartFrame = chunkRange.first;
+        int chunkEndFrame = chunkRange.second;
+
+        std::unique_ptr<EncodingChunk> encodingChunk(new EncodingChunk());
+        encodingChunk->Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+          vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
+        if (!encodingChunk->Codec)
+        {
+          vtkErrorWithObjectMacro(nullptr, "Could not find codec: " << codecFourCC);
+          return false;
+        }
+        encodingChunk->Codec->SetParameters(codecParameters);
+        encodingChunk->PipelineQueueDepth = pipelineQueueDepth;
+        encodingChunk->MaximumKeyFrameDistance = sequenceEncoding->MaximumKeyFrameDistance;
+        bool pixelConversionRequired = false;
+        bool windowLevelRequired = false;
+
+        for (int i = chunkStartFrame; i <= chunkEndFrame; ++i)
+        {
+          vtkMRMLVolumeNode* inputVolumeNode = vtkMRMLVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
+          if (!inputVolumeNode)
+          {
+            vtkErrorWithObjectMacro(inputSequenceNode, "Invalid data node at index " << i);
+            return false;
+          }
+
+          EncodingInputFrame inputFrame;
+          inputFrame.IndexValue = inputSequenceNode->GetNthIndexValue(i);
+          inputFrame.IJKToRASMatrix = GetSharedIJKToRASMatrix(inputVolumeNode, previousIJKToRASMatrix);
+
+          vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputVolumeNode);
+          if (inputStreamingVolumeNode && inputStreamingVolumeNode->GetFrame())
+          {
+            inputFrame.Frame = inputStreamingVolumeNode->GetFrame();
+            std::string inputCodecFourCC = inputFrame.Frame->GetCodecFourCC();
+            if (encodingChunk->Decoders.find(inputCodecFourCC) == encodingChunk->Decoders.end())
+            {
+              // Decoders are created here, since the codec factory should only be accessed from the main thread
+              vtkSmartPointer<vtkStreamingVolumeCodec> decoder = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+                vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(inputCodecFourCC));
+              if (!decoder)
+              {
+                vtkErrorWithObjectMacro(inputSequenceNode, "Could not find codec to decode frame at index " << i << ": " << inputCodecFourCC);
+                return false;
+              }
+              encodingChunk->Decoders[inputCodecFourCC] = decoder;
+            }
+          }
+          else
+          {
+            inputFrame.ImageData = inputVolumeNode->GetImageData();
+          }
+
+          int scalarType = VTK_VOID;
+          int numberOfComponents = 0;
+          if (inputFrame.Frame)
+          {
+            scalarType = inputFrame.Frame->GetVTKScalarType();
+            numberOfComponents = inputFrame.Frame->GetNumberOfComponents();
+          }
+          else if (inputFrame.ImageData)
+          {
+            scalarType = inputFrame.ImageData->GetScalarType();
+            numberOfComponents = inputFrame.ImageData->GetNumberOfScalarComponents();
+          }
+          if (rgbInputRequired)
+          {
+            pixelConversionRequired |= vtkSlicerIGSIOPixelConversion::IsConversionToRGBRequired(scalarType, numberOfComponents);
+            windowLevelRequired |= IsWindowLevelRequired(scalarType, numberOfComponents);
+          }
+
+          if (sequenceEncoding->ForcedKeyFrames.count(i) > 0)
+          {
+            encodingChunk->ForcedKeyFrames.insert(encodingChunk->InputFrames.size());
+          }
+          encodingChunk->InputFrames.push_back(inputFrame);
+        }
+
+        if (windowLevelRequired && window <= 0.0)
+        {
+          // The same window is used for all chunks of the sequence
+          if (!GetSequenceEncodingWindowLevel(inputSequenceNode, 0, encodingJob, window, level))
+          {
+            return false;
+          }
+        }
+        if (pixelConversionRequired)
+        {
+          encodingChunk->ConvertImageData = CreateRGBPixelConversion(window, level);
+        }
+        sequenceEncoding->Chunks.push_back(std::move(encodingChunk));
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void ReportEncodingProgress(vtkCallbackCommand* progressCallback, double progress)
+  {
+    if (progressCallback)
+    {
+      progressCallback->Execute(nullptr, vtkCommand::ProgressEvent, (void*)&progress);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Size of the input of a frame in bytes: the encoded size for encoded frames, or the size of the uncompressed image.
+  int GetEncodingInputFrameBytes(const EncodingInputFrame& inputFrame)
+  {
+    if (inputFrame.Frame && inputFrame.Frame->GetFrameData())
+    {
+      return static_cast<int>(inputFrame.Frame->GetFrameData()->GetNumberOfValues());
+    }
+    if (inputFrame.ImageData && inputFrame.ImageData->GetPointData()->GetScalars())
+    {
+      vtkDataArray* scalars = inputFrame.ImageData->GetPointData()->GetScalars();
+      return static_cast<int>(scalars->GetNumberOfValues() * scalars->GetDataTypeSize());
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  // Encode the chunks of all sequences using a shared pool of worker threads, and add the results to the output sequences.
+  // The output sequences are modified on the calling thread, one chunk at a time in the original order.
+  bool RunSequenceEncodings(std::vector<SequenceEncoding*>& sequenceEncodings, int numberOfThreads,
+    vtkCallbackCommand* progressCallback, vtkSlicerIGSIOEncodingJob* encodingJob, vtkSlicerIGSIOEncodingStatistics* statistics)
+  {
+    int numberOfFramesToEncode = 0;
+    int numberOfChunksToEncode = 0;
+    for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+    {
+      numberOfFramesToEncode += sequenceEncoding->NumberOfFramesToEncode;
+      for (std::unique_ptr<EncodingChunk>& chunk : sequenceEncoding->Chunks)
+      {
+        chunk->Statistics = statistics;
+        if (!chunk->PassThrough)
+        {
+          ++numberOfChunksToEncode;
+        }
+      }
+    }
+
+    std::atomic<bool> abortEncoding(false);
+    std::atomic<int> numberOfFramesEncoded(0);
+    std::mutex chunkMutex;
+    std::condition_variable chunkCompleted;
+
+    // Each chunk uses at most one thread per pipeline stage
+    vtkSlicerIGSIOThreadPool threadPool(std::max(1, std::min(numberOfThreads, 3 * numberOfChunksToEncode)));
+    for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+    {
+      for (std::unique_ptr<EncodingChunk>& chunk : sequenceEncoding->Chunks)
+      {
+        if (chunk->PassThrough)
+        {
+          continue;
+        }
+        EncodingChunk* currentChunk = chunk.get();
+        SubmitEncodingChunk(&threadPool, currentChunk, &abortEncoding, &numberOfFramesEncoded,
+          [currentChunk, &chunkMutex, &chunkCompleted]()
+          {
+            {
+              std::lock_guard<std::mutex> lock(chunkMutex);
+              currentChunk->Completed = true;
+            }
+            chunkCompleted.notify_all();
+          });
+      }
+    }
+
+    bool success = true;
+    bool cancelled = false;
+    bool rollbackEnabled = encodingJob && encodingJob->GetRollbackOnCancel();
+
+    // The data node is copied into the sequence, so the same temporary node can be used for all frames
+    vtkNew<vtkMRMLStreamingVolumeNode> outputStreamingVolumeNode;
+
+    for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+    {
+      vtkMRMLSequenceNode* outputSequenceNode = sequenceEncoding->OutputSequenceNode;
+
+      // The chunks may complete in any order, but the results are added to the output sequence in the original order.
+      for (std::unique_ptr<EncodingChunk>& chunk : sequenceEncoding->Chunks)
+      {
+        {
+          std::unique_lock<std::mutex> lock(chunkMutex);
+          while (!chunk->Completed)
+          {
+            chunkCompleted.wait_for(lock, std::chrono::milliseconds(100));
+
+            // Progress is reported from the calling thread, since the callback may update the GUI
+            lock.unlock();
+            ReportEncodingProgress(progressCallback, (1.0 * numberOfFramesEncoded) / std::max(1, numberOfFramesToEncode));
+            if (encodingJob && encodingJob->IsCancelled())
+            {
+              // Stop the encoding threads
+              abortEncoding = true;
+            }
+            lock.lock();
+          }
+        }
+
+        if (encodingJob && encodingJob->IsCancelled())
+        {
+          abortEncoding = true;
+          cancelled = true;
+          success = false;
+          break;
+        }
+
+        if (!chunk->Success)
+        {
+          vtkErrorWithObjectMacro(sequenceEncoding->InputSequenceNode, "Re-encode failed! " << chunk->ErrorMessage);
+          abortEncoding = true;
+          success = false;
+          break;
+        }
+
+        for (size_t i = 0; i < chunk->OutputFrames.size(); ++i)
+        {
+          const EncodingInputFrame& inputFrame = chunk->InputFrames[i];
+          if (rollbackEnabled)
+          {
+            OutputRollbackItem rollbackItem;
+            rollbackItem.IndexValue = inputFrame.IndexValue;
+            rollbackItem.PreviousDataNode = outputSequenceNode->GetDataNodeAtValue(inputFrame.IndexValue);
+            sequenceEncoding->RollbackItems.push_back(rollbackItem);
+          }
+
+          vtkStreamingVolumeFrame* outputFrame = chunk->OutputFrames[i];
+          {
+            EncodingStageTimer timer(statistics, vtkSlicerIGSIOEncodingStatistics::StageNodeInsertion);
+            outputStreamingVolumeNode->SetIJKToRASMatrix(inputFrame.IJKToRASMatrix);
+            outputStreamingVolumeNode->SetAndObserveFrame(outputFrame);
+            outputSequenceNode->SetDataNodeAtValue(outputStreamingVolumeNode, inputFrame.IndexValue);
+          }
+
+          if (statistics)
+          {
+            int bytesOut = outputFrame->GetFrameData() ? static_cast<int>(outputFrame->GetFrameData()->GetNumberOfValues()) : 0;
+            statistics->AddFrame(inputFrame.IndexValue, GetEncodingInputFrameBytes(inputFrame), bytesOut,
+              outputFrame->IsKeyFrame(), chunk->PassThrough);
+          }
+        }
+
+        // All frames up to the end of this chunk have been encoded. The checkpoint is only stored if there is a job that can resume it.
+        if (encodingJob && !chunk->InputFrames.empty())
+        {
+          std::string checkpointIndexValue = chunk->InputFrames.back().IndexValue;
+          outputSequenceNode->SetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName(), checkpointIndexValue.c_str());
+          encodingJob->SetCheckpointIndexValue(checkpointIndexValue);
+        }
+
+        // Encoded frames are now stored in the output sequence
+        chunk->InputFrames.clear();
+        chunk->OutputFrames.clear();
+      }
+
+      if (!success)
+      {
+        break;
+      }
+    }
+    threadPool.Wait();
+
+    // The pooled images are only reused between the frames of a job, they should not stay allocated after it ends
+    vtkSlicerIGSIOBufferPool::GetInstance()->Clear();
+
+    if (cancelled)
+    {
+      if (rollbackEnabled)
+      {
+        for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+        {
+          vtkMRMLSequenceNode* outputSequenceNode = sequenceEncoding->OutputSequenceNode;
+
+          // Restore the output sequence in reverse order, so that the original node is restored if the same index value was replaced more than once
+          for (std::vector<OutputRollbackItem>::reverse_iterator rollbackItemIt = sequenceEncoding->RollbackItems.rbegin();
+            rollbackItemIt != sequenceEncoding->RollbackItems.rend(); ++rollbackItemIt)
+          {
+            if (rollbackItemIt->PreviousDataNode)
+            {
+              outputSequenceNode->SetDataNodeAtValue(rollbackItemIt->PreviousDataNode, rollbackItemIt->IndexValue);
+            }
+            else
+            {
+              outputSequenceNode->RemoveDataNodeAtValue(rollbackItemIt->IndexValue);
+            }
+          }
+
+          if (sequenceEncoding->OriginalCheckpointExists)
+          {
+            outputSequenceNode->SetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName(), sequenceEncoding->OriginalCheckpointIndexValue.c_str());
+          }
+          else
+          {
+            outputSequenceNode->RemoveAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+          }
+        }
+        encodingJob->SetCheckpointIndexValue(sequenceEncodings.empty() ? "" : sequenceEncodings.front()->OriginalCheckpointIndexValue);
+      }
+      vtkDebugWithObjectMacro(nullptr, "Encoding cancelled");
+    }
+    else if (!success && encodingJob)
+    {
+      // The frames after the checkpoint were not encoded because of an error, so the encoding cannot be resumed from it
+      for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+      {
+        sequenceEncoding->OutputSequenceNode->RemoveAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+      }
+      encodingJob->SetCheckpointIndexValue("");
+    }
+
+    if (success)
+    {
+      // Encoding completed, there is nothing left to resume
+      for (SequenceEncoding* sequenceEncoding : sequenceEncodings)
+      {
+        sequenceEncoding->OutputSequenceNode->RemoveAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+        sequenceEncoding->OutputSequenceNode->SetAttribute(vtkSlicerIGSIOCommon::GetMonochromeAttributeName(),
+          sequenceEncoding->Monochrome ? "true" : "false");
+      }
+      ReportEncodingProgress(progressCallback, 1.0);
+    }
+    return success;
+  }
+
+  //----------------------------------------------------------------------------
+  // Number of frames that each thread should encode. Chunks are only split at planned block boundaries, so they can be longer.
+  int GetEncodingChunkLength(int numberOfFramesToEncode, int numberOfThreads)
+  {
+    return std::max(1, (numberOfFramesToEncode + numberOfThreads - 1) / numberOfThreads);
+  }
+
+  //----------------------------------------------------------------------------
+  // Plan and encode a single sequence. The input and output sequence nodes must be set in the sequence encoding.
+  bool EncodeSequence(SequenceEncoding* sequenceEncoding, int startIndex, int endIndex, std::string codecFourCC,
+    std::map<std::string, std::string> codecParameters, bool forceReEncoding, bool minimalReEncoding, vtkCallbackCommand* progressCallback,
+    vtkSlicerIGSIOEncodingJob* encodingJob, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy, vtkSlicerIGSIOEncodingStatistics* statistics)
+  {
+    if (!PlanSequenceEncoding(sequenceEncoding, startIndex, endIndex, codecFourCC, forceReEncoding, minimalReEncoding, encodingJob, keyFramePolicy))
+    {
+      return false;
+    }
+
+    int numberOfThreads = GetNumberOfEncodingThreadsToUse(encodingJob ? encodingJob->GetNumberOfThreads() : 0);
+    if (!CreateEncodingChunks(sequenceEncoding, GetEncodingChunkLength(sequenceEncoding->NumberOfFramesToEncode, numberOfThreads), codecParameters, encodingJob))
+    {
+      return false;
+    }
+
+    std::vector<SequenceEncoding*> sequenceEncodings;
+    sequenceEncodings.push_back(sequenceEncoding);
+    return RunSequenceEncodings(sequenceEncodings, numberOfThreads, progressCallback, encodingJob, statistics);
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::EncodeVideoSequence(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode, int startIndex, int endIndex, std::string codecFourCC, std::map<std::string, std::string> codecParameters, bool forceReEncoding, bool minimalReEncoding, vtkCallbackCommand* progressCallback, vtkSlicerIGSIOEncodingJob* encodingJob, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy, vtkSlicerIGSIOEncodingStatistics* statistics)
+{
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  if (statistics)
+  {
+    statistics->Reset();
+  }
+
+  SequenceEncoding sequenceEncoding;
+  sequenceEncoding.InputSequenceNode = inputSequenceNode;
+  sequenceEncoding.OutputSequenceNode = outputSequenceNode;
+  bool success = EncodeSequence(&sequenceEncoding, startIndex, endIndex, codecFourCC, codecParameters,
+    forceReEncoding, minimalReEncoding, progressCallback, encodingJob, keyFramePolicy, statistics);
+  if (statistics)
+  {
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+    statistics->SetWallTime(wallTime.count());
+  }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOCommon::EncodeSequenceBrowser(vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+  std::string codecFourCC, std::map<std::string, std::string> codecParameters,
+  bool forceReEncoding, bool minimalReEncoding, vtkCallbackCommand* progressCallback, vtkSlicerIGSIOEncodingJob* encodingJob,
+  vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy, vtkSlicerIGSIOEncodingStatistics* statistics)
+{
+  if (!sequenceBrowserNode)
+  {
+    vtkErrorWithObjectMacro(sequenceBrowserNode, "Invalid sequence browser node!");
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  if (statistics)
+  {
+    statistics->Reset();
+  }
+
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  sequenceBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+
+  // Only video streams are encoded. Sequences of other volume types are left unchanged.
+  std::vector<std::unique_ptr<SequenceEncoding> > sequenceEncodingList;
+  int numberOfFramesToEncode = 0;
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    if (!sequenceNode || sequenceNode->GetNumberOfDataNodes() < 1
+      || !vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(0)))
+    {
+      continue;
+    }
+
+    std::unique_ptr<SequenceEncoding> sequenceEncoding(new SequenceEncoding());
+    sequenceEncoding->InputSequenceNode = sequenceNode;
+    sequenceEncoding->OutputSequenceNode = sequenceNode;
+    if (!PlanSequenceEncoding(sequenceEncoding.get(), 0, -1, codecFourCC, forceReEncoding, minimalReEncoding, encodingJob, keyFramePolicy))
+    {
+      return false;
+    }
+    numberOfFramesToEncode += sequenceEncoding->NumberOfFramesToEncode;
+    sequenceEncodingList.push_back(std::move(sequenceEncoding));
+  }
+
+  // The chunk length is based on the total number of frames, so that the threads are shared between all of the sequences
+  int numberOfThreads = GetNumberOfEncodingThreadsToUse(encodingJob ? encodingJob->GetNumberOfThreads() : 0);
+  int chunkLength = GetEncodingChunkLength(numberOfFramesToEncode, numberOfThreads);
+  std::vector<SequenceEncoding*> sequenceEncodings;
+  for (std::unique_ptr<SequenceEncoding>& sequenceEncoding : sequenceEncodingList)
+  {
+    if (!CreateEncodingChunks(sequenceEncoding.get(), chunkLength, codecParameters, encodingJob))
+    {
+      return false;
+    }
+    sequenceEncodings.push_back(sequenceEncoding.get());
+  }
+  bool success = RunSequenceEncodings(sequenceEncodings, numberOfThreads, progressCallback, encodingJob, statistics);
+  if (statistics)
+  {
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+    statistics->SetWallTime(wallTime.count());
+  }
+  return success;
+}
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Get the item number of the first frame that has not been encoded using the encoder state.
+  // Returns -1 if the state cannot be used to continue encoding the sequence.
+  int GetFirstAppendedItemNumber(vtkMRMLSequenceNode* sequenceNode, std::string codecFourCC,
+    std::map<std::string, std::string> codecParameters, vtkSlicerIGSIOEncoderState* encoderState)
+  {
+    if (!encoderState->IsInitialized() || encoderState->GetSequenceNode() != sequenceNode)
+    {
+      return -1;
+    }
+    if ((!codecFourCC.empty() && codecFourCC != encoderState->GetCodecFourCC())
+      || codecParameters != encoderState->GetCodecParameters())
+    {
+      return -1;
+    }
+
+    int lastEncodedItemNumber = encoderState->GetLastEncodedItemNumber();
+    if (lastEncodedItemNumber >= sequenceNode->GetNumberOfDataNodes()
+      || encoderState->GetNumberOfEncodedFrames() != lastEncodedItemNumber + 1
+      || sequenceNode->GetNthIndexValue(lastEncodedItemNumber) != encoderState->GetLastEncodedIndexValue())
+    {
+      return -1;
+    }
+
+    // Items in the middle of the sequence can be replaced without changing the first and last items, so the frames of
+    // all encoded items are compared. This only compares pointers, which is negligible compared to encoding a frame.
+    for (int i = 0; i <= lastEncodedItemNumber; ++i)
+    {
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+      if (!streamingVolumeNode || streamingVolumeNode->GetFrame() != encoderState->GetNthEncodedFrame(i))
+      {
+        return -1;
+      }
+    }
+    return lastEncodedItemNumber + 1;
+  }
+
+  //----------------------------------------------------------------------------
+  // Store the frames of the sequence in the encoder state, starting from the specified item.
+  void UpdateEncoderStateFrames(vtkMRMLSequenceNode* sequenceNode, int startItemNumber, vtkSlicerIGSIOEncoderState* encoderState)
+  {
+    if (startItemNumber == 0)
+    {
+      encoderState->ClearEncodedFrames();
     }
-
+    int lastItemNumber = sequenceNode->GetNumberOfDataNodes() - 1;
+    for (int i = startItemNumber; i <= lastItemNumber; ++i)
+    {
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+      encoderState->AddEncodedFrame(streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr);
+    }
+    vtkMRMLStreamingVolumeNode* lastStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(lastItemNumber));
+    encoderState->SetLastEncodedFrame(lastStreamingVolumeNode ? lastStreamingVolumeNode->GetFrame() : nullptr);
+    encoderState->SetLastEncodedItemNumber(lastItemNumber);
+    encoderState->SetLastEncodedIndexValue(sequenceNode->GetNthIndexValue(lastItemNumber));
   }
-  sequenceBrowserNode->Modified();
-  return true;
 }
 
 //----------------------------------------------------------------------------
-bool vtkSlicerIGSIOCommon::VolumeSequenceToTrackedFrameList(vtkMRMLSequenceNode* sequenceNode, vtkIGSIOTrackedFrameList* trackedFrameList)
+bool vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(vtkMRMLSequenceNode* videoStreamSequenceNode,
+  std::string codecFourCC, std::map<std::string, std::string> codecParameters, vtkSlicerIGSIOEncoderState* encoderState,
+  vtkSlicerIGSIOEncodingJob* encodingJob)
 {
-  if (!sequenceNode || !trackedFrameList)
+  if (!videoStreamSequenceNode || !encoderState)
   {
-    vtkErrorWithObjectMacro(sequenceNode, "Invalid arguments");
+    vtkErrorWithObjectMacro(videoStreamSequenceNode, "Invalid arguments");
     return false;
   }
 
-  if (sequenceNode->GetNumberOfDataNodes() < 1)
+  int numberOfFrames = videoStreamSequenceNode->GetNumberOfDataNodes();
+  encoderState->SetNumberOfFramesEncodedInLastUpdate(0);
+  encoderState->SetLastUpdateWasFull(false);
+  if (numberOfFrames < 1)
   {
-    vtkErrorWithObjectMacro(sequenceNode, "No data nodes in sequence");
-    return false;
+    encoderState->Reset();
+    return true;
   }
 
-  std::string codecFourCC;
-  bool useTimestamp = sequenceNode->GetIndexName() == "time";
-  std::string trackName = sequenceNode->GetName();
-  if (sequenceNode->GetNumberOfDataNodes() > 0)
+  int firstAppendedItemNumber = GetFirstAppendedItemNumber(videoStreamSequenceNode, codecFourCC, codecParameters, encoderState);
+  if (firstAppendedItemNumber < 0)
   {
-    trackName = sequenceNode->GetNthDataNode(0)->GetName();
+    // The previous state cannot be continued, so the whole sequence is checked
+    encoderState->Reset();
+    SequenceEncoding sequenceEncoding;
+    sequenceEncoding.InputSequenceNode = videoStreamSequenceNode;
+    sequenceEncoding.OutputSequenceNode = videoStreamSequenceNode;
+    if (!EncodeSequence(&sequenceEncoding, 0, -1, codecFourCC, codecParameters, false, true, nullptr, encodingJob, nullptr, nullptr))
+    {
+      return false;
+    }
+
+    // The codec instances of the full encoding are not kept, so the next appended frame will start with a keyframe.
+    // The window of the 16-bit frames is kept, so that the appended frames are mapped the same way.
+    encoderState->SetSequenceNode(videoStreamSequenceNode);
+    encoderState->SetCodecFourCC(sequenceEncoding.CodecFourCC);
+    encoderState->SetCodecParameters(codecParameters);
+    encoderState->SetEncodingWindow(sequenceEncoding.EncodingWindow);
+    encoderState->SetEncodingLevel(sequenceEncoding.EncodingLevel);
+    encoderState->SetNumberOfFramesEncodedInLastUpdate(sequenceEncoding.NumberOfFramesToEncode);
+    encoderState->SetLastUpdateWasFull(true);
+    UpdateEncoderStateFrames(videoStreamSequenceNode, 0, encoderState);
+    return true;
   }
-  if (trackedFrameList->SetCustomString(TRACKNAME_FIELD_NAME, trackName) == IGSIO_FAIL)
+
+  std::string stateCodecFourCC = encoderState->GetCodecFourCC();
+  std::map<std::string, vtkSmartPointer<vtkStreamingVolumeCodec> > decoders;
+  PixelConversionFunction convertImageData;
+  if (IsRGBInputRequired(stateCodecFourCC, encodingJob))
   {
-    vtkErrorWithObjectMacro(sequenceNode, "Could not set track name!");
-    return false;
+    if (encoderState->GetEncodingWindow() <= 0.0)
+    {
+      // No 16-bit frames were encoded so far, so the window is determined from the new frames and kept for the next updates
+      double window = 0.0;
+      double level = 0.0;
+      if (!GetSequenceEncodingWindowLevel(videoStreamSequenceNode, firstAppendedItemNumber, encodingJob, window, level))
+      {
+        encoderState->Reset();
+        return false;
+      }
+      encoderState->SetEncodingWindow(window);
+      encoderState->SetEncodingLevel(level);
+    }
+    convertImageData = CreateRGBPixelConversion(encoderState->GetEncodingWindow(), encoderState->GetEncodingLevel());
   }
-
-
-  int dimensions[3] = { 0, 0, 0 };
-  vtkStreamingVolumeFrame* lastFrame = nullptr;
-  double timestamp = 0;
-  double lastTimestamp = 0.0;
-  for (int i = 0; i < sequenceNode->GetNumberOfDataNodes(); ++i)
+  vtkNew<vtkMRMLStreamingVolumeNode> outputStreamingVolumeNode;
+  vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+  vtkSmartPointer<vtkStreamingVolumeFrame> previousFrame = encoderState->GetLastEncodedFrame();
+  int numberOfFramesEncoded = 0;
+  bool monochrome = vtkSlicerIGSIOCommon::IsMonochromeSequence(videoStreamSequenceNode);
+  for (int i = firstAppendedItemNumber; i < numberOfFrames; ++i)
   {
-    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
-    if (!streamingVolumeNode)
+    vtkMRMLVolumeNode* inputVolumeNode = vtkMRMLVolumeNode::SafeDownCast(videoStreamSequenceNode->GetNthDataNode(i));
+    if (!inputVolumeNode)
     {
-      continue;
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "Invalid data node at index " << i);
+      encoderState->Reset();
+      return false;
     }
 
-    vtkStreamingVolumeFrame* frame = streamingVolumeNode->GetFrame();
-    if (!frame)
+    vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputVolumeNode);
+    vtkStreamingVolumeFrame* inputFrame = inputStreamingVolumeNode ? inputStreamingVolumeNode->GetFrame() : nullptr;
+    if (inputFrame && inputFrame->GetCodecFourCC() == stateCodecFourCC
+      && (inputFrame->IsKeyFrame() || inputFrame->GetPreviousFrame() == previousFrame))
     {
+      // Frame was already encoded with the same codec and continues the stream, so it can be kept.
+      // The codec state no longer matches the last frame, so the next encoded frame must start with a keyframe.
+      encoderState->SetCodec(nullptr);
+      previousFrame = inputFrame;
       continue;
     }
 
-    frame->GetDimensions(dimensions);
-    codecFourCC = streamingVolumeNode->GetCodecFourCC();
-
-    std::stringstream timestampSS;
-    timestampSS << sequenceNode->GetNthIndexValue(i);
-    if (useTimestamp)
+    vtkSmartPointer<vtkImageData> imageData;
+    if (inputFrame)
     {
-      timestampSS >> timestamp;
+      std::string inputCodecFourCC = inputFrame->GetCodecFourCC();
+      if (decoders.find(inputCodecFourCC) == decoders.end())
+      {
+        decoders[inputCodecFourCC] = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+          vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(inputCodecFourCC));
+      }
+      int dimensions[3] = { 0, 0, 0 };
+      inputFrame->GetDimensions(dimensions);
+      imageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(dimensions, inputFrame->GetVTKScalarType(), inputFrame->GetNumberOfComponents());
+      if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(decoders[inputCodecFourCC], inputFrame, imageData))
+      {
+        vtkErrorWithObjectMacro(videoStreamSequenceNode, "Error decoding frame at index " << i);
+        encoderState->Reset();
+        return false;
+      }
     }
     else
     {
-      timestamp += 0.1;
+      imageData = inputVolumeNode->GetImageData();
+      monochrome = monochrome && imageData && imageData->GetNumberOfScalarComponents() == 1;
+    }
+    if (!imageData)
+    {
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "No image data for frame at index " << i);
+      encoderState->Reset();
+      return false;
     }
 
-    vtkSmartPointer<vtkMatrix4x4> ijkToRASTransform = vtkSmartPointer<vtkMatrix4x4>::New();
-    streamingVolumeNode->GetIJKToRASMatrix(ijkToRASTransform);
-
-    igsioTransformName imageToPhysicalName;
-    imageToPhysicalName.SetTransformName(trackName + "ToPhysical");
-
-    std::stack<vtkStreamingVolumeFrame*> frameStack;
+    if (convertImageData)
     {
-      vtkStreamingVolumeFrame* currentFrame = frame;
-      while (currentFrame)
+      vtkSmartPointer<vtkImageData> convertedImageData = convertImageData(imageData);
+      if (convertedImageData != imageData)
       {
-        frameStack.push(currentFrame);
-        if (currentFrame->IsKeyFrame())
-        {
-          // Keyframe -- We have all the info needed to decode the indexed frame.
-          break;
-        }
+        vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(imageData);
+      }
+      imageData = convertedImageData;
+      if (!imageData)
+      {
+        vtkErrorWithObjectMacro(videoStreamSequenceNode, "Error converting pixels of frame at index " << i);
+        encoderState->Reset();
+        return false;
+      }
+    }
 
-        currentFrame = currentFrame->GetPreviousFrame();
-        if (currentFrame == lastFrame)
-        {
-          // The next frame is already processed, so we can stop here.
-          break;
-        }
+    if (!encoderState->GetCodec())
+    {
+      vtkSmartPointer<vtkStreamingVolumeCodec> codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+        vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(stateCodecFourCC));
+      if (!codec)
+      {
+        vtkErrorWithObjectMacro(videoStreamSequenceNode, "Could not find codec: " << stateCodecFourCC);
+        encoderState->Reset();
+        return false;
       }
-      lastFrame = frame;
+      codec->SetParameters(codecParameters);
+      encoderState->SetCodec(codec);
     }
 
-    int initialStackSize = frameStack.size();
-    while (frameStack.size() > 0)
+    vtkSmartPointer<vtkStreamingVolumeFrame> outputFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    if (!encoderState->GetCodec()->EncodeImageData(imageData, outputFrame))
     {
-      vtkStreamingVolumeFrame* currentFrame = frameStack.top();
-      igsioTrackedFrame trackedFrame;
-      igsioVideoFrame videoFrame;
-      videoFrame.SetEncodedFrame(currentFrame);
-      trackedFrame.SetImageData(videoFrame);
-      double currentTimestamp = lastTimestamp + (timestamp - lastTimestamp) * ((double)(initialStackSize - frameStack.size() + 1.0) / initialStackSize);
-      trackedFrame.SetTimestamp(currentTimestamp);
-      trackedFrame.SetFrameTransform(imageToPhysicalName, ijkToRASTransform);
-      trackedFrame.SetFrameField(FRAME_STATUS_TRACKNAME, vtkVariant(frameStack.size() == 1 ? Frame_OK : Frame_Skip).ToString());
-      trackedFrameList->AddTrackedFrame(&trackedFrame);
-      frameStack.pop();
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "Error encoding frame at index " << i);
+      encoderState->Reset();
+      return false;
     }
-    lastTimestamp = timestamp;
+    vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(imageData);
+    imageData = nullptr;
+
+    inputVolumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
+    outputStreamingVolumeNode->SetIJKToRASMatrix(ijkToRASMatrix);
+    outputStreamingVolumeNode->SetAndObserveFrame(outputFrame);
+    videoStreamSequenceNode->SetDataNodeAtValue(outputStreamingVolumeNode, videoStreamSequenceNode->GetNthIndexValue(i));
+    previousFrame = outputFrame;
+    ++numberOfFramesEncoded;
   }
-  trackedFrameList->GetEncodingFourCC(codecFourCC);
 
+  encoderState->SetNumberOfFramesEncodedInLastUpdate(numberOfFramesEncoded);
+  UpdateEncoderStateFrames(videoStreamSequenceNode, firstAppendedItemNumber, encoderState);
+  videoStreamSequenceNode->SetAttribute(vtkSlicerIGSIOCommon::GetMonochromeAttributeName(), monochrome ? "true" : "false");
   return true;
 }
 
-//----------------------------------------------------------------------------
-bool vtkSlicerIGSIOCommon::SequenceBrowserToTrackedFrameList(vtkMRMLSequenceBrowserNode* inputSequenceBrowserNode,
-  vtkIGSIOTrackedFrameList* outputTrackedFrameList)
+namespace
 {
-  if (!inputSequenceBrowserNode)
-  {
-    LOG_ERROR("Invalid input sequence browser!");
-  }
-
-  if (!outputTrackedFrameList)
-  {
-    LOG_ERROR("Invalid output volume node!");
-  }
-
-
-  vtkMRMLSequenceNode* masterSequenceNode = inputSequenceBrowserNode->GetMasterSequenceNode();
-  if (!masterSequenceNode || masterSequenceNode->GetNumberOfDataNodes() <= 0 || !masterSequenceNode->GetNthDataNode(0)->IsA("vtkMRMLVolumeNode"))
+  //----------------------------------------------------------------------------
+  // Frame of a decoding group. Frames that are only decoded as references for later frames have no output slice.
+  struct DecodingGroupFrame
   {
-    LOG_ERROR("Invalid master sequence node!");
-  }
-  int numberOfDataNodes = masterSequenceNode->GetNumberOfDataNodes();
-
-  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
-  inputSequenceBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
-  for (int i = 0; i < masterSequenceNode->GetNumberOfDataNodes(); ++i)
+    vtkSmartPointer<vtkStreamingVolumeFrame> Frame;
+    vtkSmartPointer<vtkImageData> ImageData;
+    int ItemNumber{ -1 };
+    int OutputSlice{ -1 };
+  };
+
+  //----------------------------------------------------------------------------
+  // Consecutive items of a sequence that are decoded in order by the same decoder.
+  // Groups that are decoded from different keyframes are independent, so they can be decoded in parallel.
+  // The codec is empty for groups of uncompressed items, which are copied without decoding.
+  struct DecodingGroup
   {
-    igsioTrackedFrame emptyFrame;
-    outputTrackedFrameList->AddTrackedFrame(&emptyFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
-  }
-
-  int selectedItemNumber = inputSequenceBrowserNode->GetSelectedItemNumber();
-  for (int i = 0; i < numberOfDataNodes; ++i)
+    std::string CodecFourCC;
+    vtkSmartPointer<vtkStreamingVolumeCodec> Decoder;
+    int KeyFrameItemNumber{ -1 };
+    std::vector<DecodingGroupFrame> Frames;
+    std::string ErrorMessage;
+  };
+
+  //----------------------------------------------------------------------------
+  void DecodeDecodingGroup(DecodingGroup* group, unsigned char* outputPointer, int sliceBytes,
+    int frameDimensions[3], int scalarType, int numberOfComponents, bool lumaOnly, std::atomic<bool>* abortDecoding)
   {
-    igsioTrackedFrame* trackedFrame = outputTrackedFrameList->GetTrackedFrame(i);
-    inputSequenceBrowserNode->SetSelectedItemNumber(i);
-
-    for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+    vtkSmartPointer<vtkImageData> imageData;
+    for (DecodingGroupFrame& groupFrame : group->Frames)
     {
-      vtkMRMLNode* proxyNode = inputSequenceBrowserNode->GetProxyNode(sequenceNode);
-      vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(proxyNode);
-      vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(proxyNode);
-
-      if (volumeNode)
+      if (*abortDecoding)
       {
-        trackedFrame->GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF); // TODO: save orientation and type
-        //trackedFrame->GetImageData()->SetImageType(US_IMG_RGB_COLOR);
-        trackedFrame->SetTimestamp(i);
-        trackedFrame->GetImageData()->DeepCopyFrom(volumeNode->GetImageData());
-
-        vtkNew<vtkTransform> imageToWorldTransform;
-        imageToWorldTransform->Identity();
-        imageToWorldTransform->PreMultiply();
-        vtkNew<vtkMatrix4x4> ijkToRASMatrix;
-        volumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
-        imageToWorldTransform->Concatenate(ijkToRASMatrix);
+        break;
+      }
 
-        vtkNew<vtkMatrix4x4> parentToWorldMatrix;
-        vtkMRMLTransformNode* transformNode = volumeNode->GetParentTransformNode();
-        if (transformNode)
+      vtkImageData* sourceImageData = groupFrame.ImageData;
+      if (groupFrame.Frame)
+      {
+        if (!imageData)
         {
-          transformNode->GetMatrixTransformToWorld(parentToWorldMatrix);
-          imageToWorldTransform->Concatenate(parentToWorldMatrix);
+          imageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(frameDimensions, scalarType, numberOfComponents);
         }
-
-        vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
-        imageToWorldTransform->GetMatrix(matrix);
-        igsioTransformName transformName("ImageToWorld");
-        trackedFrame->SetFrameTransform(transformName, matrix);
-        trackedFrame->SetFrameTransformStatus(transformName, ToolStatus::TOOL_OK); //TODO: Attribute to status
+        if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(group->Decoder, groupFrame.Frame, imageData, lumaOnly))
+        {
+          std::stringstream ss;
+          ss << "Error decoding frame at index " << groupFrame.ItemNumber;
+          group->ErrorMessage = ss.str();
+          *abortDecoding = true;
+          break;
+        }
+        sourceImageData = imageData;
       }
 
-      if (transformNode)
+      if (groupFrame.OutputSlice < 0)
       {
-        vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
-        transformNode->GetMatrixTransformToParent(matrix);
-
-        igsioTransformName transformName(transformNode->GetName());
-        trackedFrame->SetFrameTransform(transformName, matrix);
-        trackedFrame->SetFrameTransformStatus(transformName, ToolStatus::TOOL_OK); //TODO: Attribute to status
+        continue;
       }
+      memcpy(outputPointer + static_cast<size_t>(groupFrame.OutputSlice) * sliceBytes, sourceImageData->GetScalarPointer(), sliceBytes);
     }
+    vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(imageData);
   }
-  inputSequenceBrowserNode->SetSelectedItemNumber(selectedItemNumber);
-
-  return true;
 }
 
 //----------------------------------------------------------------------------
-bool vtkSlicerIGSIOCommon::EncodeVideoSequence(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode, int startIndex, int endIndex, std::string codecFourCC, std::map<std::string, std::string> codecParameters, bool forceReEncoding, bool minimalReEncoding, vtkCallbackCommand* progressCallback)
+bool vtkSlicerIGSIOCommon::DecodeVideoSequence(vtkMRMLSequenceNode* videoStreamSequenceNode, vtkImageData* outputImageData,
+  int startIndex, int endIndex, int frameStride, int numberOfThreads)
 {
-  if (!inputSequenceNode)
-  {
-    vtkErrorWithObjectMacro(inputSequenceNode, "Input is invalid vtkMRMLSequenceNode");
-    return false;
-  }
-
-  if (!outputSequenceNode)
+  if (!videoStreamSequenceNode || !outputImageData)
   {
-    vtkErrorWithObjectMacro(outputSequenceNode, "Output is invalid vtkMRMLSequenceNode");
+    vtkErrorWithObjectMacro(videoStreamSequenceNode, "Invalid arguments");
     return false;
   }
 
-  int numberOfFrames = inputSequenceNode->GetNumberOfDataNodes();
+  int numberOfItems = videoStreamSequenceNode->GetNumberOfDataNodes();
   if (endIndex < 0)
   {
-    endIndex = numberOfFrames - 1;
+    endIndex = numberOfItems - 1;
   }
-
-  if (startIndex < 0 || startIndex >= numberOfFrames || startIndex > endIndex
-    || endIndex >= numberOfFrames)
+  if (startIndex < 0 || endIndex >= numberOfItems || startIndex > endIndex || frameStride < 1)
   {
-    vtkErrorWithObjectMacro(inputSequenceNode, "Invalid start and end indices!");
+    vtkErrorWithObjectMacro(videoStreamSequenceNode, "Invalid frame range: " << startIndex << " to " << endIndex << " with stride " << frameStride);
     return false;
   }
 
-  std::vector<FrameBlock> frameBlocks;
-
-  if (!forceReEncoding)
+  // Group the frames by keyframe on the main thread, since the sequence cannot be accessed by the worker threads
+  vtkSlicerIGSIOKeyFrameIndex* keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(videoStreamSequenceNode);
+  bool lumaOnly = vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(videoStreamSequenceNode);
+  std::vector<DecodingGroup> decodingGroups;
+  int frameDimensions[3] = { 0, 0, 0 };
+  int scalarType = VTK_VOID;
+  int numberOfComponents = 0;
+  int numberOfSlices = 0;
+  for (int itemNumber = startIndex; itemNumber <= endIndex; itemNumber += frameStride)
   {
-    FrameBlock currentFrameBlock;
-    currentFrameBlock.StartFrame = 0;
-    currentFrameBlock.EndFrame = 0;
-    currentFrameBlock.ReEncodingRequired = false;
-    vtkSmartPointer<vtkStreamingVolumeFrame> previousFrame = nullptr;
-    for (int i = startIndex; i <= endIndex; ++i)
+    vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(videoStreamSequenceNode->GetNthDataNode(itemNumber));
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(volumeNode);
+    vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+    // The image of an encoded frame is not requested, since that would decode the frame on the main thread
+    vtkImageData* imageData = (!frame && volumeNode) ? volumeNode->GetImageData() : nullptr;
+    if (!frame && !imageData)
+    {
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "No image data for frame at index " << itemNumber);
+      return false;
+    }
+
+    int dimensions[3] = { 0, 0, 0 };
+    int frameScalarType = VTK_VOID;
+    int frameNumberOfComponents = 0;
+    if (frame)
     {
-      // TODO: for now, only support sequences of vtkMRMLStreamingVolumeNode
-      // In the future, this could be changed to allow all types of volume nodes to be encoded
-      vtkMRMLVolumeNode* inputVolumeNode = vtkMRMLVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
-      if (!inputVolumeNode)
+      frame->GetDimensions(dimensions);
+      frameScalarType = frame->GetVTKScalarType();
+      frameNumberOfComponents = frame->GetNumberOfComponents();
+      if (lumaOnly && frameScalarType == VTK_UNSIGNED_CHAR && frameNumberOfComponents == 3)
       {
-        vtkErrorWithObjectMacro(inputSequenceNode, "Invalid data node at index " << i);
-        return false;
+        frameNumberOfComponents = 1;
       }
+    }
+    else
+    {
+      imageData->GetDimensions(dimensions);
+      frameScalarType = imageData->GetScalarType();
+      frameNumberOfComponents = imageData->GetNumberOfScalarComponents();
+    }
+    if (numberOfSlices == 0)
+    {
+      std::copy(dimensions, dimensions + 3, frameDimensions);
+      scalarType = frameScalarType;
+      numberOfComponents = frameNumberOfComponents;
+    }
+    if (dimensions[2] != 1 || !std::equal(dimensions, dimensions + 3, frameDimensions)
+      || frameScalarType != scalarType || frameNumberOfComponents != numberOfComponents)
+    {
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "Frame at index " << itemNumber << " is not a 2D image with the same dimensions and type as the first frame");
+      return false;
+    }
 
-      vtkStreamingVolumeFrame* currentFrame = nullptr;
-      vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
-      if (inputStreamingVolumeNode)
+    DecodingGroupFrame groupFrame;
+    groupFrame.ItemNumber = itemNumber;
+    groupFrame.OutputSlice = numberOfSlices++;
+    if (!frame)
+    {
+      groupFrame.ImageData = imageData;
+      if (decodingGroups.empty() || !decodingGroups.back().CodecFourCC.empty())
       {
-        if (codecFourCC == "")
-        {
-          codecFourCC = inputStreamingVolumeNode->GetCodecFourCC();
-        }
-        currentFrame = inputStreamingVolumeNode->GetFrame();
-
-        if (currentFrameBlock.ReEncodingRequired == false)
-        {
-          if (i == 0 && !inputStreamingVolumeNode->IsKeyFrame())
-          {
-            currentFrameBlock.ReEncodingRequired = true;
-          }
-          else if (!currentFrame)
-          {
-            currentFrameBlock.ReEncodingRequired = true;
-          }
-          else if (codecFourCC == "")
-          {
-            currentFrameBlock.ReEncodingRequired = true;
-          }
-          else if (codecFourCC != inputStreamingVolumeNode->GetCodecFourCC())
-          {
-            currentFrameBlock.ReEncodingRequired = true;
-          }
-          else if (!minimalReEncoding && currentFrame && !currentFrame->IsKeyFrame() && previousFrame != currentFrame->GetPreviousFrame())
-          {
-            currentFrameBlock.ReEncodingRequired = true;
-          }
-        }
+        decodingGroups.emplace_back();
       }
+      decodingGroups.back().Frames.push_back(groupFrame);
+      continue;
+    }
+    groupFrame.Frame = frame;
+
+    // If the previous frames are not stored in consecutive items, the decoder follows the previous frame pointers itself
+    int keyFrameItemNumber = keyFrameIndex->GetKeyFrameItemNumber(itemNumber);
+    if (keyFrameItemNumber < 0 || decodingGroups.empty() || decodingGroups.back().KeyFrameItemNumber != keyFrameItemNumber)
+    {
+      DecodingGroup decodingGroup;
+      decodingGroup.KeyFrameItemNumber = keyFrameItemNumber;
+      decodingGroup.CodecFourCC = frame->GetCodecFourCC();
+      decodingGroups.push_back(decodingGroup);
+    }
 
-      if (currentFrame && // Current frame exists
-        previousFrame && // Current frame is not the initial frame
-        currentFrame->IsKeyFrame() && // Current frame is a keyframe
-        !previousFrame->IsKeyFrame()) // Previous frame was not also a keyframe
+    // Frames between the previous item of the group and this item are decoded only as references
+    DecodingGroup& decodingGroup = decodingGroups.back();
+    int firstReferenceItemNumber = decodingGroup.Frames.empty() ? keyFrameItemNumber : decodingGroup.Frames.back().ItemNumber + 1;
+    for (int referenceItemNumber = std::max(0, firstReferenceItemNumber); referenceItemNumber < itemNumber; ++referenceItemNumber)
+    {
+      vtkMRMLStreamingVolumeNode* referenceNode = vtkMRMLStreamingVolumeNode::SafeDownCast(videoStreamSequenceNode->GetNthDataNode(referenceItemNumber));
+      DecodingGroupFrame referenceFrame;
+      referenceFrame.Frame = referenceNode ? referenceNode->GetFrame() : nullptr;
+      referenceFrame.ItemNumber = referenceItemNumber;
+      if (!referenceFrame.Frame)
       {
-        frameBlocks.push_back(currentFrameBlock);
-        currentFrameBlock = FrameBlock();
-        currentFrameBlock.StartFrame = i;
-        currentFrameBlock.EndFrame = i;
-        currentFrameBlock.ReEncodingRequired = false;
+        vtkErrorWithObjectMacro(videoStreamSequenceNode, "Missing reference frame at index " << referenceItemNumber);
+        return false;
       }
-      currentFrameBlock.EndFrame = i;
-      previousFrame = currentFrame;
-
-      /// TODO: If dimension changes, re-encode smaller images with padding
+      decodingGroup.Frames.push_back(referenceFrame);
     }
-    frameBlocks.push_back(currentFrameBlock);
+    decodingGroup.Frames.push_back(groupFrame);
   }
-  else
+
+  // Groups can be as short as a single frame, for example if every frame is a keyframe. Consecutive groups of the same codec are
+  // merged into batches of about the same number of frames for each thread, and each batch is decoded by one task with one decoder.
+  numberOfThreads = GetNumberOfEncodingThreadsToUse(numberOfThreads);
+  size_t numberOfFramesToDecode = 0;
+  for (const DecodingGroup& decodingGroup : decodingGroups)
   {
-    FrameBlock totalFrameBlock;
-    totalFrameBlock.StartFrame = startIndex;
-    totalFrameBlock.EndFrame = endIndex;
-    totalFrameBlock.ReEncodingRequired = true;
-    frameBlocks.push_back(totalFrameBlock);
+    numberOfFramesToDecode += decodingGroup.Frames.size();
   }
-
-  if (codecFourCC == "")
+  size_t batchLength = std::max<size_t>(1, (numberOfFramesToDecode + numberOfThreads - 1) / numberOfThreads);
+  std::vector<DecodingGroup> decodingBatches;
+  for (DecodingGroup& decodingGroup : decodingGroups)
   {
-    std::vector<std::string> codecFourCCs = vtkStreamingVolumeCodecFactory::GetInstance()->GetStreamingCodecFourCCs();
-    if (codecFourCCs.empty())
+    if (!decodingBatches.empty() && decodingBatches.back().Frames.size() < batchLength
+      && decodingBatches.back().CodecFourCC == decodingGroup.CodecFourCC
+      && decodingBatches.back().KeyFrameItemNumber >= 0 && decodingGroup.KeyFrameItemNumber >= 0)
     {
-      vtkErrorWithObjectMacro(nullptr, "Re-encode failed! No codecs registered!");
+      DecodingGroup& decodingBatch = decodingBatches.back();
+      decodingBatch.Frames.insert(decodingBatch.Frames.end(), decodingGroup.Frames.begin(), decodingGroup.Frames.end());
+      decodingBatch.KeyFrameItemNumber = decodingGroup.KeyFrameItemNumber;
+      continue;
+    }
+    decodingBatches.push_back(std::move(decodingGroup));
+  }
+  for (DecodingGroup& decodingBatch : decodingBatches)
+  {
+    if (decodingBatch.CodecFourCC.empty())
+    {
+      continue;
+    }
+    decodingBatch.Decoder = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+      vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(decodingBatch.CodecFourCC));
+    if (!decodingBatch.Decoder)
+    {
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "Could not find codec: " << decodingBatch.CodecFourCC);
       return false;
     }
-
-    codecFourCC = codecFourCCs.front();
-    vtkDebugWithObjectMacro(nullptr, "Streaming volume codec not specified! Using: " << codecFourCC);
   }
 
-  double progress = 0.0;
-  int framesProcessed = 0;
+  outputImageData->SetDimensions(frameDimensions[0], frameDimensions[1], numberOfSlices);
+  outputImageData->AllocateScalars(scalarType, numberOfComponents);
+  unsigned char* outputPointer = static_cast<unsigned char*>(outputImageData->GetScalarPointer());
+  int sliceBytes = frameDimensions[0] * frameDimensions[1] * numberOfComponents * outputImageData->GetScalarSize();
 
-  std::vector<FrameBlock>::iterator frameBlockIt;
-  for (frameBlockIt = frameBlocks.begin(); frameBlockIt != frameBlocks.end(); ++frameBlockIt)
+  std::atomic<bool> abortDecoding(false);
   {
-    if (frameBlockIt->ReEncodingRequired)
+    vtkSlicerIGSIOThreadPool threadPool(std::max(1, std::min(numberOfThreads, static_cast<int>(decodingBatches.size()))));
+    for (DecodingGroup& decodingBatch : decodingBatches)
     {
-      vtkNew<vtkMRMLStreamingVolumeNode> decodingProxyNode;
-      vtkSmartPointer<vtkStreamingVolumeCodec> codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
-        vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
-      if (!codec)
-      {
-        vtkErrorWithObjectMacro(nullptr, "Could not find codec: " << codecFourCC);
-        return false;
-      }
-      codec->SetParameters(codecParameters);
-
-      for (int i = frameBlockIt->StartFrame; i <= frameBlockIt->EndFrame; ++i)
-      {
-        vtkMRMLVolumeNode* inputVolumeNode = vtkMRMLVolumeNode::SafeDownCast(inputSequenceNode->GetNthDataNode(i));
-        if (!inputVolumeNode)
-        {
-          vtkErrorWithObjectMacro(inputSequenceNode, "Invalid data node at index " << i);
-          return false;
-        }
-
-        vtkSmartPointer<vtkImageData> imageData = nullptr;
-        vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(inputVolumeNode);
-        if (inputStreamingVolumeNode && inputStreamingVolumeNode->GetFrame())
-        {
-          decodingProxyNode->SetAndObserveFrame(inputStreamingVolumeNode->GetFrame());
-          decodingProxyNode->DecodeFrame();
-          imageData = decodingProxyNode->GetImageData();
-        }
-        else
+      DecodingGroup* group = &decodingBatch;
+      threadPool.Submit([group, outputPointer, sliceBytes, &frameDimensions, scalarType, numberOfComponents, lumaOnly, &abortDecoding]()
         {
-          imageData = inputVolumeNode->GetImageData();
-        }
-
-        vtkSmartPointer<vtkStreamingVolumeFrame> outputFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
-        if (!codec->EncodeImageData(imageData, outputFrame))
-        {
-          vtkErrorWithObjectMacro(nullptr, "Error encoding frame!");
-          return false;
-        }
-
-        vtkNew<vtkMatrix4x4> ijkToRASMatrix;
-        inputVolumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
-
-        vtkNew<vtkMRMLStreamingVolumeNode> outputStreamingVolumeNode;
-        outputStreamingVolumeNode->SetRASToIJKMatrix(ijkToRASMatrix);
-        outputStreamingVolumeNode->SetAndObserveFrame(outputFrame);
-        outputSequenceNode->SetDataNodeAtValue(outputStreamingVolumeNode, inputSequenceNode->GetNthIndexValue(i));
+          DecodeDecodingGroup(group, outputPointer, sliceBytes, frameDimensions, scalarType, numberOfComponents, lumaOnly, &abortDecoding);
+        });
+    }
+    threadPool.Wait();
+  }
+  vtkSlicerIGSIOBufferPool::GetInstance()->Clear();
 
-        ++framesProcessed;
-        progress = (1.0 * framesProcessed) / numberOfFrames;
-        if (progressCallback)
-        {
-          progressCallback->Execute(nullptr, vtkCommand::ProgressEvent, (void*)&progress);
-        }
-      }
+  for (DecodingGroup& decodingBatch : decodingBatches)
+  {
+    if (!decodingBatch.ErrorMessage.empty())
+    {
+      vtkErrorWithObjectMacro(videoStreamSequenceNode, "Decoding failed! " << decodingBatch.ErrorMessage);
+      return false;
     }
   }
+  outputImageData->Modified();
   return true;
 }
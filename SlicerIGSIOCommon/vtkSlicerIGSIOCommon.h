@@ -37,6 +37,14 @@ class vtkMRMLSequenceNode;
 class vtkMRMLSequenceBrowserNode;
 class vtkGenericVideoReader;
 class vtkGenericVideoWriter;
+class vtkImageData;
+class vtkSlicerIGSIOEncoderState;
+class vtkSlicerIGSIOEncodingJob;
+class vtkSlicerIGSIOEncodingPlan;
+class vtkSlicerIGSIOEncodingStatistics;
+class vtkSlicerIGSIOKeyFramePolicy;
+class vtkStreamingVolumeCodec;
+class vtkStreamingVolumeFrame;
 
 #include <vtkSmartPointer.h>
 #include <map>
@@ -50,13 +58,56 @@ public:
   // Utility functions
   //----------------------------------------------------------------------------
 
-  static bool TrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* sequenceNode);
-
-  static bool TrackedFrameListToSequenceBrowser(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceBrowserNode* sequenceBrowserNode);
+  /// Add the valid frames of the tracked frame list to the sequence as volume nodes.
+  /// The images, geometry and index values of the frames are read in parallel, using one thread per core,
+  /// then the data nodes are created and inserted on the calling thread in a single modification of the sequence node.
+  /// If consumeTrackedFrames is true, each frame is removed from the tracked frame list as soon as it is converted,
+  /// so that each image buffer is released as soon as its copy is added to the sequence and the list is empty when the function returns.
+  static bool TrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* sequenceNode,
+    bool consumeTrackedFrames = false);
+
+  /// Add the video and transform sequences of the tracked frame list to the sequence browser.
+  /// See TrackedFrameListToVolumeSequence for consumeTrackedFrames.
+  /// If compactTransformSequences is true, the transforms of each tool are stored in a compact
+  /// vtkSlicerIGSIOTransformSequence instead of creating a linear transform node for every frame.
+  /// The master sequence of the browser is always stored as data nodes, so if the list contains no valid frames
+  /// for the video sequence, the first transform is not compact. The compact sequences rely on vtkSlicerVideoUtilLogic
+  /// to update their proxy nodes and to expand them when the scene is saved.
+  static bool TrackedFrameListToSequenceBrowser(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+    bool consumeTrackedFrames = false, bool compactTransformSequences = false);
 
   static bool VolumeSequenceToTrackedFrameList(vtkMRMLSequenceNode* sequenceNode, vtkIGSIOTrackedFrameList* trackedFrameList);
 
-  static bool SequenceBrowserToTrackedFrameList(vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkIGSIOTrackedFrameList* trackedFrameList);
+  /// Add a tracked frame to the list for each item of the master sequence of the browser, containing the images and
+  /// transforms of the synchronized sequences at that item.
+  /// By default, each item is selected in the browser and the frame is read from the proxy nodes.
+  /// If directExport is true, the data nodes are read from the item of each synchronized sequence with the closest index value
+  /// to the master item, without changing the selected item or the proxy nodes. Encoded frames are decoded sequentially with
+  /// one decoder per sequence. In both modes, ImageToWorld is ParentToWorld * IJKToRAS.
+  static bool SequenceBrowserToTrackedFrameList(vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkIGSIOTrackedFrameList* trackedFrameList,
+    bool directExport = false);
+
+  /// Name of the sequence node attribute that marks a video stream as monochrome ("true" or "false").
+  /// It is set by EncodeVideoSequence if all of the encoded frames were single component images,
+  /// and by TrackedFrameListToVolumeSequence from the "Monochrome" field of the tracked frame list.
+  static const char* GetMonochromeAttributeName() { return "IGSIO.Monochrome"; };
+
+  /// Name of the sequence node or storage node attribute that selects how the encoded frames are decoded:
+  /// "Luma" decodes only the luma of RGB frames into single component images, "RGB" decodes color images.
+  /// If the attribute is not set, monochrome streams are decoded as luma.
+  static const char* GetDecodeModeAttributeName() { return "IGSIO.DecodeMode"; };
+
+  /// Returns true if the sequence is marked as a monochrome video stream.
+  static bool IsMonochromeSequence(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Returns true if the encoded frames of the sequence should be decoded into single component luma images.
+  static bool IsLumaOnlyDecoding(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Decode the frame into the image. The image is allocated with the dimensions of the frame.
+  /// If lumaOnly is enabled, 8-bit RGB frames are stored as single component luma images, which need a third
+  /// of the memory of the color image.
+  static bool DecodeStreamingVolumeFrame(vtkStreamingVolumeCodec* decoder, vtkStreamingVolumeFrame* frame, vtkImageData* imageData,
+    bool lumaOnly = false);
 
   // Python wrapped function for ReEncodeVideoSequence
   static bool ReEncodeVideoSequence(vtkMRMLSequenceNode* videoStreamSequenceNode,
@@ -65,11 +116,66 @@ public:
     return vtkSlicerIGSIOCommon::ReEncodeVideoSequence(videoStreamSequenceNode, startIndex, endIndex, codecFourCC, std::map<std::string, std::string>());
   }
 
+  /// Encode the frames in the specified range of the input sequence and store the result in the output sequence.
+  /// The input is split into blocks that start with a keyframe. Blocks that need to be re-encoded are encoded in parallel,
+  /// each with its own codec instance, and the results are added to the output sequence in order.
+  /// Blocks are only split where the input starts a new keyframe, so parallel encoding does not add keyframes.
+  /// The number of threads is specified by the encoding job (see vtkSlicerIGSIOEncodingJob::SetNumberOfThreads).
+  /// If the output is a different sequence, the blocks that don't need to be re-encoded are added to the output
+  /// by sharing the existing frames, without decoding or encoding.
+  /// If an encoding job is specified, it can be used to cancel the encoding and to resume from a checkpoint.
+  /// If a keyframe policy is specified, keyframes are inserted to limit the distance between keyframes.
+  /// If statistics are specified, they are reset and filled with the latency of each stage and the size of each output frame.
+  /// Returns false if the encoding failed or was cancelled.
   static bool EncodeVideoSequence(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode,
     int startIndex, int endIndex,
     std::string codecFourCC,
     std::map<std::string, std::string> codecParameters,
-    bool forceReEncoding = false, bool minimalReEncoding = false, vtkCallbackCommand* progressCallback = nullptr);
+    bool forceReEncoding = false, bool minimalReEncoding = false, vtkCallbackCommand* progressCallback = nullptr,
+    vtkSlicerIGSIOEncodingJob* encodingJob = nullptr, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy = nullptr,
+    vtkSlicerIGSIOEncodingStatistics* statistics = nullptr);
+
+  // Python wrapped function for EncodeVideoSequence
+  static bool EncodeVideoSequence(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode,
+    int startIndex = 0, int endIndex = -1, std::string codecFourCC = "", bool forceReEncoding = false, bool minimalReEncoding = false,
+    vtkSlicerIGSIOEncodingJob* encodingJob = nullptr, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy = nullptr,
+    vtkSlicerIGSIOEncodingStatistics* statistics = nullptr)
+  {
+    return vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, startIndex, endIndex, codecFourCC,
+      std::map<std::string, std::string>(), forceReEncoding, minimalReEncoding, nullptr, encodingJob, keyFramePolicy, statistics);
+  }
+
+  /// Encode all of the video (streaming volume) sequences in the sequence browser in-place.
+  /// The sequences are encoded together by the same worker threads, and the progress is reported for all sequences combined.
+  /// If the codec is not specified, each sequence keeps its current codec.
+  /// If an encoding job is specified, it can be used to cancel the encoding of all sequences.
+  /// The keyframe policy is applied to each sequence separately. The statistics contain the frames of all sequences.
+  static bool EncodeSequenceBrowser(vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+    std::string codecFourCC,
+    std::map<std::string, std::string> codecParameters,
+    bool forceReEncoding = false, bool minimalReEncoding = false, vtkCallbackCommand* progressCallback = nullptr,
+    vtkSlicerIGSIOEncodingJob* encodingJob = nullptr, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy = nullptr,
+    vtkSlicerIGSIOEncodingStatistics* statistics = nullptr);
+
+  // Python wrapped function for EncodeSequenceBrowser
+  static bool EncodeSequenceBrowser(vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+    std::string codecFourCC = "", bool forceReEncoding = false, bool minimalReEncoding = false,
+    vtkSlicerIGSIOEncodingJob* encodingJob = nullptr, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy = nullptr,
+    vtkSlicerIGSIOEncodingStatistics* statistics = nullptr)
+  {
+    return vtkSlicerIGSIOCommon::EncodeSequenceBrowser(sequenceBrowserNode, codecFourCC, std::map<std::string, std::string>(),
+      forceReEncoding, minimalReEncoding, nullptr, encodingJob, keyFramePolicy, statistics);
+  }
+
+  /// Analyze the frames in the specified range of the input sequence without encoding them.
+  /// The plan contains the frame blocks that EncodeVideoSequence would use, the reasons for re-encoding each block,
+  /// and an estimate of the number of decode and encode operations.
+  /// If a keyframe policy is specified, blocks that do not satisfy the policy are re-encoded.
+  static bool PlanVideoSequenceEncoding(vtkMRMLSequenceNode* inputSequenceNode, vtkMRMLSequenceNode* outputSequenceNode,
+    int startIndex, int endIndex,
+    std::string codecFourCC,
+    bool forceReEncoding, bool minimalReEncoding,
+    vtkSlicerIGSIOEncodingPlan* encodingPlan, vtkSlicerIGSIOKeyFramePolicy* keyFramePolicy = nullptr);
 
   static bool ReEncodeVideoSequence(vtkMRMLSequenceNode* videoStreamSequenceNode,
     int startIndex, int endIndex,
@@ -81,6 +187,27 @@ public:
       startIndex, endIndex, codecFourCC, codecParameters,
       forceReEncoding, minimalReEncoding);
   }
+
+  /// Encode the frames that were added to the end of the sequence since the last call with the same encoder state.
+  /// The new frames continue the stream of the last encoded frame, so the cost is proportional to the number of new frames.
+  /// If the state is not valid for the sequence (see vtkSlicerIGSIOEncoderState), the whole sequence is re-encoded
+  /// with minimal re-encoding, and the state is initialized for the next call.
+  /// The optional encoding job specifies the codecs that require RGB input and the window of 16-bit frames.
+  static bool EncodeAppendedVideoFrames(vtkMRMLSequenceNode* videoStreamSequenceNode,
+    std::string codecFourCC,
+    std::map<std::string, std::string> codecParameters,
+    vtkSlicerIGSIOEncoderState* encoderState, vtkSlicerIGSIOEncodingJob* encodingJob = nullptr);
+
+  /// Decode the frames in the specified range of a video sequence into a single image with one slice per frame.
+  /// Slice k of the output contains the item startIndex + k * frameStride. All frames must be 2D images with the same
+  /// dimensions, scalar type and number of components. The output is allocated once before decoding.
+  /// Frames that depend on different keyframes are decoded in parallel. Consecutive keyframe groups are decoded in batches,
+  /// so that each thread decodes about the same number of frames with its own decoder instance.
+  /// Frames between the selected items that are needed as references are decoded but not stored.
+  /// If luma only decoding is enabled for the sequence (see IsLumaOnlyDecoding), RGB frames are stored as single component images.
+  /// If the number of threads is less than 1 (default), one thread is used for each hardware core.
+  static bool DecodeVideoSequence(vtkMRMLSequenceNode* videoStreamSequenceNode, vtkImageData* outputImageData,
+    int startIndex = 0, int endIndex = -1, int frameStride = 1, int numberOfThreads = 0);
 };
 
 #endif
\ No newline at end of file
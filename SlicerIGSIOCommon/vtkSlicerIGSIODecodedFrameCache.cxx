@@ -0,0 +1,488 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIODecodedFrameCache.h"
+#include "vtkSlicerIGSIOKeyFrameIndex.h"
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+#include <vtkStreamingVolumeFrame.h>
+
+// MRML includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIODecodedFrameCache);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIODecodedFrameCache::vtkInternal
+{
+public:
+  vtkInternal()
+    : MaximumCacheBytes(512 * 1024 * 1024)
+    , CachedBytes(0)
+    , NumberOfHits(0)
+    , NumberOfMisses(0)
+  {
+  }
+
+  // Sequence node and item number
+  typedef std::pair<vtkMRMLSequenceNode*, int> ImageKey;
+
+  struct CacheEntry
+  {
+    ImageKey Key;
+    vtkWeakPointer<vtkStreamingVolumeFrame> Frame;
+    vtkSmartPointer<vtkImageData> ImageData;
+    vtkIdType Size;
+  };
+  typedef std::list<CacheEntry> CacheEntryList;
+
+  // Decoder that is used for all frames of a sequence, so that consecutive frames can be decoded without
+  // decoding the frames since the last keyframe again.
+  struct SequenceDecoder
+  {
+    vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+    std::string CodecFourCC;
+    vtkWeakPointer<vtkStreamingVolumeFrame> LastDecodedFrame;
+    int LastDecodedItemNumber;
+    SequenceDecoder()
+      : LastDecodedItemNumber(-1)
+    {
+    }
+  };
+
+  static vtkIdType GetImageSize(vtkImageData* imageData)
+  {
+    vtkDataArray* scalars = imageData->GetPointData() ? imageData->GetPointData()->GetScalars() : nullptr;
+    return scalars ? scalars->GetDataSize() * scalars->GetDataTypeSize() : 0;
+  }
+
+  // Must be called with the mutex locked
+  void RemoveEntry(CacheEntryList::iterator entryIt)
+  {
+    this->CachedBytes -= entryIt->Size;
+    this->EntryLookup.erase(entryIt->Key);
+    this->Entries.erase(entryIt);
+  }
+
+  // Must be called with the mutex locked
+  void RemoveLeastRecentlyUsedEntries()
+  {
+    while (this->CachedBytes > this->MaximumCacheBytes && !this->Entries.empty())
+    {
+      this->RemoveEntry(std::prev(this->Entries.end()));
+    }
+  }
+
+  // Get the streaming volume frame of the item, or nullptr if the data node is not a streaming volume
+  static vtkStreamingVolumeFrame* GetItemFrame(vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+  {
+    if (itemNumber < 0 || itemNumber >= sequenceNode->GetNumberOfDataNodes())
+    {
+      return nullptr;
+    }
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber));
+    return streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+  }
+
+  std::mutex Mutex;
+  CacheEntryList Entries; // Most recently used first
+  std::map<ImageKey, CacheEntryList::iterator> EntryLookup;
+  vtkIdType MaximumCacheBytes;
+  vtkIdType CachedBytes;
+  vtkIdType NumberOfHits;
+  vtkIdType NumberOfMisses;
+
+  // Held while decoding, since the decoders keep the state of the previously decoded frame
+  std::mutex DecodeMutex;
+  std::map<vtkMRMLSequenceNode*, SequenceDecoder> Decoders;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIODecodedFrameCache::vtkSlicerIGSIODecodedFrameCache()
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIODecodedFrameCache::~vtkSlicerIGSIODecodedFrameCache()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumCacheBytes: " << this->GetMaximumCacheBytes() << "\n";
+  os << indent << "CachedBytes: " << this->GetCachedBytes() << "\n";
+  os << indent << "NumberOfCachedImages: " << this->GetNumberOfCachedImages() << "\n";
+  os << indent << "Hits: " << this->GetNumberOfHits() << "\n";
+  os << indent << "Misses: " << this->GetNumberOfMisses() << "\n";
+  os << indent << "HitRate: " << this->GetHitRate() << "\n";
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIODecodedFrameCache* vtkSlicerIGSIODecodedFrameCache::GetInstance()
+{
+  static vtkSmartPointer<vtkSlicerIGSIODecodedFrameCache> instance = vtkSmartPointer<vtkSlicerIGSIODecodedFrameCache>::New();
+  return instance;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkSlicerIGSIODecodedFrameCache::GetDecodedImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+{
+  if (!sequenceNode)
+  {
+    vtkErrorMacro("GetDecodedImage: Invalid sequence node");
+    return nullptr;
+  }
+
+  vtkStreamingVolumeFrame* frame = vtkInternal::GetItemFrame(sequenceNode, itemNumber);
+  if (!frame)
+  {
+    return nullptr;
+  }
+
+  // Images that were decoded with a different decode mode are decoded again
+  bool lumaOnly = vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(sequenceNode);
+  int numberOfComponents = frame->GetNumberOfComponents();
+  if (lumaOnly && frame->GetVTKScalarType() == VTK_UNSIGNED_CHAR && numberOfComponents == 3)
+  {
+    numberOfComponents = 1;
+  }
+  vtkSmartPointer<vtkImageData> imageData = this->FindImage(sequenceNode, itemNumber, frame);
+  if (imageData && imageData->GetNumberOfScalarComponents() != numberOfComponents)
+  {
+    imageData = nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    if (imageData)
+    {
+      ++this->Internal->NumberOfHits;
+      return imageData;
+    }
+    ++this->Internal->NumberOfMisses;
+  }
+
+  std::lock_guard<std::mutex> decodeLock(this->Internal->DecodeMutex);
+  vtkInternal::SequenceDecoder& decoder = this->Internal->Decoders[sequenceNode];
+  std::string codecFourCC = frame->GetCodecFourCC();
+  if (!decoder.Codec || decoder.CodecFourCC != codecFourCC)
+  {
+    decoder.Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+      vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
+    decoder.CodecFourCC = codecFourCC;
+    decoder.LastDecodedFrame = nullptr;
+    decoder.LastDecodedItemNumber = -1;
+    if (!decoder.Codec)
+    {
+      vtkErrorMacro("GetDecodedImage: Could not find codec: " << codecFourCC);
+      return nullptr;
+    }
+  }
+
+  // Find the frames that need to be decoded before the requested frame: back to the previous keyframe,
+  // or to the last frame that was decoded by the decoder.
+  std::vector<std::pair<int, vtkStreamingVolumeFrame*> > framesToDecode;
+  int keyFrameItemNumber = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode)->GetKeyFrameItemNumber(itemNumber);
+  if (keyFrameItemNumber >= 0)
+  {
+    // All frames since the keyframe are stored in consecutive items, so they can be found without following the chain
+    int firstItemNumber = keyFrameItemNumber;
+    if (decoder.LastDecodedFrame && decoder.LastDecodedItemNumber >= keyFrameItemNumber && decoder.LastDecodedItemNumber < itemNumber
+      && vtkInternal::GetItemFrame(sequenceNode, decoder.LastDecodedItemNumber) == decoder.LastDecodedFrame)
+    {
+      firstItemNumber = decoder.LastDecodedItemNumber + 1;
+    }
+    for (int i = itemNumber; i >= firstItemNumber; --i)
+    {
+      framesToDecode.push_back(std::make_pair(i, vtkInternal::GetItemFrame(sequenceNode, i)));
+    }
+  }
+
+  // Otherwise the chain is followed. The item number of each frame is tracked as long as the frames are stored
+  // in consecutive items, so that they can also be cached.
+  int currentItemNumber = itemNumber;
+  vtkStreamingVolumeFrame* currentFrame = framesToDecode.empty() ? frame : nullptr;
+  while (currentFrame)
+  {
+    framesToDecode.push_back(std::make_pair(currentItemNumber, currentFrame));
+    vtkStreamingVolumeFrame* previousFrame = currentFrame->GetPreviousFrame();
+    if (currentFrame->IsKeyFrame() || (previousFrame && previousFrame == decoder.LastDecodedFrame))
+    {
+      break;
+    }
+
+    if (currentItemNumber > 0 && vtkInternal::GetItemFrame(sequenceNode, currentItemNumber - 1) == previousFrame)
+    {
+      --currentItemNumber;
+    }
+    else
+    {
+      currentItemNumber = -1;
+    }
+    currentFrame = previousFrame;
+  }
+
+  for (std::vector<std::pair<int, vtkStreamingVolumeFrame*> >::reverse_iterator frameIt = framesToDecode.rbegin();
+    frameIt != framesToDecode.rend(); ++frameIt)
+  {
+    vtkStreamingVolumeFrame* frameToDecode = frameIt->second;
+    vtkSmartPointer<vtkImageData> decodedImageData = vtkSmartPointer<vtkImageData>::New();
+    if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(decoder.Codec, frameToDecode, decodedImageData, lumaOnly))
+    {
+      vtkErrorMacro("GetDecodedImage: Error decoding frame of item " << itemNumber);
+      decoder.LastDecodedFrame = nullptr;
+      decoder.LastDecodedItemNumber = -1;
+      return nullptr;
+    }
+    decoder.LastDecodedFrame = frameToDecode;
+    decoder.LastDecodedItemNumber = frameIt->first;
+
+    if (frameIt->first >= 0)
+    {
+      this->AddImage(sequenceNode, frameIt->first, frameToDecode, decodedImageData);
+    }
+    imageData = decodedImageData;
+  }
+  return imageData;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIODecodedFrameCache::UpdateProxyNode(vtkMRMLSequenceBrowserNode* browserNode, vtkMRMLSequenceNode* sequenceNode)
+{
+  if (!browserNode || !sequenceNode)
+  {
+    return false;
+  }
+
+  // Decoded images must not be written back to the sequence
+  if (browserNode->GetSaveChanges(sequenceNode))
+  {
+    return false;
+  }
+
+  vtkMRMLStreamingVolumeNode* proxyNode = vtkMRMLStreamingVolumeNode::SafeDownCast(browserNode->GetProxyNode(sequenceNode));
+  vtkMRMLSequenceNode* masterSequenceNode = browserNode->GetMasterSequenceNode();
+  int selectedItemNumber = browserNode->GetSelectedItemNumber();
+  if (!proxyNode || !masterSequenceNode || selectedItemNumber < 0 || selectedItemNumber >= masterSequenceNode->GetNumberOfDataNodes())
+  {
+    return false;
+  }
+
+  int itemNumber = selectedItemNumber;
+  if (sequenceNode != masterSequenceNode)
+  {
+    itemNumber = sequenceNode->GetItemNumberFromIndexValue(masterSequenceNode->GetNthIndexValue(selectedItemNumber));
+  }
+
+  vtkSmartPointer<vtkImageData> imageData = this->GetDecodedImage(sequenceNode, itemNumber);
+  if (!imageData)
+  {
+    return false;
+  }
+
+  // The cached image is shared by all users of the cache, so the proxy node gets its own image object
+  vtkSmartPointer<vtkImageData> proxyImageData = vtkSmartPointer<vtkImageData>::New();
+  proxyImageData->ShallowCopy(imageData);
+  proxyNode->SetAndObserveImageData(proxyImageData);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkSlicerIGSIODecodedFrameCache::FindImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber, vtkStreamingVolumeFrame* frame)
+{
+  if (!frame)
+  {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  std::map<vtkInternal::ImageKey, vtkInternal::CacheEntryList::iterator>::iterator lookupIt =
+    this->Internal->EntryLookup.find(std::make_pair(sequenceNode, itemNumber));
+  if (lookupIt == this->Internal->EntryLookup.end())
+  {
+    return nullptr;
+  }
+
+  vtkInternal::CacheEntryList::iterator entryIt = lookupIt->second;
+  if (entryIt->Frame != frame)
+  {
+    // The item has been replaced since the image was decoded
+    this->Internal->RemoveEntry(entryIt);
+    return nullptr;
+  }
+
+  // Move to the front of the list as the most recently used image
+  this->Internal->Entries.splice(this->Internal->Entries.begin(), this->Internal->Entries, entryIt);
+  return entryIt->ImageData;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::AddImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber, vtkStreamingVolumeFrame* frame, vtkImageData* imageData)
+{
+  if (!sequenceNode || !frame || !imageData)
+  {
+    return;
+  }
+
+  vtkInternal::CacheEntry entry;
+  entry.Key = std::make_pair(sequenceNode, itemNumber);
+  entry.Frame = frame;
+  entry.ImageData = imageData;
+  entry.Size = vtkInternal::GetImageSize(imageData);
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  std::map<vtkInternal::ImageKey, vtkInternal::CacheEntryList::iterator>::iterator lookupIt = this->Internal->EntryLookup.find(entry.Key);
+  if (lookupIt != this->Internal->EntryLookup.end())
+  {
+    this->Internal->RemoveEntry(lookupIt->second);
+  }
+  if (entry.Size > this->Internal->MaximumCacheBytes)
+  {
+    return;
+  }
+
+  this->Internal->Entries.push_front(entry);
+  this->Internal->EntryLookup[entry.Key] = this->Internal->Entries.begin();
+  this->Internal->CachedBytes += entry.Size;
+  this->Internal->RemoveLeastRecentlyUsedEntries();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::RemoveSequence(vtkMRMLSequenceNode* sequenceNode)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    vtkInternal::CacheEntryList::iterator entryIt = this->Internal->Entries.begin();
+    while (entryIt != this->Internal->Entries.end())
+    {
+      vtkInternal::CacheEntryList::iterator currentEntryIt = entryIt++;
+      if (currentEntryIt->Key.first == sequenceNode)
+      {
+        this->Internal->RemoveEntry(currentEntryIt);
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> decodeLock(this->Internal->DecodeMutex);
+  this->Internal->Decoders.erase(sequenceNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::Clear()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Entries.clear();
+    this->Internal->EntryLookup.clear();
+    this->Internal->CachedBytes = 0;
+  }
+
+  std::lock_guard<std::mutex> decodeLock(this->Internal->DecodeMutex);
+  this->Internal->Decoders.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::SetMaximumCacheBytes(vtkIdType maximumCacheBytes)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    if (this->Internal->MaximumCacheBytes == maximumCacheBytes)
+    {
+      return;
+    }
+    this->Internal->MaximumCacheBytes = maximumCacheBytes;
+    this->Internal->RemoveLeastRecentlyUsedEntries();
+  }
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIODecodedFrameCache::GetMaximumCacheBytes()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->MaximumCacheBytes;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIODecodedFrameCache::GetCachedBytes()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->CachedBytes;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIODecodedFrameCache::GetNumberOfCachedImages()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return static_cast<int>(this->Internal->Entries.size());
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIODecodedFrameCache::GetNumberOfHits()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfHits;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIODecodedFrameCache::GetNumberOfMisses()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfMisses;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIODecodedFrameCache::GetHitRate()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  vtkIdType total = this->Internal->NumberOfHits + this->Internal->NumberOfMisses;
+  return total > 0 ? static_cast<double>(this->Internal->NumberOfHits) / total : 0.0;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIODecodedFrameCache::ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->NumberOfHits = 0;
+  this->Internal->NumberOfMisses = 0;
+}
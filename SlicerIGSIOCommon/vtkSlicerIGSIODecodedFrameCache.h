@@ -0,0 +1,120 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIODecodedFrameCache_h
+#define __vtkSlicerIGSIODecodedFrameCache_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+class vtkMRMLSequenceBrowserNode;
+class vtkMRMLSequenceNode;
+class vtkStreamingVolumeFrame;
+
+/// Least recently used cache of decoded images of streaming volume sequences.
+///
+/// Decoding an inter-frame encoded frame requires decoding all of the frames since the previous keyframe,
+/// so moving back and forth in a sequence repeats the same decoding work. The cache keeps the decoded images,
+/// keyed by sequence node and item number, so that frames that were already decoded can be displayed immediately.
+/// The frames that are decoded on the way to the requested frame are also added to the cache. The frames to decode
+/// are found using the keyframe index of the sequence (vtkSlicerIGSIOKeyFrameIndex).
+///
+/// Each cached image is stored together with the encoded frame that it was decoded from. If the data node
+/// of the sequence is replaced by a different frame, the cached image is no longer returned.
+/// The total size of the cached images is limited by MaximumCacheBytes; the least recently used images are removed first.
+/// Cached images are shared with the callers and must not be modified.
+/// All methods are thread safe, but the methods that access MRML nodes must be called on the main thread.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIODecodedFrameCache : public vtkObject
+{
+public:
+  static vtkSlicerIGSIODecodedFrameCache* New();
+  vtkTypeMacro(vtkSlicerIGSIODecodedFrameCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Cache that is shared by the modules of SlicerIGSIO.
+  static vtkSlicerIGSIODecodedFrameCache* GetInstance();
+
+  /// Get the decoded image of the specified item of the sequence.
+  /// If the image is not in the cache, the frame is decoded and added to the cache.
+  /// Returns nullptr if the data node is not an encoded streaming volume, or if the frame could not be decoded.
+  /// Must be called on the main thread.
+  vtkSmartPointer<vtkImageData> GetDecodedImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber);
+
+  /// Set the image of the proxy node of the sequence to the decoded image of the selected item of the browser.
+  /// The proxy node is not modified if it is not a streaming volume node, or if the browser saves the changes of the
+  /// proxy node back to the sequence, so that decoded images are never written into the sequence.
+  /// Returns true if the proxy node was updated. Must be called on the main thread.
+  bool UpdateProxyNode(vtkMRMLSequenceBrowserNode* browserNode, vtkMRMLSequenceNode* sequenceNode);
+
+  /// Get the cached image of the item, if it was decoded from the specified frame. Does not decode anything.
+  /// The hit and miss counters are not updated.
+  vtkSmartPointer<vtkImageData> FindImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber, vtkStreamingVolumeFrame* frame);
+
+  /// Add the image that was decoded from the frame of the item to the cache.
+  /// An existing image of the item is replaced.
+  void AddImage(vtkMRMLSequenceNode* sequenceNode, int itemNumber, vtkStreamingVolumeFrame* frame, vtkImageData* imageData);
+
+  /// Remove all cached images and decoders of the sequence.
+  /// Should be called when the sequence node is removed from the scene.
+  void RemoveSequence(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Remove all cached images and decoders.
+  void Clear();
+
+  /// Maximum total size of the cached images. Default is 512 MB.
+  void SetMaximumCacheBytes(vtkIdType maximumCacheBytes);
+  vtkIdType GetMaximumCacheBytes();
+
+  /// Total size of the images that are currently in the cache.
+  vtkIdType GetCachedBytes();
+
+  /// Number of images that are currently in the cache.
+  int GetNumberOfCachedImages();
+
+  //@{
+  /// Number of images requested by GetDecodedImage that were found in the cache (hits) or had to be decoded (misses).
+  vtkIdType GetNumberOfHits();
+  vtkIdType GetNumberOfMisses();
+  //@}
+
+  /// Ratio of requested images that were found in the cache. 0 if nothing has been requested.
+  double GetHitRate();
+
+  /// Reset the hit and miss counters.
+  void ResetStatistics();
+
+protected:
+  vtkSlicerIGSIODecodedFrameCache();
+  ~vtkSlicerIGSIODecodedFrameCache() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIODecodedFrameCache(const vtkSlicerIGSIODecodedFrameCache&); // Not implemented
+  void operator=(const vtkSlicerIGSIODecodedFrameCache&);                  // Not implemented
+};
+
+#endif // __vtkSlicerIGSIODecodedFrameCache_h
@@ -0,0 +1,185 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOEncoderState.h"
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeFrame.h>
+
+// MRML includes
+#include <vtkMRMLSequenceNode.h>
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOEncoderState);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOEncoderState::vtkInternal
+{
+public:
+  vtkWeakPointer<vtkMRMLSequenceNode> SequenceNode;
+  std::map<std::string, std::string> CodecParameters;
+  vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+  std::vector<vtkStreamingVolumeFrame*> EncodedFrames;
+  vtkSmartPointer<vtkStreamingVolumeFrame> LastEncodedFrame;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncoderState::vtkSlicerIGSIOEncoderState()
+  : CodecFourCC("")
+  , LastEncodedItemNumber(-1)
+  , LastEncodedIndexValue("")
+  , EncodingWindow(0.0)
+  , EncodingLevel(0.0)
+  , NumberOfFramesEncodedInLastUpdate(0)
+  , LastUpdateWasFull(false)
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncoderState::~vtkSlicerIGSIOEncoderState()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "SequenceNode: " << (this->Internal->SequenceNode ? this->Internal->SequenceNode->GetID() : "(none)") << "\n";
+  os << indent << "CodecFourCC: " << this->CodecFourCC << "\n";
+  os << indent << "Codec: " << (this->Internal->Codec ? "active" : "(none)") << "\n";
+  os << indent << "NumberOfEncodedFrames: " << this->Internal->EncodedFrames.size() << "\n";
+  os << indent << "LastEncodedItemNumber: " << this->LastEncodedItemNumber << "\n";
+  os << indent << "LastEncodedIndexValue: " << this->LastEncodedIndexValue << "\n";
+  os << indent << "EncodingWindow: " << this->EncodingWindow << "\n";
+  os << indent << "EncodingLevel: " << this->EncodingLevel << "\n";
+  os << indent << "NumberOfFramesEncodedInLastUpdate: " << this->NumberOfFramesEncodedInLastUpdate << "\n";
+  os << indent << "LastUpdateWasFull: " << (this->LastUpdateWasFull ? "true" : "false") << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::Reset()
+{
+  this->Internal->SequenceNode = nullptr;
+  this->Internal->CodecParameters.clear();
+  this->Internal->Codec = nullptr;
+  this->Internal->EncodedFrames.clear();
+  this->Internal->LastEncodedFrame = nullptr;
+  this->CodecFourCC = "";
+  this->LastEncodedItemNumber = -1;
+  this->LastEncodedIndexValue = "";
+  this->EncodingWindow = 0.0;
+  this->EncodingLevel = 0.0;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncoderState::IsInitialized()
+{
+  return this->Internal->SequenceNode && this->Internal->LastEncodedFrame && this->LastEncodedItemNumber >= 0;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* vtkSlicerIGSIOEncoderState::GetSequenceNode()
+{
+  return this->Internal->SequenceNode;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::SetSequenceNode(vtkMRMLSequenceNode* sequenceNode)
+{
+  this->Internal->SequenceNode = sequenceNode;
+}
+
+//---------------------------------------------------------------------------
+std::map<std::string, std::string> vtkSlicerIGSIOEncoderState::GetCodecParameters()
+{
+  return this->Internal->CodecParameters;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::SetCodecParameters(std::map<std::string, std::string> codecParameters)
+{
+  this->Internal->CodecParameters = codecParameters;
+}
+
+//---------------------------------------------------------------------------
+vtkStreamingVolumeCodec* vtkSlicerIGSIOEncoderState::GetCodec()
+{
+  return this->Internal->Codec;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::SetCodec(vtkStreamingVolumeCodec* codec)
+{
+  this->Internal->Codec = codec;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::ClearEncodedFrames()
+{
+  this->Internal->EncodedFrames.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::AddEncodedFrame(vtkStreamingVolumeFrame* frame)
+{
+  this->Internal->EncodedFrames.push_back(frame);
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncoderState::GetNumberOfEncodedFrames()
+{
+  return static_cast<int>(this->Internal->EncodedFrames.size());
+}
+
+//---------------------------------------------------------------------------
+vtkStreamingVolumeFrame* vtkSlicerIGSIOEncoderState::GetNthEncodedFrame(int n)
+{
+  if (n < 0 || n >= static_cast<int>(this->Internal->EncodedFrames.size()))
+  {
+    vtkErrorMacro("GetNthEncodedFrame: Invalid frame " << n);
+    return nullptr;
+  }
+  return this->Internal->EncodedFrames[n];
+}
+
+//---------------------------------------------------------------------------
+vtkStreamingVolumeFrame* vtkSlicerIGSIOEncoderState::GetLastEncodedFrame()
+{
+  return this->Internal->LastEncodedFrame;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncoderState::SetLastEncodedFrame(vtkStreamingVolumeFrame* frame)
+{
+  this->Internal->LastEncodedFrame = frame;
+}
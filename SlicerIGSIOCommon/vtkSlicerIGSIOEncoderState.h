@@ -0,0 +1,127 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOEncoderState_h
+#define __vtkSlicerIGSIOEncoderState_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <map>
+#include <string>
+
+class vtkMRMLSequenceNode;
+class vtkStreamingVolumeCodec;
+class vtkStreamingVolumeFrame;
+
+/// State of the encoder for a sequence that is encoded incrementally by vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames.
+///
+/// The state remembers the last frame that was encoded and keeps the codec instance that encoded it, so frames that
+/// are appended to the end of the sequence continue the existing group of pictures and only the new frames are encoded.
+/// The state remembers the encoded frame of each item, and is invalidated automatically if the sequence, codec or codec
+/// parameters change, or if any of the encoded items has been removed or replaced since the last update.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOEncoderState : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOEncoderState* New();
+  vtkTypeMacro(vtkSlicerIGSIOEncoderState, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Forget the encoded frames, so that the next call re-encodes the whole sequence if needed.
+  void Reset();
+
+  /// Returns true if the state contains an encoded frame.
+  bool IsInitialized();
+
+  /// Sequence that is encoded using this state. The sequence is not kept alive by the state.
+  vtkMRMLSequenceNode* GetSequenceNode();
+  void SetSequenceNode(vtkMRMLSequenceNode* sequenceNode);
+
+  /// FourCC of the codec that encoded the frames.
+  vtkGetMacro(CodecFourCC, std::string);
+  vtkSetMacro(CodecFourCC, std::string);
+
+  /// Codec parameters that were used to encode the frames.
+  std::map<std::string, std::string> GetCodecParameters();
+  void SetCodecParameters(std::map<std::string, std::string> codecParameters);
+
+  /// Codec instance that encoded the last frame. Encoding the next frame with this codec continues the same stream.
+  /// If nullptr, the next frame is encoded by a new codec instance, starting with a keyframe.
+  vtkStreamingVolumeCodec* GetCodec();
+  void SetCodec(vtkStreamingVolumeCodec* codec);
+
+  //@{
+  /// Encoded frames of the items of the sequence, in order, used to detect items that have been replaced.
+  /// The frames are only compared with the current frames of the sequence, so they are not kept alive by the state.
+  void ClearEncodedFrames();
+  void AddEncodedFrame(vtkStreamingVolumeFrame* frame);
+  int GetNumberOfEncodedFrames();
+  vtkStreamingVolumeFrame* GetNthEncodedFrame(int n);
+  //@}
+
+  /// Encoded frame of the last item in the sequence. The frame is kept alive, since the next appended frame references it.
+  vtkStreamingVolumeFrame* GetLastEncodedFrame();
+  void SetLastEncodedFrame(vtkStreamingVolumeFrame* frame);
+
+  /// Item number and index value of the last encoded frame.
+  vtkGetMacro(LastEncodedItemNumber, int);
+  vtkSetMacro(LastEncodedItemNumber, int);
+  vtkGetMacro(LastEncodedIndexValue, std::string);
+  vtkSetMacro(LastEncodedIndexValue, std::string);
+
+  /// Window and level that map the 16-bit frames of the sequence to 8 bits, so that all appended frames use the same mapping.
+  /// The window is not positive if no window has been determined yet.
+  vtkGetMacro(EncodingWindow, double);
+  vtkSetMacro(EncodingWindow, double);
+  vtkGetMacro(EncodingLevel, double);
+  vtkSetMacro(EncodingLevel, double);
+
+  /// Number of frames that were encoded by the last update, and whether the whole sequence had to be re-analyzed.
+  vtkGetMacro(NumberOfFramesEncodedInLastUpdate, int);
+  vtkSetMacro(NumberOfFramesEncodedInLastUpdate, int);
+  vtkGetMacro(LastUpdateWasFull, bool);
+  vtkSetMacro(LastUpdateWasFull, bool);
+
+protected:
+  std::string CodecFourCC;
+  int LastEncodedItemNumber;
+  std::string LastEncodedIndexValue;
+  double EncodingWindow;
+  double EncodingLevel;
+  int NumberOfFramesEncodedInLastUpdate;
+  bool LastUpdateWasFull;
+
+protected:
+  vtkSlicerIGSIOEncoderState();
+  ~vtkSlicerIGSIOEncoderState() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOEncoderState(const vtkSlicerIGSIOEncoderState&); // Not implemented
+  void operator=(const vtkSlicerIGSIOEncoderState&);             // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOEncoderState_h
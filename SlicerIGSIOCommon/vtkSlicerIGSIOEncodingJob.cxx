@@ -0,0 +1,128 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOEncodingJob.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <atomic>
+#include <set>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOEncodingJob);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOEncodingJob::vtkInternal
+{
+public:
+  vtkInternal()
+    : Cancelled(false)
+    , RGBInputCodecFourCCs({ "RV24" })
+  {
+  }
+
+  std::atomic<bool> Cancelled;
+  std::set<std::string> RGBInputCodecFourCCs;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingJob::vtkSlicerIGSIOEncodingJob()
+  : RollbackOnCancel(true)
+  , ResumeFromCheckpoint(false)
+  , NumberOfThreads(0)
+  , PipelineQueueDepth(4)
+  , EncodingWindow(0.0)
+  , EncodingLevel(0.0)
+  , CheckpointIndexValue("")
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingJob::~vtkSlicerIGSIOEncodingJob()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingJob::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Cancelled: " << (this->Internal->Cancelled ? "true" : "false") << "\n";
+  os << indent << "RollbackOnCancel: " << (this->RollbackOnCancel ? "true" : "false") << "\n";
+  os << indent << "ResumeFromCheckpoint: " << (this->ResumeFromCheckpoint ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "PipelineQueueDepth: " << this->PipelineQueueDepth << "\n";
+  os << indent << "RGBInputCodecFourCCs:";
+  for (const std::string& codecFourCC : this->Internal->RGBInputCodecFourCCs)
+  {
+    os << " " << codecFourCC;
+  }
+  os << "\n";
+  os << indent << "EncodingWindow: " << this->EncodingWindow << "\n";
+  os << indent << "EncodingLevel: " << this->EncodingLevel << "\n";
+  os << indent << "CheckpointIndexValue: " << this->CheckpointIndexValue << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingJob::Cancel()
+{
+  this->Internal->Cancelled = true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncodingJob::IsCancelled()
+{
+  return this->Internal->Cancelled;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingJob::Reset()
+{
+  this->Internal->Cancelled = false;
+  this->CheckpointIndexValue = "";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingJob::SetCodecRequiresRGBInput(const std::string& codecFourCC, bool required)
+{
+  if (required == this->GetCodecRequiresRGBInput(codecFourCC))
+  {
+    return;
+  }
+  if (required)
+  {
+    this->Internal->RGBInputCodecFourCCs.insert(codecFourCC);
+  }
+  else
+  {
+    this->Internal->RGBInputCodecFourCCs.erase(codecFourCC);
+  }
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncodingJob::GetCodecRequiresRGBInput(const std::string& codecFourCC)
+{
+  return this->Internal->RGBInputCodecFourCCs.count(codecFourCC) > 0;
+}
@@ -0,0 +1,131 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOEncodingJob_h
+#define __vtkSlicerIGSIOEncodingJob_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+/// Controls a single call to vtkSlicerIGSIOCommon::EncodeVideoSequence.
+///
+/// Cancel() can be called from the progress callback or from another thread. The encoder checks the
+/// cancellation flag between frames and stops as soon as possible.
+///
+/// If RollbackOnCancel is enabled (default), a cancelled encoding leaves the output sequence exactly as it
+/// was before the call. Otherwise, the output contains a consistent prefix: all frame blocks up to the
+/// checkpoint are completely encoded, and none of the later frames have been modified.
+///
+/// After each frame block is added to the output, the index value of its last frame is stored in the
+/// output sequence as the checkpoint attribute (see GetCheckpointAttributeName()).
+/// The attribute is only written if a job is specified, and it is removed when encoding completes or fails
+/// with an error. If ResumeFromCheckpoint is enabled, encoding starts after the frame in the checkpoint,
+/// so a cancelled job can be continued.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOEncodingJob : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOEncodingJob* New();
+  vtkTypeMacro(vtkSlicerIGSIOEncodingJob, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Request the encoding to stop. Thread safe.
+  void Cancel();
+
+  /// Returns true if Cancel() has been called since the last Reset(). Thread safe.
+  bool IsCancelled();
+
+  /// Clear the cancellation flag so that the job can be used again.
+  void Reset();
+
+  /// If enabled, the output sequence is restored to its original state when the encoding is cancelled.
+  /// Default is true.
+  vtkSetMacro(RollbackOnCancel, bool);
+  vtkGetMacro(RollbackOnCancel, bool);
+  vtkBooleanMacro(RollbackOnCancel, bool);
+
+  /// If enabled, encoding continues after the checkpoint that is stored in the output sequence.
+  /// Default is false.
+  vtkSetMacro(ResumeFromCheckpoint, bool);
+  vtkGetMacro(ResumeFromCheckpoint, bool);
+  vtkBooleanMacro(ResumeFromCheckpoint, bool);
+
+  /// Number of worker threads that encode the frame blocks.
+  /// If the number of threads is less than 1 (default), one thread is used for each hardware core.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Maximum number of frames that can be queued between the decode, pixel conversion and encode stages
+  /// of each encoded block. The stages run concurrently as tasks of the encoding threads, so transcoding is limited
+  /// by the slowest stage instead of the sum of all stages. No additional threads are started.
+  /// If the depth is less than 1, or there are fewer encoding threads than stages, the stages are run sequentially.
+  /// Default is 4.
+  vtkSetMacro(PipelineQueueDepth, int);
+  vtkGetMacro(PipelineQueueDepth, int);
+
+  /// Set whether the codec only accepts 8-bit RGB images. Single component 8-bit and 16-bit images are expanded to RGB
+  /// before they are encoded by these codecs, and passed unchanged to all other codecs. By default only RV24 requires RGB input.
+  void SetCodecRequiresRGBInput(const std::string& codecFourCC, bool required);
+  bool GetCodecRequiresRGBInput(const std::string& codecFourCC);
+
+  /// Window and level that are used to map 16-bit single component images to 8 bits before they are
+  /// expanded to RGB (see SetCodecRequiresRGBInput).
+  /// If the window is less than or equal to 0 (default), one window is computed from the scalar range of all uncompressed
+  /// 16-bit frames of the sequence, so that all frames use the same mapping.
+  vtkSetMacro(EncodingWindow, double);
+  vtkGetMacro(EncodingWindow, double);
+  vtkSetMacro(EncodingLevel, double);
+  vtkGetMacro(EncodingLevel, double);
+
+  /// Index value of the last frame in the output that has been completely encoded.
+  /// Empty if no frame block has been completed.
+  vtkGetMacro(CheckpointIndexValue, std::string);
+  vtkSetMacro(CheckpointIndexValue, std::string);
+
+  /// Name of the output sequence node attribute that stores the checkpoint index value.
+  static const char* GetCheckpointAttributeName() { return "IGSIO.EncodingCheckpoint"; };
+
+protected:
+  bool RollbackOnCancel;
+  bool ResumeFromCheckpoint;
+  int NumberOfThreads;
+  int PipelineQueueDepth;
+  double EncodingWindow;
+  double EncodingLevel;
+  std::string CheckpointIndexValue;
+
+protected:
+  vtkSlicerIGSIOEncodingJob();
+  ~vtkSlicerIGSIOEncodingJob() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOEncodingJob(const vtkSlicerIGSIOEncodingJob&); // Not implemented
+  void operator=(const vtkSlicerIGSIOEncodingJob&);            // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOEncodingJob_h
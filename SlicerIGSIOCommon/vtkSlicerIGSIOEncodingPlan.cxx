@@ -0,0 +1,283 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOEncodingPlan.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOEncodingPlan);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOEncodingPlan::vtkInternal
+{
+public:
+  struct FrameBlock
+  {
+    int StartFrame;
+    int EndFrame;
+    int ReEncodingReasons;
+    bool NewSegment;
+    FrameBlock()
+      : StartFrame(-1)
+      , EndFrame(-1)
+      , ReEncodingReasons(ReEncodingReasonNone)
+      , NewSegment(false)
+    {
+    }
+  };
+
+  std::vector<FrameBlock> FrameBlocks;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingPlan::vtkSlicerIGSIOEncodingPlan()
+  : NumberOfPassThroughFrames(0)
+  , EstimatedNumberOfDecodes(0)
+  , EstimatedNumberOfEncodes(0)
+  , CodecFourCC("")
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingPlan::~vtkSlicerIGSIOEncodingPlan()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingPlan::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "CodecFourCC: " << this->CodecFourCC << "\n";
+  os << indent << "NumberOfFramesToEncode: " << this->GetNumberOfFramesToEncode() << "\n";
+  os << indent << "NumberOfPassThroughFrames: " << this->NumberOfPassThroughFrames << "\n";
+  os << indent << "EstimatedNumberOfDecodes: " << this->EstimatedNumberOfDecodes << "\n";
+  os << indent << "EstimatedNumberOfEncodes: " << this->EstimatedNumberOfEncodes << "\n";
+  os << indent << "FrameBlocks:" << "\n";
+  for (int i = 0; i < this->GetNumberOfFrameBlocks(); ++i)
+  {
+    os << indent.GetNextIndent() << "[" << this->GetFrameBlockStartIndex(i) << ", " << this->GetFrameBlockEndIndex(i) << "]";
+    if (this->GetFrameBlockStartsNewSegment(i))
+    {
+      os << " New segment";
+    }
+    if (this->GetFrameBlockReEncodingRequired(i))
+    {
+      os << " Re-encode: " << this->GetFrameBlockReEncodingReasonsAsString(i);
+    }
+    os << "\n";
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingPlan::Reset()
+{
+  this->Internal->FrameBlocks.clear();
+  this->NumberOfPassThroughFrames = 0;
+  this->EstimatedNumberOfDecodes = 0;
+  this->EstimatedNumberOfEncodes = 0;
+  this->CodecFourCC = "";
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingPlan::AddFrameBlock(int startIndex, int endIndex, int reEncodingReasons, bool newSegment)
+{
+  vtkInternal::FrameBlock frameBlock;
+  frameBlock.StartFrame = startIndex;
+  frameBlock.EndFrame = endIndex;
+  frameBlock.ReEncodingReasons = reEncodingReasons;
+  frameBlock.NewSegment = newSegment;
+  this->Internal->FrameBlocks.push_back(frameBlock);
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingPlan::AddFrameBlockReEncodingReason(int blockIndex, int reEncodingReason)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("AddFrameBlockReEncodingReason: Invalid block index " << blockIndex);
+    return;
+  }
+  this->Internal->FrameBlocks[blockIndex].ReEncodingReasons |= reEncodingReason;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetNumberOfFrameBlocks()
+{
+  return static_cast<int>(this->Internal->FrameBlocks.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetFrameBlockStartIndex(int blockIndex)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("GetFrameBlockStartIndex: Invalid block index " << blockIndex);
+    return -1;
+  }
+  return this->Internal->FrameBlocks[blockIndex].StartFrame;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetFrameBlockEndIndex(int blockIndex)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("GetFrameBlockEndIndex: Invalid block index " << blockIndex);
+    return -1;
+  }
+  return this->Internal->FrameBlocks[blockIndex].EndFrame;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetFrameBlockNumberOfFrames(int blockIndex)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("GetFrameBlockNumberOfFrames: Invalid block index " << blockIndex);
+    return 0;
+  }
+  return this->Internal->FrameBlocks[blockIndex].EndFrame - this->Internal->FrameBlocks[blockIndex].StartFrame + 1;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncodingPlan::GetFrameBlockReEncodingRequired(int blockIndex)
+{
+  return this->GetFrameBlockReEncodingReasons(blockIndex) != ReEncodingReasonNone;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncodingPlan::GetFrameBlockStartsNewSegment(int blockIndex)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("GetFrameBlockStartsNewSegment: Invalid block index " << blockIndex);
+    return false;
+  }
+  return this->Internal->FrameBlocks[blockIndex].NewSegment;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetFrameBlockReEncodingReasons(int blockIndex)
+{
+  if (blockIndex < 0 || blockIndex >= this->GetNumberOfFrameBlocks())
+  {
+    vtkErrorMacro("GetFrameBlockReEncodingReasons: Invalid block index " << blockIndex);
+    return ReEncodingReasonNone;
+  }
+  return this->Internal->FrameBlocks[blockIndex].ReEncodingReasons;
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOEncodingPlan::GetFrameBlockReEncodingReasonsAsString(int blockIndex)
+{
+  return vtkSlicerIGSIOEncodingPlan::GetReEncodingReasonsAsString(this->GetFrameBlockReEncodingReasons(blockIndex));
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOEncodingPlan::GetReEncodingReasonsAsString(int reEncodingReasons)
+{
+  if (reEncodingReasons == ReEncodingReasonNone)
+  {
+    return "None";
+  }
+
+  std::stringstream ss;
+  std::string separator = "";
+  if (reEncodingReasons & ReEncodingReasonForced)
+  {
+    ss << separator << "Forced";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonMissingFrame)
+  {
+    ss << separator << "MissingFrame";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonNonKeyFrameStart)
+  {
+    ss << separator << "NonKeyFrameStart";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonCodecMismatch)
+  {
+    ss << separator << "CodecMismatch";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonBrokenPreviousFrameChain)
+  {
+    ss << separator << "BrokenPreviousFrameChain";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonDimensionChange)
+  {
+    ss << separator << "DimensionChange";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonKeyFrameDistance)
+  {
+    ss << separator << "KeyFrameDistance";
+    separator = ", ";
+  }
+  if (reEncodingReasons & ReEncodingReasonForcedKeyFrame)
+  {
+    ss << separator << "ForcedKeyFrame";
+    separator = ", ";
+  }
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOEncodingPlan::IsReEncodingRequired()
+{
+  for (int i = 0; i < this->GetNumberOfFrameBlocks(); ++i)
+  {
+    if (this->GetFrameBlockReEncodingRequired(i))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingPlan::GetNumberOfFramesToEncode()
+{
+  int numberOfFramesToEncode = 0;
+  for (int i = 0; i < this->GetNumberOfFrameBlocks(); ++i)
+  {
+    if (this->GetFrameBlockReEncodingRequired(i))
+    {
+      numberOfFramesToEncode += this->GetFrameBlockNumberOfFrames(i);
+    }
+  }
+  return numberOfFramesToEncode;
+}
@@ -0,0 +1,149 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOEncodingPlan_h
+#define __vtkSlicerIGSIOEncodingPlan_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+/// Result of the frame block analysis that is performed by vtkSlicerIGSIOCommon::EncodeVideoSequence.
+///
+/// The frames of the input sequence are split into blocks that start with a keyframe.
+/// Each block is either re-encoded, or copied to the output as it is. The reasons for re-encoding
+/// a block are stored as a combination of ReEncodingReason flags.
+/// The plan can be created with vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding without encoding any frames.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOEncodingPlan : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOEncodingPlan* New();
+  vtkTypeMacro(vtkSlicerIGSIOEncodingPlan, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum ReEncodingReason
+  {
+    ReEncodingReasonNone = 0,
+    /// Re-encoding was requested by the caller
+    ReEncodingReasonForced = 1,
+    /// The data node is not a streaming volume, or it does not contain an encoded frame
+    ReEncodingReasonMissingFrame = 2,
+    /// The first frame in the range is not a keyframe
+    ReEncodingReasonNonKeyFrameStart = 4,
+    /// The frame was encoded with a different codec
+    ReEncodingReasonCodecMismatch = 8,
+    /// The previous frame of an inter-frame is not the frame before it in the sequence
+    ReEncodingReasonBrokenPreviousFrameChain = 16,
+    /// The frame dimensions changed, but the first frame with the new dimensions is not a keyframe
+    ReEncodingReasonDimensionChange = 32,
+    /// The distance between keyframes is longer than allowed by the keyframe policy
+    ReEncodingReasonKeyFrameDistance = 64,
+    /// A frame that must be a keyframe according to the keyframe policy is not a keyframe
+    ReEncodingReasonForcedKeyFrame = 128,
+  };
+
+  /// Remove all frame blocks and reset the estimates.
+  void Reset();
+
+  /// Add a block of frames to the end of the plan.
+  /// If any reasons are specified, the block will be re-encoded.
+  /// If newSegment is true, then the frame dimensions are different from the previous block, and the block is
+  /// never encoded together with the previous block.
+  void AddFrameBlock(int startIndex, int endIndex, int reEncodingReasons, bool newSegment = false);
+
+  /// Add a reason to re-encode an existing block.
+  void AddFrameBlockReEncodingReason(int blockIndex, int reEncodingReason);
+
+  /// Get the number of frame blocks in the plan.
+  int GetNumberOfFrameBlocks();
+
+  /// Get the item number of the first frame in the block.
+  int GetFrameBlockStartIndex(int blockIndex);
+
+  /// Get the item number of the last frame in the block.
+  int GetFrameBlockEndIndex(int blockIndex);
+
+  /// Get the number of frames in the block.
+  int GetFrameBlockNumberOfFrames(int blockIndex);
+
+  /// Returns true if the frames in the block will be re-encoded.
+  bool GetFrameBlockReEncodingRequired(int blockIndex);
+
+  /// Returns true if the frame dimensions in the block are different from the previous block.
+  /// Each segment of frames with the same dimensions is encoded as a separate stream, starting with a keyframe.
+  bool GetFrameBlockStartsNewSegment(int blockIndex);
+
+  /// Get the combination of ReEncodingReason flags for the block.
+  int GetFrameBlockReEncodingReasons(int blockIndex);
+
+  /// Get a human readable description of the reasons for re-encoding the block.
+  std::string GetFrameBlockReEncodingReasonsAsString(int blockIndex);
+
+  /// Get a human readable description of the ReEncodingReason flags.
+  static std::string GetReEncodingReasonsAsString(int reEncodingReasons);
+
+  /// Returns true if any of the blocks must be re-encoded.
+  bool IsReEncodingRequired();
+
+  /// Get the total number of frames that will be encoded.
+  int GetNumberOfFramesToEncode();
+
+  /// Get the total number of frames that will be copied to the output without encoding.
+  /// This is always 0 if the encoding is performed in-place.
+  vtkGetMacro(NumberOfPassThroughFrames, int);
+  vtkSetMacro(NumberOfPassThroughFrames, int);
+
+  /// Estimated number of frames that must be decoded.
+  /// This includes the frames that need to be decoded to reach the first frame of a block that starts with an inter-frame.
+  vtkGetMacro(EstimatedNumberOfDecodes, int);
+  vtkSetMacro(EstimatedNumberOfDecodes, int);
+
+  /// Estimated number of frames that must be encoded.
+  vtkGetMacro(EstimatedNumberOfEncodes, int);
+  vtkSetMacro(EstimatedNumberOfEncodes, int);
+
+  /// FourCC of the codec that is used to encode the frames.
+  vtkGetMacro(CodecFourCC, std::string);
+  vtkSetMacro(CodecFourCC, std::string);
+
+protected:
+  int NumberOfPassThroughFrames;
+  int EstimatedNumberOfDecodes;
+  int EstimatedNumberOfEncodes;
+  std::string CodecFourCC;
+
+protected:
+  vtkSlicerIGSIOEncodingPlan();
+  ~vtkSlicerIGSIOEncodingPlan() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOEncodingPlan(const vtkSlicerIGSIOEncodingPlan&); // Not implemented
+  void operator=(const vtkSlicerIGSIOEncodingPlan&);             // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOEncodingPlan_h
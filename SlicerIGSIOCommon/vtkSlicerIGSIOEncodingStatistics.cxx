@@ -0,0 +1,410 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOEncodingStatistics.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOEncodingStatistics);
+
+namespace
+{
+  // Bins up to 2^24 microseconds (about 17 seconds)
+  const int NUMBER_OF_HISTOGRAM_BINS = 25;
+}
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOEncodingStatistics::vtkInternal
+{
+public:
+  struct StageSamples
+  {
+    int NumberOfSamples;
+    double TotalTime;
+    double MinimumTime;
+    double MaximumTime;
+    std::vector<int> Histogram;
+    StageSamples()
+    {
+      this->Reset();
+    }
+    void Reset()
+    {
+      this->NumberOfSamples = 0;
+      this->TotalTime = 0.0;
+      this->MinimumTime = std::numeric_limits<double>::max();
+      this->MaximumTime = 0.0;
+      this->Histogram.assign(NUMBER_OF_HISTOGRAM_BINS, 0);
+    }
+  };
+
+  struct FrameSize
+  {
+    std::string IndexValue;
+    int BytesIn;
+    int BytesOut;
+  };
+
+  vtkInternal()
+  {
+    this->Reset();
+  }
+
+  void Reset()
+  {
+    for (StageSamples& stage : this->Stages)
+    {
+      stage.Reset();
+    }
+    this->Frames.clear();
+    this->TotalBytesIn = 0;
+    this->TotalBytesOut = 0;
+    this->NumberOfKeyFrames = 0;
+    this->NumberOfReEncodedFrames = 0;
+    this->NumberOfPassThroughFrames = 0;
+  }
+
+  bool IsValidStage(int stage)
+  {
+    return stage >= 0 && stage < vtkSlicerIGSIOEncodingStatistics::Stage_Last;
+  }
+
+  std::mutex Mutex;
+  StageSamples Stages[vtkSlicerIGSIOEncodingStatistics::Stage_Last];
+  std::vector<FrameSize> Frames;
+  long long TotalBytesIn;
+  long long TotalBytesOut;
+  int NumberOfKeyFrames;
+  int NumberOfReEncodedFrames;
+  int NumberOfPassThroughFrames;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingStatistics::vtkSlicerIGSIOEncodingStatistics()
+  : WallTime(0.0)
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOEncodingStatistics::~vtkSlicerIGSIOEncodingStatistics()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "WallTime: " << this->WallTime << "\n";
+  os << indent << "NumberOfFrames: " << this->GetNumberOfFrames() << "\n";
+  os << indent << "NumberOfKeyFrames: " << this->GetNumberOfKeyFrames() << "\n";
+  os << indent << "NumberOfReEncodedFrames: " << this->GetNumberOfReEncodedFrames() << "\n";
+  os << indent << "NumberOfPassThroughFrames: " << this->GetNumberOfPassThroughFrames() << "\n";
+  os << indent << "TotalBytesIn: " << this->GetTotalBytesIn() << "\n";
+  os << indent << "TotalBytesOut: " << this->GetTotalBytesOut() << "\n";
+  for (int stage = 0; stage < Stage_Last; ++stage)
+  {
+    os << indent << vtkSlicerIGSIOEncodingStatistics::GetStageName(stage) << ":"
+      << " Samples: " << this->GetStageNumberOfSamples(stage)
+      << " Mean: " << this->GetStageMeanTime(stage)
+      << " Min: " << this->GetStageMinimumTime(stage)
+      << " Max: " << this->GetStageMaximumTime(stage)
+      << " P95: " << this->GetStagePercentileTime(stage, 95.0) << "\n";
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingStatistics::Reset()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Reset();
+  }
+  this->WallTime = 0.0;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOEncodingStatistics::GetStageName(int stage)
+{
+  switch (stage)
+  {
+    case StageDecode: return "Decode";
+    case StageConvert: return "Convert";
+    case StageEncode: return "Encode";
+    case StageNodeInsertion: return "NodeInsertion";
+    default: return "";
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingStatistics::AddStageSample(int stage, double seconds)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return;
+  }
+
+  double microseconds = seconds * 1e6;
+  int bin = 0;
+  if (microseconds >= 1.0)
+  {
+    bin = std::min(NUMBER_OF_HISTOGRAM_BINS - 1, static_cast<int>(std::floor(std::log2(microseconds))) + 1);
+  }
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  vtkInternal::StageSamples& samples = this->Internal->Stages[stage];
+  ++samples.NumberOfSamples;
+  samples.TotalTime += seconds;
+  samples.MinimumTime = std::min(samples.MinimumTime, seconds);
+  samples.MaximumTime = std::max(samples.MaximumTime, seconds);
+  ++samples.Histogram[bin];
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetStageNumberOfSamples(int stage)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Stages[stage].NumberOfSamples;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetStageTotalTime(int stage)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Stages[stage].TotalTime;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetStageMinimumTime(int stage)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const vtkInternal::StageSamples& samples = this->Internal->Stages[stage];
+  return samples.NumberOfSamples > 0 ? samples.MinimumTime : 0.0;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetStageMaximumTime(int stage)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Stages[stage].MaximumTime;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetStageMeanTime(int stage)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const vtkInternal::StageSamples& samples = this->Internal->Stages[stage];
+  return samples.NumberOfSamples > 0 ? samples.TotalTime / samples.NumberOfSamples : 0.0;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetStagePercentileTime(int stage, double percentile)
+{
+  if (!this->Internal->IsValidStage(stage))
+  {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const vtkInternal::StageSamples& samples = this->Internal->Stages[stage];
+  if (samples.NumberOfSamples == 0)
+  {
+    return 0.0;
+  }
+
+  double targetCount = std::max(0.0, std::min(100.0, percentile)) / 100.0 * samples.NumberOfSamples;
+  int count = 0;
+  for (int bin = 0; bin < NUMBER_OF_HISTOGRAM_BINS; ++bin)
+  {
+    count += samples.Histogram[bin];
+    if (count >= targetCount && count > 0)
+    {
+      // The upper bound of the bin can be higher than any sample in the bin
+      return std::min(vtkSlicerIGSIOEncodingStatistics::GetHistogramBinUpperBound(bin), samples.MaximumTime);
+    }
+  }
+  return samples.MaximumTime;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetNumberOfHistogramBins()
+{
+  return NUMBER_OF_HISTOGRAM_BINS;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOEncodingStatistics::GetHistogramBinUpperBound(int bin)
+{
+  if (bin < 0 || bin >= NUMBER_OF_HISTOGRAM_BINS)
+  {
+    return 0.0;
+  }
+  if (bin == NUMBER_OF_HISTOGRAM_BINS - 1)
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+  return std::ldexp(1.0, bin) * 1e-6;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetStageHistogramBinCount(int stage, int bin)
+{
+  if (!this->Internal->IsValidStage(stage) || bin < 0 || bin >= NUMBER_OF_HISTOGRAM_BINS)
+  {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Stages[stage].Histogram[bin];
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOEncodingStatistics::AddFrame(const std::string& indexValue, int bytesIn, int bytesOut, bool keyFrame, bool passThrough)
+{
+  vtkInternal::FrameSize frame;
+  frame.IndexValue = indexValue;
+  frame.BytesIn = bytesIn;
+  frame.BytesOut = bytesOut;
+
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Frames.push_back(frame);
+  this->Internal->TotalBytesIn += bytesIn;
+  this->Internal->TotalBytesOut += bytesOut;
+  if (keyFrame)
+  {
+    ++this->Internal->NumberOfKeyFrames;
+  }
+  if (passThrough)
+  {
+    ++this->Internal->NumberOfPassThroughFrames;
+  }
+  else
+  {
+    ++this->Internal->NumberOfReEncodedFrames;
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetNumberOfFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return static_cast<int>(this->Internal->Frames.size());
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOEncodingStatistics::GetFrameIndexValue(int frame)
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (frame < 0 || frame >= static_cast<int>(this->Internal->Frames.size()))
+  {
+    vtkErrorMacro("GetFrameIndexValue: Invalid frame " << frame);
+    return "";
+  }
+  return this->Internal->Frames[frame].IndexValue;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetFrameBytesIn(int frame)
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (frame < 0 || frame >= static_cast<int>(this->Internal->Frames.size()))
+  {
+    vtkErrorMacro("GetFrameBytesIn: Invalid frame " << frame);
+    return 0;
+  }
+  return this->Internal->Frames[frame].BytesIn;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetFrameBytesOut(int frame)
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (frame < 0 || frame >= static_cast<int>(this->Internal->Frames.size()))
+  {
+    vtkErrorMacro("GetFrameBytesOut: Invalid frame " << frame);
+    return 0;
+  }
+  return this->Internal->Frames[frame].BytesOut;
+}
+
+//---------------------------------------------------------------------------
+long long vtkSlicerIGSIOEncodingStatistics::GetTotalBytesIn()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->TotalBytesIn;
+}
+
+//---------------------------------------------------------------------------
+long long vtkSlicerIGSIOEncodingStatistics::GetTotalBytesOut()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->TotalBytesOut;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetNumberOfKeyFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfKeyFrames;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetNumberOfReEncodedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfReEncodedFrames;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOEncodingStatistics::GetNumberOfPassThroughFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->NumberOfPassThroughFrames;
+}
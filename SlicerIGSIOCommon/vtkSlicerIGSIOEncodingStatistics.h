@@ -0,0 +1,128 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOEncodingStatistics_h
+#define __vtkSlicerIGSIOEncodingStatistics_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+/// Timing and size statistics that are collected by vtkSlicerIGSIOCommon::EncodeVideoSequence.
+///
+/// The latency of each stage is collected in a histogram with logarithmic bins. Bin 0 contains the samples
+/// below 1 microsecond, and bin N contains the samples from 2^(N-1) up to 2^N microseconds. The last bin also
+/// contains all longer samples.
+/// The statistics are reset at the start of each encoding call. Samples can be added from multiple threads.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOEncodingStatistics : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOEncodingStatistics* New();
+  vtkTypeMacro(vtkSlicerIGSIOEncodingStatistics, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum Stage
+  {
+    /// Decoding of an encoded input frame
+    StageDecode = 0,
+    /// Pixel format conversion before encoding
+    StageConvert,
+    /// Encoding of a frame by the codec
+    StageEncode,
+    /// Adding the encoded frame to the output sequence
+    StageNodeInsertion,
+    Stage_Last
+  };
+
+  /// Remove all samples and frames.
+  void Reset();
+
+  /// Get the name of the stage.
+  static std::string GetStageName(int stage);
+
+  /// Add a latency sample for the stage. Thread safe.
+  void AddStageSample(int stage, double seconds);
+
+  //@{
+  /// Summary of the latency samples of the stage, in seconds.
+  int GetStageNumberOfSamples(int stage);
+  double GetStageTotalTime(int stage);
+  double GetStageMinimumTime(int stage);
+  double GetStageMaximumTime(int stage);
+  double GetStageMeanTime(int stage);
+  //@}
+
+  /// Get an estimate of the latency percentile (0-100) of the stage, in seconds.
+  /// The estimate is the upper bound of the histogram bin that contains the percentile, limited to the maximum sample.
+  double GetStagePercentileTime(int stage, double percentile);
+
+  //@{
+  /// Latency histogram of the stage.
+  static int GetNumberOfHistogramBins();
+  static double GetHistogramBinUpperBound(int bin);
+  int GetStageHistogramBinCount(int stage, int bin);
+  //@}
+
+  /// Add the size of a frame that was added to the output. Thread safe.
+  /// For frames that were not encoded, the input size is the size of the uncompressed image.
+  void AddFrame(const std::string& indexValue, int bytesIn, int bytesOut, bool keyFrame, bool passThrough);
+
+  //@{
+  /// Size of each frame in the output, in the order that they were added.
+  int GetNumberOfFrames();
+  std::string GetFrameIndexValue(int frame);
+  int GetFrameBytesIn(int frame);
+  int GetFrameBytesOut(int frame);
+  //@}
+
+  //@{
+  /// Totals of the frames in the output.
+  long long GetTotalBytesIn();
+  long long GetTotalBytesOut();
+  int GetNumberOfKeyFrames();
+  int GetNumberOfReEncodedFrames();
+  int GetNumberOfPassThroughFrames();
+  //@}
+
+  /// Time from the start to the end of the encoding call, in seconds.
+  vtkGetMacro(WallTime, double);
+  vtkSetMacro(WallTime, double);
+
+protected:
+  double WallTime;
+
+protected:
+  vtkSlicerIGSIOEncodingStatistics();
+  ~vtkSlicerIGSIOEncodingStatistics() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOEncodingStatistics(const vtkSlicerIGSIOEncodingStatistics&); // Not implemented
+  void operator=(const vtkSlicerIGSIOEncodingStatistics&);                   // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOEncodingStatistics_h
@@ -0,0 +1,400 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOFramePrefetcher.h"
+#include "vtkSlicerIGSIODecodedFrameCache.h"
+#include "vtkSlicerIGSIOKeyFrameIndex.h"
+#include "vtkSlicerIGSIOThreadPool.h"
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+#include <vtkStreamingVolumeFrame.h>
+
+// MRML includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOFramePrefetcher);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOFramePrefetcher::vtkInternal
+{
+public:
+  // Decoder of a sequence that is only used by the worker thread.
+  // The codec is created on the main thread, since the codec factory should only be accessed from the main thread.
+  struct PrefetchDecoder
+  {
+    vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+    std::string CodecFourCC;
+    vtkSmartPointer<vtkStreamingVolumeFrame> LastDecodedFrame;
+  };
+
+  // Consecutive items of a sequence, starting from a keyframe, that are decoded in order
+  struct PrefetchRun
+  {
+    vtkMRMLSequenceNode* SequenceNode; // Only used as the cache key on the worker thread
+    std::shared_ptr<PrefetchDecoder> Decoder;
+    int StartItemNumber;
+    bool LumaOnly;
+    std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > Frames;
+  };
+
+  struct BrowserState
+  {
+    int LastSelectedItemNumber;
+    int Direction;
+    BrowserState()
+      : LastSelectedItemNumber(-1)
+      , Direction(1)
+    {
+    }
+  };
+
+  vtkInternal()
+    : Generation(0)
+    , NumberOfPrefetchedFrames(0)
+  {
+  }
+
+  std::shared_ptr<PrefetchDecoder> GetDecoder(vtkMRMLSequenceNode* sequenceNode, const std::string& codecFourCC)
+  {
+    std::shared_ptr<PrefetchDecoder>& decoder = this->Decoders[sequenceNode];
+    if (!decoder || decoder->CodecFourCC != codecFourCC)
+    {
+      // A new decoder is created instead of modifying the existing one, which may still be in use by the worker thread
+      decoder = std::make_shared<PrefetchDecoder>();
+      decoder->CodecFourCC = codecFourCC;
+      decoder->Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+        vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
+    }
+    return decoder->Codec ? decoder : nullptr;
+  }
+
+  // Run on the worker thread
+  void DecodeRun(const PrefetchRun& run, unsigned int generation)
+  {
+    // Items at the end of the run that are already cached don't need to be decoded
+    int lastIndex = static_cast<int>(run.Frames.size()) - 1;
+    while (lastIndex >= 0 && this->Cache->FindImage(run.SequenceNode, run.StartItemNumber + lastIndex, run.Frames[lastIndex]))
+    {
+      --lastIndex;
+    }
+
+    // Continue from the last frame that was decoded, if it is in the run
+    PrefetchDecoder* decoder = run.Decoder.get();
+    int firstIndex = 0;
+    for (int i = 0; i < lastIndex; ++i)
+    {
+      if (run.Frames[i] == decoder->LastDecodedFrame)
+      {
+        firstIndex = i + 1;
+      }
+    }
+
+    for (int i = firstIndex; i <= lastIndex; ++i)
+    {
+      if (this->Generation != generation)
+      {
+        // A newer request has been made
+        return;
+      }
+
+      vtkStreamingVolumeFrame* frame = run.Frames[i];
+      vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+      if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(decoder->Codec, frame, imageData, run.LumaOnly))
+      {
+        decoder->LastDecodedFrame = nullptr;
+        return;
+      }
+      decoder->LastDecodedFrame = frame;
+      this->Cache->AddImage(run.SequenceNode, run.StartItemNumber + i, frame, imageData);
+      ++this->NumberOfPrefetchedFrames;
+    }
+  }
+
+  vtkSmartPointer<vtkSlicerIGSIODecodedFrameCache> Cache;
+  std::map<vtkMRMLSequenceNode*, std::shared_ptr<PrefetchDecoder> > Decoders;
+  std::map<vtkMRMLSequenceBrowserNode*, BrowserState> BrowserStates;
+  std::atomic<unsigned int> Generation;
+  std::atomic<vtkIdType> NumberOfPrefetchedFrames;
+
+  // Single worker thread, so that the frames of each decoder are decoded in order
+  std::unique_ptr<vtkSlicerIGSIOThreadPool> ThreadPool;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOFramePrefetcher::vtkSlicerIGSIOFramePrefetcher()
+  : PrefetchDuration(0.5)
+  , MaximumNumberOfFramesToPrefetch(30)
+{
+  this->Internal = new vtkInternal();
+  this->Internal->Cache = vtkSlicerIGSIODecodedFrameCache::GetInstance();
+  this->Internal->ThreadPool.reset(new vtkSlicerIGSIOThreadPool(1));
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOFramePrefetcher::~vtkSlicerIGSIOFramePrefetcher()
+{
+  this->Cancel();
+  this->Internal->ThreadPool.reset();
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "PrefetchDuration: " << this->PrefetchDuration << "\n";
+  os << indent << "MaximumNumberOfFramesToPrefetch: " << this->MaximumNumberOfFramesToPrefetch << "\n";
+  os << indent << "NumberOfPrefetchedFrames: " << this->Internal->NumberOfPrefetchedFrames << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::SetDecodedFrameCache(vtkSlicerIGSIODecodedFrameCache* cache)
+{
+  if (this->Internal->Cache == cache)
+  {
+    return;
+  }
+  // The worker thread must not use the previous cache anymore
+  this->Cancel();
+  this->Wait();
+  this->Internal->Cache = cache ? cache : vtkSlicerIGSIODecodedFrameCache::GetInstance();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIODecodedFrameCache* vtkSlicerIGSIOFramePrefetcher::GetDecodedFrameCache()
+{
+  return this->Internal->Cache;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOFramePrefetcher::GetPlaybackDirection(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  std::map<vtkMRMLSequenceBrowserNode*, vtkInternal::BrowserState>::iterator stateIt = this->Internal->BrowserStates.find(browserNode);
+  return stateIt != this->Internal->BrowserStates.end() ? stateIt->second.Direction : 1;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOFramePrefetcher::GetNumberOfFramesToPrefetch(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!browserNode)
+  {
+    return 0;
+  }
+  int numberOfFrames = static_cast<int>(std::ceil(browserNode->GetPlaybackRateFps() * this->PrefetchDuration));
+  return std::max(1, std::min(numberOfFrames, this->MaximumNumberOfFramesToPrefetch));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::Update(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!browserNode || this->MaximumNumberOfFramesToPrefetch < 1)
+  {
+    return;
+  }
+
+  vtkMRMLSequenceNode* masterSequenceNode = browserNode->GetMasterSequenceNode();
+  int selectedItemNumber = browserNode->GetSelectedItemNumber();
+  int numberOfItems = masterSequenceNode ? masterSequenceNode->GetNumberOfDataNodes() : 0;
+  if (selectedItemNumber < 0 || selectedItemNumber >= numberOfItems)
+  {
+    return;
+  }
+
+  // Detect the direction of playback from the change of the selected item
+  vtkInternal::BrowserState& state = this->Internal->BrowserStates[browserNode];
+  if (state.LastSelectedItemNumber == selectedItemNumber)
+  {
+    // Nothing has changed, the frames have already been requested
+    return;
+  }
+  if (state.LastSelectedItemNumber >= 0)
+  {
+    int change = selectedItemNumber - state.LastSelectedItemNumber;
+    if (browserNode->GetPlaybackLooped() && std::abs(change) > numberOfItems / 2)
+    {
+      // Wrapped around the end of the sequence
+      change = -change;
+    }
+    state.Direction = change > 0 ? 1 : -1;
+  }
+  state.LastSelectedItemNumber = selectedItemNumber;
+
+  if (!browserNode->GetPlaybackActive())
+  {
+    // The next selected item is only predictable during playback. When the user scrubs or jumps through the sequence,
+    // prefetching would decode frames that are not displayed.
+    return;
+  }
+
+  // Items of the master sequence to prefetch
+  std::vector<int> masterItemNumbers;
+  int numberOfFramesToPrefetch = std::min(this->GetNumberOfFramesToPrefetch(browserNode), numberOfItems - 1);
+  for (int i = 1; i <= numberOfFramesToPrefetch; ++i)
+  {
+    int itemNumber = selectedItemNumber + state.Direction * i;
+    if (itemNumber < 0 || itemNumber >= numberOfItems)
+    {
+      if (!browserNode->GetPlaybackLooped())
+      {
+        break;
+      }
+      itemNumber = (itemNumber + numberOfItems) % numberOfItems;
+    }
+    masterItemNumbers.push_back(itemNumber);
+  }
+
+  std::vector<vtkInternal::PrefetchRun> runs;
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    if (!sequenceNode || sequenceNode->GetNumberOfDataNodes() < 1
+      || !vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(0)))
+    {
+      continue;
+    }
+
+    std::vector<int> itemNumbers;
+    for (int masterItemNumber : masterItemNumbers)
+    {
+      int itemNumber = masterItemNumber;
+      if (sequenceNode != masterSequenceNode)
+      {
+        itemNumber = sequenceNode->GetItemNumberFromIndexValue(masterSequenceNode->GetNthIndexValue(masterItemNumber));
+      }
+      if (itemNumber >= 0)
+      {
+        itemNumbers.push_back(itemNumber);
+      }
+    }
+    std::sort(itemNumbers.begin(), itemNumbers.end());
+    itemNumbers.erase(std::unique(itemNumbers.begin(), itemNumbers.end()), itemNumbers.end());
+
+    // Each range of consecutive items is decoded from the keyframe of its first item, regardless of the direction.
+    // The items are decoded in increasing order, so inter-frames can be decoded.
+    vtkSlicerIGSIOKeyFrameIndex* keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode);
+    size_t rangeStart = 0;
+    while (rangeStart < itemNumbers.size())
+    {
+      size_t rangeEnd = rangeStart;
+      while (rangeEnd + 1 < itemNumbers.size() && itemNumbers[rangeEnd + 1] == itemNumbers[rangeEnd] + 1)
+      {
+        ++rangeEnd;
+      }
+      int firstItemNumber = itemNumbers[rangeStart];
+      int lastItemNumber = itemNumbers[rangeEnd];
+      rangeStart = rangeEnd + 1;
+
+      int keyFrameItemNumber = keyFrameIndex->GetKeyFrameItemNumber(firstItemNumber);
+      if (keyFrameItemNumber < 0 || keyFrameIndex->GetKeyFrameItemNumber(lastItemNumber) < 0)
+      {
+        // The frames that the items depend on are not in the sequence
+        continue;
+      }
+
+      vtkInternal::PrefetchRun run;
+      run.SequenceNode = sequenceNode;
+      run.StartItemNumber = keyFrameItemNumber;
+      run.LumaOnly = vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(sequenceNode);
+      for (int itemNumber = keyFrameItemNumber; itemNumber <= lastItemNumber; ++itemNumber)
+      {
+        vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber));
+        run.Frames.push_back(streamingVolumeNode->GetFrame());
+      }
+      run.Decoder = this->Internal->GetDecoder(sequenceNode, run.Frames.front()->GetCodecFourCC());
+      if (run.Decoder)
+      {
+        runs.push_back(run);
+      }
+    }
+  }
+
+  // Discard the previous request
+  unsigned int generation = ++this->Internal->Generation;
+  if (runs.empty())
+  {
+    return;
+  }
+
+  vtkInternal* internal = this->Internal;
+  this->Internal->ThreadPool->Submit([internal, runs, generation]()
+    {
+      for (const vtkInternal::PrefetchRun& run : runs)
+      {
+        if (internal->Generation != generation)
+        {
+          return;
+        }
+        internal->DecodeRun(run, generation);
+      }
+    });
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::Cancel()
+{
+  ++this->Internal->Generation;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::Wait()
+{
+  this->Internal->ThreadPool->Wait();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::RemoveSequence(vtkMRMLSequenceNode* sequenceNode)
+{
+  // The worker thread keeps its own reference to the decoder, so it can be removed while it is in use
+  this->Internal->Decoders.erase(sequenceNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOFramePrefetcher::RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  this->Internal->BrowserStates.erase(browserNode);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOFramePrefetcher::GetNumberOfPrefetchedFrames()
+{
+  return this->Internal->NumberOfPrefetchedFrames;
+}
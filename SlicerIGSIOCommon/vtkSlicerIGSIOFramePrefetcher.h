@@ -0,0 +1,107 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOFramePrefetcher_h
+#define __vtkSlicerIGSIOFramePrefetcher_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMRMLSequenceBrowserNode;
+class vtkMRMLSequenceNode;
+class vtkSlicerIGSIODecodedFrameCache;
+
+/// Decodes the upcoming frames of the streaming volume sequences of a sequence browser on a background thread.
+///
+/// Each time that the selected item of the browser changes, Update should be called. The direction of playback is
+/// detected from the change of the selected item, and the next frames in that direction are decoded on a worker thread
+/// and added to the decoded frame cache, so that the proxy nodes can be updated from the cache without decoding.
+/// The number of frames to prefetch is the number of frames that are played during PrefetchDuration at the
+/// playback rate of the browser, limited by MaximumNumberOfFramesToPrefetch. Frames are only prefetched while the playback
+/// of the browser is active.
+///
+/// Only the most recent request is processed: frames that have not been decoded when the selected item changes again
+/// are not decoded anymore. The worker thread has its own decoders, so it does not block decoding on the main thread.
+/// The decoded frame cache must be large enough to hold the prefetched frames of all sequences.
+/// All methods must be called on the main thread.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOFramePrefetcher : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOFramePrefetcher* New();
+  vtkTypeMacro(vtkSlicerIGSIOFramePrefetcher, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Cache that the prefetched frames are added to. Default is the shared instance of vtkSlicerIGSIODecodedFrameCache.
+  void SetDecodedFrameCache(vtkSlicerIGSIODecodedFrameCache* cache);
+  vtkSlicerIGSIODecodedFrameCache* GetDecodedFrameCache();
+
+  /// Time of playback that is prefetched ahead of the selected item, in seconds. Default is 0.5 seconds.
+  vtkSetMacro(PrefetchDuration, double);
+  vtkGetMacro(PrefetchDuration, double);
+
+  /// Maximum number of frames of each sequence that are prefetched. Default is 30.
+  vtkSetMacro(MaximumNumberOfFramesToPrefetch, int);
+  vtkGetMacro(MaximumNumberOfFramesToPrefetch, int);
+
+  /// Start prefetching the frames that follow the selected item of the browser in the direction of playback.
+  /// Frames that are still waiting to be prefetched from a previous call are discarded.
+  void Update(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Direction that the selected item of the browser was last moved in: 1 for forward, -1 for backward.
+  int GetPlaybackDirection(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Get the number of frames that would be prefetched for the browser.
+  int GetNumberOfFramesToPrefetch(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Discard the frames that are waiting to be prefetched.
+  void Cancel();
+
+  /// Block until the worker thread has finished prefetching.
+  void Wait();
+
+  /// Remove the decoders of the sequence. Should be called when the sequence node is removed from the scene.
+  void RemoveSequence(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Remove the playback state of the browser. Should be called when the browser node is removed from the scene.
+  void RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Number of frames that have been decoded by the worker thread.
+  vtkIdType GetNumberOfPrefetchedFrames();
+
+protected:
+  double PrefetchDuration;
+  int MaximumNumberOfFramesToPrefetch;
+
+protected:
+  vtkSlicerIGSIOFramePrefetcher();
+  ~vtkSlicerIGSIOFramePrefetcher() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOFramePrefetcher(const vtkSlicerIGSIOFramePrefetcher&); // Not implemented
+  void operator=(const vtkSlicerIGSIOFramePrefetcher&);                // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOFramePrefetcher_h
@@ -0,0 +1,351 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOKeyFrameIndex.h"
+
+// vtkAddon includes
+#include <vtkStreamingVolumeFrame.h>
+
+// MRML includes
+#include <vtkMRMLSequenceNode.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <map>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOKeyFrameIndex);
+
+namespace
+{
+  // Shared indices, by sequence node
+  std::map<vtkMRMLSequenceNode*, vtkSmartPointer<vtkSlicerIGSIOKeyFrameIndex> > SequenceIndices;
+}
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOKeyFrameIndex::vtkInternal
+{
+public:
+  vtkInternal()
+    : BuildSequenceMTime(0)
+    , Valid(false)
+  {
+  }
+
+  void Build()
+  {
+    this->Frames.clear();
+    this->ChainLengths.clear();
+    this->KeyFrameItemNumbers.clear();
+    this->SortedKeyFrames.clear();
+    this->ChainRunStarts.clear();
+    this->Extend();
+  }
+
+  // Index the items that follow the indexed items
+  void Extend()
+  {
+    this->BuildSequenceMTime = this->SequenceNode ? this->SequenceNode->GetMTime() : 0;
+    this->Valid = true;
+    if (!this->SequenceNode)
+    {
+      return;
+    }
+
+    int numberOfItems = this->SequenceNode->GetNumberOfDataNodes();
+    int firstItemNumber = static_cast<int>(this->Frames.size());
+    this->Frames.resize(numberOfItems, nullptr);
+    this->ChainLengths.resize(numberOfItems, 0);
+    this->KeyFrameItemNumbers.resize(numberOfItems, -1);
+    for (int i = firstItemNumber; i < numberOfItems; ++i)
+    {
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(this->SequenceNode->GetNthDataNode(i));
+      vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+      this->Frames[i] = frame;
+      if (!frame)
+      {
+        this->ChainRunStarts.push_back(i);
+        continue;
+      }
+
+      if (frame->IsKeyFrame())
+      {
+        this->ChainLengths[i] = 1;
+        this->KeyFrameItemNumbers[i] = i;
+        this->SortedKeyFrames.push_back(i);
+        this->ChainRunStarts.push_back(i);
+        continue;
+      }
+
+      vtkStreamingVolumeFrame* previousFrame = frame->GetPreviousFrame();
+      if (i > 0 && previousFrame && previousFrame == this->Frames[i - 1])
+      {
+        // The chain continues from the previous item, which has already been indexed
+        this->ChainLengths[i] = this->ChainLengths[i - 1] + 1;
+        this->KeyFrameItemNumbers[i] = this->KeyFrameItemNumbers[i - 1];
+        continue;
+      }
+      this->ChainRunStarts.push_back(i);
+
+      // The previous frames are not stored in the sequence, so the chain has to be followed
+      int chainLength = 1;
+      vtkStreamingVolumeFrame* currentFrame = frame;
+      while (!currentFrame->IsKeyFrame() && currentFrame->GetPreviousFrame())
+      {
+        currentFrame = currentFrame->GetPreviousFrame();
+        ++chainLength;
+      }
+      this->ChainLengths[i] = chainLength;
+    }
+  }
+
+  // Returns true if none of the indexed items have been removed or replaced, so only the items that were appended
+  // to the sequence need to be indexed. Only the frame pointers are compared, the frames are not analyzed again.
+  bool IsExtensible()
+  {
+    if (!this->Valid || !this->SequenceNode
+      || this->SequenceNode->GetNumberOfDataNodes() < static_cast<int>(this->Frames.size()))
+    {
+      return false;
+    }
+    for (int i = 0; i < static_cast<int>(this->Frames.size()); ++i)
+    {
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(this->SequenceNode->GetNthDataNode(i));
+      if ((streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr) != this->Frames[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool IsValidItem(int itemNumber)
+  {
+    return itemNumber >= 0 && itemNumber < static_cast<int>(this->Frames.size());
+  }
+
+  vtkWeakPointer<vtkMRMLSequenceNode> SequenceNode;
+  vtkMTimeType BuildSequenceMTime;
+  bool Valid;
+
+  // Per item. Frames are only compared with the current frames of the sequence, never dereferenced.
+  std::vector<vtkStreamingVolumeFrame*> Frames;
+  std::vector<int> ChainLengths;
+  std::vector<int> KeyFrameItemNumbers;
+
+  std::vector<int> SortedKeyFrames;
+
+  // Sorted item numbers of the items that do not continue the previous frame chain of the item before them
+  std::vector<int> ChainRunStarts;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOKeyFrameIndex::vtkSlicerIGSIOKeyFrameIndex()
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOKeyFrameIndex::~vtkSlicerIGSIOKeyFrameIndex()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "SequenceNode: " << (this->Internal->SequenceNode ? this->Internal->SequenceNode->GetID() : "(none)") << "\n";
+  os << indent << "Valid: " << (this->Internal->Valid ? "true" : "false") << "\n";
+  os << indent << "NumberOfItems: " << this->Internal->Frames.size() << "\n";
+  os << indent << "NumberOfKeyFrames: " << this->Internal->SortedKeyFrames.size() << "\n";
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOKeyFrameIndex* vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(vtkMRMLSequenceNode* sequenceNode)
+{
+  if (!sequenceNode)
+  {
+    return nullptr;
+  }
+
+  vtkSmartPointer<vtkSlicerIGSIOKeyFrameIndex>& index = SequenceIndices[sequenceNode];
+  if (!index || index->GetSequenceNode() != sequenceNode)
+  {
+    // A deleted sequence node may have been at the same address
+    index = vtkSmartPointer<vtkSlicerIGSIOKeyFrameIndex>::New();
+    index->SetSequenceNode(sequenceNode);
+  }
+  return index;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::RemoveSequenceIndex(vtkMRMLSequenceNode* sequenceNode)
+{
+  SequenceIndices.erase(sequenceNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::SetSequenceNode(vtkMRMLSequenceNode* sequenceNode)
+{
+  if (this->Internal->SequenceNode == sequenceNode)
+  {
+    return;
+  }
+  this->Internal->SequenceNode = sequenceNode;
+  this->Internal->Valid = false;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* vtkSlicerIGSIOKeyFrameIndex::GetSequenceNode()
+{
+  return this->Internal->SequenceNode;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::Update()
+{
+  this->UpdateForItem(-1);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::UpdateForItem(int itemNumber)
+{
+  vtkMRMLSequenceNode* sequenceNode = this->Internal->SequenceNode;
+  bool upToDate = this->Internal->Valid
+    && (sequenceNode ? sequenceNode->GetMTime() : 0) == this->Internal->BuildSequenceMTime;
+  if (upToDate && sequenceNode && this->Internal->IsValidItem(itemNumber))
+  {
+    // Data nodes can be modified without modifying the sequence node
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber));
+    upToDate = (streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr) == this->Internal->Frames[itemNumber];
+  }
+  if (!upToDate)
+  {
+    if (this->Internal->IsExtensible())
+    {
+      this->Internal->Extend();
+    }
+    else
+    {
+      this->Internal->Build();
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFrameIndex::Invalidate()
+{
+  this->Internal->Valid = false;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetNumberOfItems()
+{
+  this->Update();
+  return static_cast<int>(this->Internal->Frames.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetNumberOfKeyFrames()
+{
+  this->Update();
+  return static_cast<int>(this->Internal->SortedKeyFrames.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetNthKeyFrameItemNumber(int n)
+{
+  this->Update();
+  if (n < 0 || n >= static_cast<int>(this->Internal->SortedKeyFrames.size()))
+  {
+    vtkErrorMacro("GetNthKeyFrameItemNumber: Invalid keyframe " << n);
+    return -1;
+  }
+  return this->Internal->SortedKeyFrames[n];
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOKeyFrameIndex::IsKeyFrame(int itemNumber)
+{
+  this->UpdateForItem(itemNumber);
+  return this->Internal->IsValidItem(itemNumber) && this->Internal->KeyFrameItemNumbers[itemNumber] == itemNumber;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetPreviousKeyFrameItemNumber(int itemNumber)
+{
+  this->Update();
+  const std::vector<int>& keyFrames = this->Internal->SortedKeyFrames;
+  std::vector<int>::const_iterator keyFrameIt = std::upper_bound(keyFrames.begin(), keyFrames.end(), itemNumber);
+  if (keyFrameIt == keyFrames.begin())
+  {
+    return -1;
+  }
+  return *(--keyFrameIt);
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetKeyFrameItemNumber(int itemNumber)
+{
+  this->UpdateForItem(itemNumber);
+  if (!this->Internal->IsValidItem(itemNumber))
+  {
+    return -1;
+  }
+  return this->Internal->KeyFrameItemNumbers[itemNumber];
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetLastChainRunItemNumber(int itemNumber)
+{
+  this->UpdateForItem(itemNumber);
+  if (!this->Internal->IsValidItem(itemNumber))
+  {
+    return -1;
+  }
+  const std::vector<int>& runStarts = this->Internal->ChainRunStarts;
+  std::vector<int>::const_iterator nextRunStartIt = std::upper_bound(runStarts.begin(), runStarts.end(), itemNumber);
+  if (nextRunStartIt == runStarts.end())
+  {
+    return static_cast<int>(this->Internal->Frames.size()) - 1;
+  }
+  return *nextRunStartIt - 1;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFrameIndex::GetChainLength(int itemNumber)
+{
+  this->UpdateForItem(itemNumber);
+  if (!this->Internal->IsValidItem(itemNumber))
+  {
+    return 0;
+  }
+  return this->Internal->ChainLengths[itemNumber];
+}
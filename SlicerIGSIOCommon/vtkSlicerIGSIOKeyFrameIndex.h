@@ -0,0 +1,111 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOKeyFrameIndex_h
+#define __vtkSlicerIGSIOKeyFrameIndex_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMRMLSequenceNode;
+
+/// Index of the keyframes of a streaming volume sequence.
+///
+/// Decoding an item of an encoded sequence requires decoding the frames from the previous keyframe, which are found by
+/// following the previous frame pointers of the frames. The index is built once in a single pass over the sequence and
+/// stores the sorted item numbers of the keyframes, and for each item the length of its previous frame chain and the
+/// item number of its keyframe, so that these can be looked up without following the pointers.
+///
+/// The index is updated automatically when the sequence node is modified, or when the frame of the queried item has
+/// been replaced. If items were only appended to the sequence, the indexed items are compared with the current frames
+/// and only the new items are indexed, otherwise the index is rebuilt.
+/// The index of a sequence can be shared using GetSequenceIndex. Must be used on the main thread.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOKeyFrameIndex : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOKeyFrameIndex* New();
+  vtkTypeMacro(vtkSlicerIGSIOKeyFrameIndex, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Get the shared index of the sequence. The index is created if it does not exist.
+  static vtkSlicerIGSIOKeyFrameIndex* GetSequenceIndex(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Remove the shared index of the sequence.
+  static void RemoveSequenceIndex(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Sequence that is indexed. The sequence is not kept alive by the index.
+  void SetSequenceNode(vtkMRMLSequenceNode* sequenceNode);
+  vtkMRMLSequenceNode* GetSequenceNode();
+
+  /// Update the index if the sequence has been modified since the index was built.
+  void Update();
+
+  /// Rebuild the index the next time that it is used.
+  void Invalidate();
+
+  /// Number of items in the sequence when the index was built.
+  int GetNumberOfItems();
+
+  //@{
+  /// Item numbers of the keyframes, in increasing order.
+  int GetNumberOfKeyFrames();
+  int GetNthKeyFrameItemNumber(int n);
+  //@}
+
+  /// Returns true if the item is an encoded keyframe.
+  bool IsKeyFrame(int itemNumber);
+
+  /// Get the item number of the last keyframe at or before the item, or -1 if there is none.
+  /// This is found using the sorted keyframe list, so it does not depend on the previous frame pointers.
+  int GetPreviousKeyFrameItemNumber(int itemNumber);
+
+  /// Get the item number of the keyframe that the item is decoded from.
+  /// Returns -1 if the item is not an encoded frame, or if its previous frame chain is not stored in consecutive items
+  /// of the sequence up to the keyframe.
+  int GetKeyFrameItemNumber(int itemNumber);
+
+  /// Get the last item of the run of items that starts at the item, in which each following item is an encoded inter frame
+  /// that references the frame of the item before it. The frames of a run are from the same stream, so they have the same
+  /// codec and dimensions. Returns the item itself if the next item does not continue the chain, or -1 if the item is invalid.
+  int GetLastChainRunItemNumber(int itemNumber);
+
+  /// Get the number of frames that must be decoded to decode the item: the length of the previous frame chain
+  /// up to and including the keyframe. 1 for keyframes, 0 if the item is not an encoded frame.
+  int GetChainLength(int itemNumber);
+
+protected:
+  vtkSlicerIGSIOKeyFrameIndex();
+  ~vtkSlicerIGSIOKeyFrameIndex() override;
+
+  /// Rebuild the index if it is out of date. If the item number is valid, the frame of the item is also checked.
+  void UpdateForItem(int itemNumber);
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOKeyFrameIndex(const vtkSlicerIGSIOKeyFrameIndex&); // Not implemented
+  void operator=(const vtkSlicerIGSIOKeyFrameIndex&);              // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOKeyFrameIndex_h
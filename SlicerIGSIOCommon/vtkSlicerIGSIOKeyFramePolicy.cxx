@@ -0,0 +1,128 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOKeyFramePolicy.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <set>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOKeyFramePolicy);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOKeyFramePolicy::vtkInternal
+{
+public:
+  // Index values in the order that they were added, and a set for fast lookup
+  std::vector<std::string> ForcedKeyFrameIndexValues;
+  std::set<std::string> ForcedKeyFrameIndexValueSet;
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOKeyFramePolicy::vtkSlicerIGSIOKeyFramePolicy()
+  : MaximumKeyFrameDistance(0)
+  , TargetSeekCost(0)
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOKeyFramePolicy::~vtkSlicerIGSIOKeyFramePolicy()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFramePolicy::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumKeyFrameDistance: " << this->MaximumKeyFrameDistance << "\n";
+  os << indent << "TargetSeekCost: " << this->TargetSeekCost << "\n";
+  os << indent << "ForcedKeyFrameIndexValues:";
+  for (const std::string& indexValue : this->Internal->ForcedKeyFrameIndexValues)
+  {
+    os << " " << indexValue;
+  }
+  os << "\n";
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFramePolicy::GetEffectiveMaximumKeyFrameDistance()
+{
+  // A group of N frames that starts with a keyframe requires at most N decodes to reach its last frame
+  int maximumDistance = this->MaximumKeyFrameDistance > 0 ? this->MaximumKeyFrameDistance : 0;
+  if (this->TargetSeekCost > 0)
+  {
+    maximumDistance = maximumDistance > 0 ? std::min(maximumDistance, this->TargetSeekCost) : this->TargetSeekCost;
+  }
+  return maximumDistance;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFramePolicy::AddForcedKeyFrameIndexValue(const std::string& indexValue)
+{
+  if (!this->Internal->ForcedKeyFrameIndexValueSet.insert(indexValue).second)
+  {
+    return;
+  }
+  this->Internal->ForcedKeyFrameIndexValues.push_back(indexValue);
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOKeyFramePolicy::RemoveAllForcedKeyFrameIndexValues()
+{
+  if (this->Internal->ForcedKeyFrameIndexValues.empty())
+  {
+    return;
+  }
+  this->Internal->ForcedKeyFrameIndexValues.clear();
+  this->Internal->ForcedKeyFrameIndexValueSet.clear();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOKeyFramePolicy::GetNumberOfForcedKeyFrameIndexValues()
+{
+  return static_cast<int>(this->Internal->ForcedKeyFrameIndexValues.size());
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOKeyFramePolicy::GetNthForcedKeyFrameIndexValue(int n)
+{
+  if (n < 0 || n >= this->GetNumberOfForcedKeyFrameIndexValues())
+  {
+    vtkErrorMacro("GetNthForcedKeyFrameIndexValue: Invalid index " << n);
+    return "";
+  }
+  return this->Internal->ForcedKeyFrameIndexValues[n];
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOKeyFramePolicy::IsForcedKeyFrameIndexValue(const std::string& indexValue)
+{
+  return this->Internal->ForcedKeyFrameIndexValueSet.find(indexValue) != this->Internal->ForcedKeyFrameIndexValueSet.end();
+}
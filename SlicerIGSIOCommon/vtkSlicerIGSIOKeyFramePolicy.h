@@ -0,0 +1,85 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOKeyFramePolicy_h
+#define __vtkSlicerIGSIOKeyFramePolicy_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+/// Controls the placement of keyframes by vtkSlicerIGSIOCommon::EncodeVideoSequence.
+///
+/// Seeking to a frame requires decoding all frames from the preceding keyframe, so the distance between
+/// keyframes limits the worst-case number of decodes after a random jump in the sequence browser.
+/// Frames are forced to be keyframes by requesting a keyframe from the codec that encodes the stream, so the policy does not
+/// depend on the parameters of the codec. Existing frame blocks that violate the policy are re-encoded.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOKeyFramePolicy : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOKeyFramePolicy* New();
+  vtkTypeMacro(vtkSlicerIGSIOKeyFramePolicy, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Maximum number of frames from one keyframe to the next. The codec may still insert additional keyframes.
+  /// If less than 1 (default), the distance is not limited.
+  vtkSetMacro(MaximumKeyFrameDistance, int);
+  vtkGetMacro(MaximumKeyFrameDistance, int);
+
+  /// Maximum number of frames that need to be decoded to display any frame, including the keyframe itself.
+  /// If less than 1 (default), the seek cost is not limited.
+  vtkSetMacro(TargetSeekCost, int);
+  vtkGetMacro(TargetSeekCost, int);
+
+  /// Get the maximum distance between keyframes that satisfies both MaximumKeyFrameDistance and TargetSeekCost.
+  /// Returns 0 if the distance is not limited.
+  int GetEffectiveMaximumKeyFrameDistance();
+
+  /// Frames with the specified index value will always be keyframes, for example at annotation timestamps.
+  void AddForcedKeyFrameIndexValue(const std::string& indexValue);
+  void RemoveAllForcedKeyFrameIndexValues();
+  int GetNumberOfForcedKeyFrameIndexValues();
+  std::string GetNthForcedKeyFrameIndexValue(int n);
+
+  /// Returns true if the frame with the specified index value must be a keyframe.
+  bool IsForcedKeyFrameIndexValue(const std::string& indexValue);
+
+protected:
+  int MaximumKeyFrameDistance;
+  int TargetSeekCost;
+
+protected:
+  vtkSlicerIGSIOKeyFramePolicy();
+  ~vtkSlicerIGSIOKeyFramePolicy() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOKeyFramePolicy(const vtkSlicerIGSIOKeyFramePolicy&); // Not implemented
+  void operator=(const vtkSlicerIGSIOKeyFramePolicy&);               // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOKeyFramePolicy_h
@@ -0,0 +1,401 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOPixelConversion.h"
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOBufferPool.h"
+
+// VTK includes
+#include <vtkImageData.h>
+
+// STD includes
+#include <algorithm>
+
+// SIMD includes
+// The vectorized loops are compiled for their instruction set with function target attributes, and are only called if
+// the processor supports the instruction set, so the library can be built for any x86 processor.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SLICERIGSIO_USE_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+// MSVC allows intrinsics of any instruction set without target attributes
+#define SLICERIGSIO_TARGET(instructionSet)
+#else
+#define SLICERIGSIO_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#endif
+
+namespace
+{
+  // Instruction sets in the order of preference
+  enum InstructionSet
+  {
+    InstructionSetScalar,
+    InstructionSetSSE2,
+    InstructionSetSSSE3,
+    InstructionSetAVX2
+  };
+
+  //----------------------------------------------------------------------------
+  InstructionSet DetectInstructionSet()
+  {
+#if defined(SLICERIGSIO_USE_SIMD)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int cpuInfo[4] = { 0, 0, 0, 0 };
+    __cpuid(cpuInfo, 0);
+    int maximumLeaf = cpuInfo[0];
+    __cpuid(cpuInfo, 1);
+    bool sse2 = (cpuInfo[3] & (1 << 26)) != 0;
+    bool ssse3 = (cpuInfo[2] & (1 << 9)) != 0;
+    // AVX registers can only be used if the operating system saves them (OSXSAVE and XCR0 bits 1 and 2)
+    bool avxEnabled = (cpuInfo[2] & (1 << 27)) != 0 && (cpuInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    bool avx2 = false;
+    if (avxEnabled && maximumLeaf >= 7)
+    {
+      __cpuidex(cpuInfo, 7, 0);
+      avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2)
+    {
+      return InstructionSetAVX2;
+    }
+    if (ssse3)
+    {
+      return InstructionSetSSSE3;
+    }
+    if (sse2)
+    {
+      return InstructionSetSSE2;
+    }
+#endif
+    return InstructionSetScalar;
+  }
+
+  //----------------------------------------------------------------------------
+  // The processor is only queried once
+  InstructionSet GetInstructionSetToUse()
+  {
+    static const InstructionSet instructionSet = DetectInstructionSet();
+    return instructionSet;
+  }
+
+  //----------------------------------------------------------------------------
+  vtkIdType GetNumberOfPixels(vtkImageData* imageData)
+  {
+    int dimensions[3] = { 0, 0, 0 };
+    imageData->GetDimensions(dimensions);
+    return static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  }
+
+  //----------------------------------------------------------------------------
+  bool AllocateOutputImage(vtkImageData* inputImageData, vtkImageData* outputImageData, int numberOfComponents)
+  {
+    if (!inputImageData || !outputImageData || inputImageData == outputImageData)
+    {
+      return false;
+    }
+    // Scalars are only reallocated if the output does not already have the same size and type
+    outputImageData->CopyStructure(inputImageData);
+    outputImageData->AllocateScalars(VTK_UNSIGNED_CHAR, numberOfComponents);
+    return true;
+  }
+
+#if defined(SLICERIGSIO_USE_SIMD)
+  //----------------------------------------------------------------------------
+  // Each group of 16 gray pixels is expanded to 48 RGB bytes with three shuffles.
+  // Returns the number of pixels that were converted.
+  SLICERIGSIO_TARGET("ssse3")
+  vtkIdType GrayToRGBRowSSSE3(const unsigned char* input, unsigned char* output, vtkIdType numberOfPixels)
+  {
+    const __m128i mask0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i mask1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const __m128i mask2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+    vtkIdType i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      __m128i gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+      __m128i* rgb = reinterpret_cast<__m128i*>(output + 3 * i);
+      _mm_storeu_si128(rgb, _mm_shuffle_epi8(gray, mask0));
+      _mm_storeu_si128(rgb + 1, _mm_shuffle_epi8(gray, mask1));
+      _mm_storeu_si128(rgb + 2, _mm_shuffle_epi8(gray, mask2));
+    }
+    return i;
+  }
+
+  //----------------------------------------------------------------------------
+  // Window/level of 16 pixels per iteration. Returns the number of pixels that were converted.
+  template<typename ScalarType>
+  SLICERIGSIO_TARGET("avx2")
+  vtkIdType WindowLevelRowAVX2(const ScalarType* input, unsigned char* output, vtkIdType numberOfPixels, float lower, float scale)
+  {
+    const bool isSigned = static_cast<ScalarType>(-1) < 0;
+    const __m256 lowerV = _mm256_set1_ps(lower);
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    const __m256 halfV = _mm256_set1_ps(0.5f);
+    const __m256 zeroV = _mm256_setzero_ps();
+    const __m256 maxV = _mm256_set1_ps(255.0f);
+    vtkIdType i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+      __m128i valuesLow = _mm256_castsi256_si128(values);
+      __m128i valuesHigh = _mm256_extracti128_si256(values, 1);
+      __m256i low = isSigned ? _mm256_cvtepi16_epi32(valuesLow) : _mm256_cvtepu16_epi32(valuesLow);
+      __m256i high = isSigned ? _mm256_cvtepi16_epi32(valuesHigh) : _mm256_cvtepu16_epi32(valuesHigh);
+      __m256 lowF = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(low), lowerV), scaleV), halfV);
+      __m256 highF = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(high), lowerV), scaleV), halfV);
+      lowF = _mm256_min_ps(_mm256_max_ps(lowF, zeroV), maxV);
+      highF = _mm256_min_ps(_mm256_max_ps(highF, zeroV), maxV);
+      // Packing works within 128-bit lanes, so the 64-bit blocks are reordered before the final pack
+      __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(lowF), _mm256_cvttps_epi32(highF));
+      packed = _mm256_permute4x64_epi64(packed, 0xD8);
+      __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), bytes);
+    }
+    return i;
+  }
+
+  //----------------------------------------------------------------------------
+  // Window/level of 8 pixels per iteration. Returns the number of pixels that were converted.
+  template<typename ScalarType>
+  SLICERIGSIO_TARGET("sse2")
+  vtkIdType WindowLevelRowSSE2(const ScalarType* input, unsigned char* output, vtkIdType numberOfPixels, float lower, float scale)
+  {
+    const bool isSigned = static_cast<ScalarType>(-1) < 0;
+    const __m128 lowerV = _mm_set1_ps(lower);
+    const __m128 scaleV = _mm_set1_ps(scale);
+    const __m128 halfV = _mm_set1_ps(0.5f);
+    const __m128 zeroV = _mm_setzero_ps();
+    const __m128 maxV = _mm_set1_ps(255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    vtkIdType i = 0;
+    for (; i + 8 <= numberOfPixels; i += 8)
+    {
+      __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+      __m128i low;
+      __m128i high;
+      if (isSigned)
+      {
+        // Sign extend by shifting the duplicated 16-bit values
+        low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+      }
+      else
+      {
+        low = _mm_unpacklo_epi16(values, zero);
+        high = _mm_unpackhi_epi16(values, zero);
+      }
+      __m128 lowF = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(low), lowerV), scaleV), halfV);
+      __m128 highF = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(high), lowerV), scaleV), halfV);
+      lowF = _mm_min_ps(_mm_max_ps(lowF, zeroV), maxV);
+      highF = _mm_min_ps(_mm_max_ps(highF, zeroV), maxV);
+      __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(lowF), _mm_cvttps_epi32(highF));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(packed, packed));
+    }
+    return i;
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  void GrayToRGBRow(const unsigned char* input, unsigned char* output, vtkIdType numberOfPixels)
+  {
+    vtkIdType i = 0;
+#if defined(SLICERIGSIO_USE_SIMD)
+    if (GetInstructionSetToUse() >= InstructionSetSSSE3)
+    {
+      i = GrayToRGBRowSSSE3(input, output, numberOfPixels);
+    }
+#endif
+    for (; i < numberOfPixels; ++i)
+    {
+      output[3 * i] = input[i];
+      output[3 * i + 1] = input[i];
+      output[3 * i + 2] = input[i];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // BT.601 luma with fixed point weights that sum to 256, so gray pixels (R = G = B) are unchanged.
+  void RGBToGrayRow(const unsigned char* input, unsigned char* output, vtkIdType numberOfPixels)
+  {
+    for (vtkIdType i = 0; i < numberOfPixels; ++i)
+    {
+      output[i] = static_cast<unsigned char>((77 * input[3 * i] + 150 * input[3 * i + 1] + 29 * input[3 * i + 2] + 128) >> 8);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Output value is round((value - lower) * scale), clamped to 0-255.
+  template<typename ScalarType>
+  void WindowLevelRow(const ScalarType* input, unsigned char* output, vtkIdType numberOfPixels, float lower, float scale)
+  {
+    vtkIdType i = 0;
+#if defined(SLICERIGSIO_USE_SIMD)
+    // The pixels that are left over by the AVX2 loop are converted with SSE2, which is supported by every AVX2 processor
+    InstructionSet instructionSet = GetInstructionSetToUse();
+    if (instructionSet >= InstructionSetAVX2)
+    {
+      i = WindowLevelRowAVX2(input, output, numberOfPixels, lower, scale);
+    }
+    if (instructionSet >= InstructionSetSSE2)
+    {
+      i += WindowLevelRowSSE2(input + i, output + i, numberOfPixels - i, lower, scale);
+    }
+#endif
+    for (; i < numberOfPixels; ++i)
+    {
+      float value = (static_cast<float>(input[i]) - lower) * scale + 0.5f;
+      value = std::min(std::max(value, 0.0f), 255.0f);
+      output[i] = static_cast<unsigned char>(value);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOPixelConversion::IsConversionToRGBRequired(int scalarType, int numberOfComponents)
+{
+  if (numberOfComponents != 1)
+  {
+    return false;
+  }
+  return scalarType == VTK_UNSIGNED_CHAR || scalarType == VTK_UNSIGNED_SHORT || scalarType == VTK_SHORT;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOPixelConversion::GrayToRGB(vtkImageData* inputImageData, vtkImageData* outputImageData)
+{
+  if (!inputImageData || inputImageData->GetScalarType() != VTK_UNSIGNED_CHAR || inputImageData->GetNumberOfScalarComponents() != 1)
+  {
+    return false;
+  }
+  if (!AllocateOutputImage(inputImageData, outputImageData, 3))
+  {
+    return false;
+  }
+
+  GrayToRGBRow(static_cast<unsigned char*>(inputImageData->GetScalarPointer()),
+    static_cast<unsigned char*>(outputImageData->GetScalarPointer()), GetNumberOfPixels(inputImageData));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOPixelConversion::RGBToGray(vtkImageData* inputImageData, vtkImageData* outputImageData)
+{
+  if (!inputImageData || inputImageData->GetScalarType() != VTK_UNSIGNED_CHAR || inputImageData->GetNumberOfScalarComponents() != 3)
+  {
+    return false;
+  }
+  if (!AllocateOutputImage(inputImageData, outputImageData, 1))
+  {
+    return false;
+  }
+
+  RGBToGrayRow(static_cast<unsigned char*>(inputImageData->GetScalarPointer()),
+    static_cast<unsigned char*>(outputImageData->GetScalarPointer()), GetNumberOfPixels(inputImageData));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOPixelConversion::WindowLevelToGray(vtkImageData* inputImageData, vtkImageData* outputImageData, double window, double level)
+{
+  if (!inputImageData || inputImageData->GetNumberOfScalarComponents() != 1)
+  {
+    return false;
+  }
+  int scalarType = inputImageData->GetScalarType();
+  if (scalarType != VTK_UNSIGNED_SHORT && scalarType != VTK_SHORT)
+  {
+    return false;
+  }
+  if (!AllocateOutputImage(inputImageData, outputImageData, 1))
+  {
+    return false;
+  }
+
+  if (window <= 0.0)
+  {
+    double range[2] = { 0.0, 0.0 };
+    inputImageData->GetScalarRange(range);
+    window = std::max(range[1] - range[0], 1.0);
+    level = (range[0] + range[1]) / 2.0;
+  }
+  float lower = static_cast<float>(level - window / 2.0);
+  float scale = static_cast<float>(255.0 / window);
+
+  vtkIdType numberOfPixels = GetNumberOfPixels(inputImageData);
+  unsigned char* output = static_cast<unsigned char*>(outputImageData->GetScalarPointer());
+  if (scalarType == VTK_UNSIGNED_SHORT)
+  {
+    WindowLevelRow(static_cast<unsigned short*>(inputImageData->GetScalarPointer()), output, numberOfPixels, lower, scale);
+  }
+  else
+  {
+    WindowLevelRow(static_cast<short*>(inputImageData->GetScalarPointer()), output, numberOfPixels, lower, scale);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIGSIOPixelConversion::ConvertToRGB(vtkImageData* inputImageData, vtkImageData* outputImageData, double window, double level)
+{
+  if (!inputImageData)
+  {
+    return false;
+  }
+  if (inputImageData->GetScalarType() == VTK_UNSIGNED_CHAR)
+  {
+    return vtkSlicerIGSIOPixelConversion::GrayToRGB(inputImageData, outputImageData);
+  }
+
+  int dimensions[3] = { 0, 0, 0 };
+  inputImageData->GetDimensions(dimensions);
+  vtkSmartPointer<vtkImageData> grayImageData = vtkSlicerIGSIOBufferPool::GetInstance()->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 1);
+  bool success = vtkSlicerIGSIOPixelConversion::WindowLevelToGray(inputImageData, grayImageData, window, level)
+    && vtkSlicerIGSIOPixelConversion::GrayToRGB(grayImageData, outputImageData);
+  vtkSlicerIGSIOBufferPool::GetInstance()->ReleaseImageData(grayImageData);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerIGSIOPixelConversion::GetInstructionSet()
+{
+  switch (GetInstructionSetToUse())
+  {
+    case InstructionSetAVX2:
+      return "AVX2";
+    case InstructionSetSSSE3:
+      return "SSSE3";
+    case InstructionSetSSE2:
+      return "SSE2";
+    default:
+      return "Scalar";
+  }
+}
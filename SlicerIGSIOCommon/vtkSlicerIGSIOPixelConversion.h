@@ -0,0 +1,67 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOPixelConversion_h
+#define __vtkSlicerIGSIOPixelConversion_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// STD includes
+#include <string>
+
+class vtkImageData;
+
+/// Pixel format conversions that are applied to images before they are passed to a codec.
+///
+/// The inner loops use SSE2/SSSE3/AVX2 instructions on x86 processors. The instruction set is selected at runtime
+/// from the features of the processor, so the library does not need to be compiled with any instruction set flags.
+/// Other processors use scalar code. All slices of the input image are converted.
+///
+/// There are no YUV420 conversions: vtkStreamingVolumeCodec::EncodeImageData only accepts a vtkImageData that is
+/// interpreted as gray or RGB pixels, so codecs with YUV input (such as VP9) convert the image to their own format.
+/// Single component images are passed to these codecs unchanged, since expanding them to RGB first would only add work.
+/// The conversions, and the cost of converting gray images to I420 through RGB, are measured by vtkPixelConversionBenchmark.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOPixelConversion
+{
+public:
+  /// Returns true if the image must be converted to be encoded as 8-bit RGB.
+  static bool IsConversionToRGBRequired(int scalarType, int numberOfComponents);
+
+  /// Convert an 8-bit single component image to 8-bit RGB.
+  static bool GrayToRGB(vtkImageData* inputImageData, vtkImageData* outputImageData);
+
+  /// Convert an 8-bit RGB image to an 8-bit single component image containing the BT.601 luma.
+  /// Gray pixels are copied without change, so monochrome images are converted without loss.
+  static bool RGBToGray(vtkImageData* inputImageData, vtkImageData* outputImageData);
+
+  /// Map a 16-bit single component image to an 8-bit single component image using the specified window and level.
+  /// If window is less than or equal to 0, the scalar range of the input image is used.
+  static bool WindowLevelToGray(vtkImageData* inputImageData, vtkImageData* outputImageData, double window, double level);
+
+  /// Convert an 8-bit or 16-bit single component image to 8-bit RGB, applying the window and level to 16-bit images.
+  /// The intermediate 8-bit image of 16-bit inputs is taken from the shared buffer pool.
+  static bool ConvertToRGB(vtkImageData* inputImageData, vtkImageData* outputImageData, double window, double level);
+
+  /// Name of the instruction set that is used by the conversions on this processor: "AVX2", "SSSE3", "SSE2" or "Scalar".
+  static std::string GetInstructionSet();
+};
+
+#endif // __vtkSlicerIGSIOPixelConversion_h
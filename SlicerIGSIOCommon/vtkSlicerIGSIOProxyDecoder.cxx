@@ -0,0 +1,483 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOProxyDecoder.h"
+#include "vtkSlicerIGSIODecodedFrameCache.h"
+#include "vtkSlicerIGSIOKeyFrameIndex.h"
+#include "vtkSlicerIGSIOThreadPool.h"
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+#include <vtkStreamingVolumeFrame.h>
+
+// MRML includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOProxyDecoder);
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOProxyDecoder::vtkInternal
+{
+public:
+  typedef std::pair<vtkMRMLSequenceBrowserNode*, vtkMRMLSequenceNode*> ProxyKey;
+
+  // Decoder of a sequence that is only used by the worker thread.
+  // The codec is created on the main thread, since the codec factory should only be accessed from the main thread.
+  struct SequenceDecoder
+  {
+    vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+    std::string CodecFourCC;
+    vtkSmartPointer<vtkStreamingVolumeFrame> LastDecodedFrame;
+  };
+
+  // Frames that are decoded in order to decode the requested item, ending with the requested item.
+  // Frames that are not stored in consecutive items of the sequence have item number -1 and are not added to the cache.
+  struct DecodeRequest
+  {
+    ProxyKey Key;
+    unsigned int Generation;
+    std::shared_ptr<std::atomic<unsigned int> > LatestGeneration;
+    std::shared_ptr<SequenceDecoder> Decoder;
+    bool LumaOnly;
+    std::vector<std::pair<int, vtkSmartPointer<vtkStreamingVolumeFrame> > > Frames;
+
+    bool IsSuperseded() const
+    {
+      return *this->LatestGeneration != this->Generation;
+    }
+  };
+
+  // State of a proxy node that is only accessed on the main thread, except for the latest generation
+  struct ProxyState
+  {
+    std::shared_ptr<std::atomic<unsigned int> > LatestGeneration;
+    vtkSmartPointer<vtkImageData> LastImageData;
+    ProxyState()
+      : LatestGeneration(std::make_shared<std::atomic<unsigned int> >(0))
+    {
+    }
+  };
+
+  vtkInternal()
+    : HasCompletedRequests(false)
+    , NumberOfDecodedRequests(0)
+    , NumberOfSupersededRequests(0)
+  {
+  }
+
+  std::shared_ptr<SequenceDecoder> GetDecoder(vtkMRMLSequenceNode* sequenceNode, const std::string& codecFourCC)
+  {
+    std::shared_ptr<SequenceDecoder>& decoder = this->Decoders[sequenceNode];
+    if (!decoder || decoder->CodecFourCC != codecFourCC)
+    {
+      // A new decoder is created instead of modifying the existing one, which may still be in use by the worker thread
+      decoder = std::make_shared<SequenceDecoder>();
+      decoder->CodecFourCC = codecFourCC;
+      decoder->Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(
+        vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
+    }
+    return decoder->Codec ? decoder : nullptr;
+  }
+
+  // Supersede the pending request of the proxy node. The worker thread stops decoding it before the next frame.
+  void SupersedeRequest(const ProxyKey& key)
+  {
+    std::map<ProxyKey, ProxyState>::iterator stateIt = this->ProxyStates.find(key);
+    if (stateIt != this->ProxyStates.end())
+    {
+      ++(*stateIt->second.LatestGeneration);
+    }
+  }
+
+  // Remove the decoded image of the proxy node that has not been processed yet
+  vtkSmartPointer<vtkImageData> TakeCompletedImage(const ProxyKey& key)
+  {
+    std::lock_guard<std::mutex> lock(this->CompletedMutex);
+    std::map<ProxyKey, vtkSmartPointer<vtkImageData> >::iterator imageIt = this->CompletedImages.find(key);
+    if (imageIt == this->CompletedImages.end())
+    {
+      return nullptr;
+    }
+    vtkSmartPointer<vtkImageData> imageData = imageIt->second;
+    this->CompletedImages.erase(imageIt);
+    return imageData;
+  }
+
+  // Run on the worker thread
+  void Decode(const DecodeRequest& request)
+  {
+    if (request.IsSuperseded())
+    {
+      ++this->NumberOfSupersededRequests;
+      return;
+    }
+
+    // Continue from the last frame that was decoded, if it is one of the reference frames of the request
+    SequenceDecoder* decoder = request.Decoder.get();
+    size_t firstIndex = 0;
+    for (size_t i = 0; i + 1 < request.Frames.size(); ++i)
+    {
+      if (request.Frames[i].second == decoder->LastDecodedFrame)
+      {
+        firstIndex = i + 1;
+      }
+    }
+
+    vtkSmartPointer<vtkImageData> imageData;
+    for (size_t i = firstIndex; i < request.Frames.size(); ++i)
+    {
+      if (request.IsSuperseded())
+      {
+        ++this->NumberOfSupersededRequests;
+        return;
+      }
+
+      vtkStreamingVolumeFrame* frame = request.Frames[i].second;
+      imageData = vtkSmartPointer<vtkImageData>::New();
+      if (!vtkSlicerIGSIOCommon::DecodeStreamingVolumeFrame(decoder->Codec, frame, imageData, request.LumaOnly))
+      {
+        decoder->LastDecodedFrame = nullptr;
+        return;
+      }
+      decoder->LastDecodedFrame = frame;
+      if (request.Frames[i].first >= 0)
+      {
+        this->Cache->AddImage(request.Key.second, request.Frames[i].first, frame, imageData);
+      }
+    }
+    ++this->NumberOfDecodedRequests;
+
+    // The request is checked again while the lock is held, so that the image of a removed proxy node is never stored
+    std::lock_guard<std::mutex> lock(this->CompletedMutex);
+    if (!request.IsSuperseded())
+    {
+      this->CompletedImages[request.Key] = imageData;
+      this->HasCompletedRequests = true;
+    }
+  }
+
+  vtkSmartPointer<vtkSlicerIGSIODecodedFrameCache> Cache;
+  std::map<vtkMRMLSequenceNode*, std::shared_ptr<SequenceDecoder> > Decoders;
+  std::map<ProxyKey, ProxyState> ProxyStates;
+
+  // Images that were decoded by the worker thread and have not been set in the proxy nodes yet
+  std::mutex CompletedMutex;
+  std::map<ProxyKey, vtkSmartPointer<vtkImageData> > CompletedImages;
+  std::atomic<bool> HasCompletedRequests;
+
+  std::atomic<vtkIdType> NumberOfDecodedRequests;
+  std::atomic<vtkIdType> NumberOfSupersededRequests;
+
+  // Single worker thread, so that the frames of each decoder are decoded in order
+  std::unique_ptr<vtkSlicerIGSIOThreadPool> ThreadPool;
+};
+
+//---------------------------------------------------------------------------
+namespace
+{
+  // Number of components of the image that is decoded from the frame
+  int GetDecodedNumberOfComponents(vtkStreamingVolumeFrame* frame, bool lumaOnly)
+  {
+    if (lumaOnly && frame->GetVTKScalarType() == VTK_UNSIGNED_CHAR && frame->GetNumberOfComponents() == 3)
+    {
+      return 1;
+    }
+    return frame->GetNumberOfComponents();
+  }
+
+  // The decoded images are shared with the decoded frame cache, so the proxy node gets its own image object
+  void SetProxyImageData(vtkMRMLStreamingVolumeNode* proxyNode, vtkImageData* imageData)
+  {
+    vtkSmartPointer<vtkImageData> proxyImageData = vtkSmartPointer<vtkImageData>::New();
+    proxyImageData->ShallowCopy(imageData);
+    proxyNode->SetAndObserveImageData(proxyImageData);
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOProxyDecoder::vtkSlicerIGSIOProxyDecoder()
+{
+  this->Internal = new vtkInternal();
+  this->Internal->Cache = vtkSlicerIGSIODecodedFrameCache::GetInstance();
+  this->Internal->ThreadPool.reset(new vtkSlicerIGSIOThreadPool(1));
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOProxyDecoder::~vtkSlicerIGSIOProxyDecoder()
+{
+  for (std::pair<const vtkInternal::ProxyKey, vtkInternal::ProxyState>& proxyState : this->Internal->ProxyStates)
+  {
+    ++(*proxyState.second.LatestGeneration);
+  }
+  this->Internal->ThreadPool.reset();
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfDecodedRequests: " << this->Internal->NumberOfDecodedRequests << "\n";
+  os << indent << "NumberOfSupersededRequests: " << this->Internal->NumberOfSupersededRequests << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::SetDecodedFrameCache(vtkSlicerIGSIODecodedFrameCache* cache)
+{
+  if (this->Internal->Cache == cache)
+  {
+    return;
+  }
+  // The worker thread must not use the previous cache anymore
+  this->Wait();
+  this->Internal->Cache = cache ? cache : vtkSlicerIGSIODecodedFrameCache::GetInstance();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIODecodedFrameCache* vtkSlicerIGSIOProxyDecoder::GetDecodedFrameCache()
+{
+  return this->Internal->Cache;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::RequestUpdate(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!browserNode)
+  {
+    return;
+  }
+
+  vtkMRMLSequenceNode* masterSequenceNode = browserNode->GetMasterSequenceNode();
+  int selectedItemNumber = browserNode->GetSelectedItemNumber();
+  if (!masterSequenceNode || selectedItemNumber < 0 || selectedItemNumber >= masterSequenceNode->GetNumberOfDataNodes())
+  {
+    return;
+  }
+
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    // Decoded images must not be written back to the sequence
+    if (!sequenceNode || browserNode->GetSaveChanges(sequenceNode))
+    {
+      continue;
+    }
+    vtkMRMLStreamingVolumeNode* proxyNode = vtkMRMLStreamingVolumeNode::SafeDownCast(browserNode->GetProxyNode(sequenceNode));
+    if (!proxyNode)
+    {
+      continue;
+    }
+
+    int itemNumber = selectedItemNumber;
+    if (sequenceNode != masterSequenceNode)
+    {
+      itemNumber = sequenceNode->GetItemNumberFromIndexValue(masterSequenceNode->GetNthIndexValue(selectedItemNumber));
+    }
+    vtkMRMLStreamingVolumeNode* itemNode = vtkMRMLStreamingVolumeNode::SafeDownCast(itemNumber >= 0 ? sequenceNode->GetNthDataNode(itemNumber) : nullptr);
+    vtkStreamingVolumeFrame* frame = itemNode ? itemNode->GetFrame() : nullptr;
+    if (!frame)
+    {
+      continue;
+    }
+
+    // The image of a previous request that completed but has not been processed is still newer than the last image
+    vtkInternal::ProxyKey key(browserNode, sequenceNode);
+    this->Internal->SupersedeRequest(key);
+    vtkInternal::ProxyState& proxyState = this->Internal->ProxyStates[key];
+    vtkSmartPointer<vtkImageData> completedImageData = this->Internal->TakeCompletedImage(key);
+    if (completedImageData)
+    {
+      proxyState.LastImageData = completedImageData;
+    }
+    bool lumaOnly = vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(sequenceNode);
+
+    vtkSmartPointer<vtkImageData> cachedImageData = this->Internal->Cache->FindImage(sequenceNode, itemNumber, frame);
+    if (cachedImageData && cachedImageData->GetNumberOfScalarComponents() == GetDecodedNumberOfComponents(frame, lumaOnly))
+    {
+      proxyState.LastImageData = cachedImageData;
+      SetProxyImageData(proxyNode, cachedImageData);
+      continue;
+    }
+
+    // Keep showing the most recently decoded image until the image of the selected item is decoded
+    if (proxyState.LastImageData)
+    {
+      SetProxyImageData(proxyNode, proxyState.LastImageData);
+    }
+
+    vtkInternal::DecodeRequest request;
+    request.Key = key;
+    request.LatestGeneration = proxyState.LatestGeneration;
+    request.Generation = *proxyState.LatestGeneration;
+    request.LumaOnly = lumaOnly;
+    request.Decoder = this->Internal->GetDecoder(sequenceNode, frame->GetCodecFourCC());
+    if (!request.Decoder)
+    {
+      vtkErrorMacro("RequestUpdate: Could not find codec: " << frame->GetCodecFourCC());
+      continue;
+    }
+
+    int keyFrameItemNumber = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode)->GetKeyFrameItemNumber(itemNumber);
+    if (keyFrameItemNumber >= 0)
+    {
+      for (int i = keyFrameItemNumber; i <= itemNumber; ++i)
+      {
+        vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+        request.Frames.push_back(std::make_pair(i, vtkSmartPointer<vtkStreamingVolumeFrame>(streamingVolumeNode->GetFrame())));
+      }
+    }
+    else
+    {
+      // The previous frames are not stored in consecutive items, so the chain is followed back to the keyframe
+      for (vtkStreamingVolumeFrame* chainFrame = frame; chainFrame; chainFrame = chainFrame->GetPreviousFrame())
+      {
+        request.Frames.push_back(std::make_pair(chainFrame == frame ? itemNumber : -1, vtkSmartPointer<vtkStreamingVolumeFrame>(chainFrame)));
+        if (chainFrame->IsKeyFrame())
+        {
+          break;
+        }
+      }
+      std::reverse(request.Frames.begin(), request.Frames.end());
+    }
+
+    vtkInternal* internal = this->Internal;
+    this->Internal->ThreadPool->Submit([internal, request]()
+      {
+        internal->Decode(request);
+      });
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOProxyDecoder::HasCompletedRequests()
+{
+  return this->Internal->HasCompletedRequests;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOProxyDecoder::ProcessCompletedRequests()
+{
+  if (!this->Internal->HasCompletedRequests)
+  {
+    return 0;
+  }
+
+  std::map<vtkInternal::ProxyKey, vtkSmartPointer<vtkImageData> > completedImages;
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->CompletedMutex);
+    completedImages.swap(this->Internal->CompletedImages);
+    this->Internal->HasCompletedRequests = false;
+  }
+
+  int numberOfUpdatedProxyNodes = 0;
+  for (std::pair<const vtkInternal::ProxyKey, vtkSmartPointer<vtkImageData> >& completedImage : completedImages)
+  {
+    vtkMRMLSequenceBrowserNode* browserNode = completedImage.first.first;
+    vtkMRMLSequenceNode* sequenceNode = completedImage.first.second;
+    if (browserNode->GetSaveChanges(sequenceNode))
+    {
+      continue;
+    }
+    vtkMRMLStreamingVolumeNode* proxyNode = vtkMRMLStreamingVolumeNode::SafeDownCast(browserNode->GetProxyNode(sequenceNode));
+    if (!proxyNode)
+    {
+      continue;
+    }
+    this->Internal->ProxyStates[completedImage.first].LastImageData = completedImage.second;
+    SetProxyImageData(proxyNode, completedImage.second);
+    ++numberOfUpdatedProxyNodes;
+  }
+  return numberOfUpdatedProxyNodes;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::Wait()
+{
+  this->Internal->ThreadPool->Wait();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::RemoveSequence(vtkMRMLSequenceNode* sequenceNode)
+{
+  std::map<vtkInternal::ProxyKey, vtkInternal::ProxyState>::iterator stateIt = this->Internal->ProxyStates.begin();
+  while (stateIt != this->Internal->ProxyStates.end())
+  {
+    if (stateIt->first.second != sequenceNode)
+    {
+      ++stateIt;
+      continue;
+    }
+    this->Internal->SupersedeRequest(stateIt->first);
+    this->Internal->TakeCompletedImage(stateIt->first);
+    stateIt = this->Internal->ProxyStates.erase(stateIt);
+  }
+  // The worker thread keeps its own reference to the decoder, so it can be removed while it is in use
+  this->Internal->Decoders.erase(sequenceNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOProxyDecoder::RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  std::map<vtkInternal::ProxyKey, vtkInternal::ProxyState>::iterator stateIt = this->Internal->ProxyStates.begin();
+  while (stateIt != this->Internal->ProxyStates.end())
+  {
+    if (stateIt->first.first != browserNode)
+    {
+      ++stateIt;
+      continue;
+    }
+    this->Internal->SupersedeRequest(stateIt->first);
+    this->Internal->TakeCompletedImage(stateIt->first);
+    stateIt = this->Internal->ProxyStates.erase(stateIt);
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOProxyDecoder::GetNumberOfDecodedRequests()
+{
+  return this->Internal->NumberOfDecodedRequests;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerIGSIOProxyDecoder::GetNumberOfSupersededRequests()
+{
+  return this->Internal->NumberOfSupersededRequests;
+}
@@ -0,0 +1,99 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOProxyDecoder_h
+#define __vtkSlicerIGSIOProxyDecoder_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMRMLSequenceBrowserNode;
+class vtkMRMLSequenceNode;
+class vtkSlicerIGSIODecodedFrameCache;
+
+/// Decodes the selected frames of the streaming volume proxy nodes of sequence browsers on a worker thread.
+///
+/// RequestUpdate should be called when the selected item of a browser changes. If the decoded image of the selected item
+/// is in the decoded frame cache, the proxy node is updated immediately. Otherwise the frames that are needed to decode
+/// the item are collected on the main thread and decoded on the worker thread, and the proxy node keeps the most
+/// recently decoded image until the new image is available. The decoded frames are also added to the cache.
+/// The proxy nodes get a shallow copy of the decoded images, so that the cached images are not modified through them.
+///
+/// Only the latest request of each proxy node is decoded. A new request supersedes the pending request of the same
+/// proxy node, and the worker stops decoding a superseded request before its next frame, so moving the slider quickly
+/// does not queue up decoding work. The worker thread does not access MRML nodes, so the decoded images are set
+/// in the proxy nodes by ProcessCompletedRequests, which must be called periodically on the main thread.
+/// All methods must be called on the main thread, except HasCompletedRequests.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOProxyDecoder : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOProxyDecoder* New();
+  vtkTypeMacro(vtkSlicerIGSIOProxyDecoder, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Cache that the decoded frames are read from and added to.
+  /// Default is the shared instance of vtkSlicerIGSIODecodedFrameCache.
+  void SetDecodedFrameCache(vtkSlicerIGSIODecodedFrameCache* cache);
+  vtkSlicerIGSIODecodedFrameCache* GetDecodedFrameCache();
+
+  /// Request the decoded images of the selected item for the streaming volume proxy nodes of the browser.
+  /// Proxy nodes of sequences that the browser saves changes to are not modified, so decoded images are never
+  /// written into the sequence.
+  void RequestUpdate(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Returns true if there are decoded images that have not been set in the proxy nodes yet. Thread safe.
+  bool HasCompletedRequests();
+
+  /// Set the images that were decoded since the last call in the proxy nodes.
+  /// Returns the number of proxy nodes that were updated.
+  int ProcessCompletedRequests();
+
+  /// Block until the worker thread has finished decoding the pending requests.
+  void Wait();
+
+  /// Remove the pending requests and decoders of the sequence. Should be called when the sequence node is removed from the scene.
+  void RemoveSequence(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Remove the pending requests of the browser. Should be called when the browser node is removed from the scene.
+  void RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode* browserNode);
+
+  //@{
+  /// Number of requests that were decoded by the worker thread, and number of requests that were superseded
+  /// by a newer request before they were decoded.
+  vtkIdType GetNumberOfDecodedRequests();
+  vtkIdType GetNumberOfSupersededRequests();
+  //@}
+
+protected:
+  vtkSlicerIGSIOProxyDecoder();
+  ~vtkSlicerIGSIOProxyDecoder() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOProxyDecoder(const vtkSlicerIGSIOProxyDecoder&); // Not implemented
+  void operator=(const vtkSlicerIGSIOProxyDecoder&);             // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOProxyDecoder_h
@@ -0,0 +1,117 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOThreadPool.h"
+
+//-------------------------------------------------------
+vtkSlicerIGSIOThreadPool::vtkSlicerIGSIOThreadPool(int numberOfThreads)
+  : NumberOfActiveTasks(0)
+  , Stopping(false)
+{
+  if (numberOfThreads < 1)
+  {
+    numberOfThreads = vtkSlicerIGSIOThreadPool::GetDefaultNumberOfThreads();
+  }
+
+  for (int i = 0; i < numberOfThreads; ++i)
+  {
+    this->Threads.push_back(std::thread(&vtkSlicerIGSIOThreadPool::RunWorker, this));
+  }
+}
+
+//-------------------------------------------------------
+vtkSlicerIGSIOThreadPool::~vtkSlicerIGSIOThreadPool()
+{
+  this->Wait();
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Stopping = true;
+  }
+  this->TaskAvailable.notify_all();
+  for (std::thread& thread : this->Threads)
+  {
+    thread.join();
+  }
+}
+
+//-------------------------------------------------------
+void vtkSlicerIGSIOThreadPool::Submit(Task task)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Tasks.push_back(task);
+  }
+  this->TaskAvailable.notify_one();
+}
+
+//-------------------------------------------------------
+void vtkSlicerIGSIOThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (!this->Tasks.empty() || this->NumberOfActiveTasks > 0)
+  {
+    this->TasksCompleted.wait(lock);
+  }
+}
+
+//-------------------------------------------------------
+int vtkSlicerIGSIOThreadPool::GetNumberOfThreads() const
+{
+  return static_cast<int>(this->Threads.size());
+}
+
+//-------------------------------------------------------
+int vtkSlicerIGSIOThreadPool::GetDefaultNumberOfThreads()
+{
+  int numberOfThreads = static_cast<int>(std::thread::hardware_concurrency());
+  return numberOfThreads > 0 ? numberOfThreads : 1;
+}
+
+//-------------------------------------------------------
+void vtkSlicerIGSIOThreadPool::RunWorker()
+{
+  while (true)
+  {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(this->Mutex);
+      while (this->Tasks.empty() && !this->Stopping)
+      {
+        this->TaskAvailable.wait(lock);
+      }
+      if (this->Tasks.empty())
+      {
+        // Stopping and no more tasks to run
+        return;
+      }
+      task = this->Tasks.front();
+      this->Tasks.pop_front();
+      ++this->NumberOfActiveTasks;
+    }
+
+    task();
+
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      --this->NumberOfActiveTasks;
+    }
+    this->TasksCompleted.notify_all();
+  }
+}
@@ -0,0 +1,78 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOThreadPool_h
+#define __vtkSlicerIGSIOThreadPool_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// STD includes
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed size pool of worker threads used for parallel encoding and decoding.
+/// Tasks are started in the order that they are submitted.
+/// The tasks must not access MRML nodes that are in a scene, since they are run outside of the main thread.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOThreadPool
+{
+public:
+  typedef std::function<void()> Task;
+
+  /// Start the worker threads.
+  /// If numberOfThreads is less than 1, then one thread is started for each hardware core.
+  vtkSlicerIGSIOThreadPool(int numberOfThreads);
+
+  /// Wait for all submitted tasks to complete and stop the worker threads.
+  ~vtkSlicerIGSIOThreadPool();
+
+  /// Add a task to the queue.
+  void Submit(Task task);
+
+  /// Block until all of the submitted tasks have completed.
+  void Wait();
+
+  /// Returns the number of worker threads in the pool.
+  int GetNumberOfThreads() const;
+
+  /// Returns the number of threads that are used if the requested number of threads is less than 1.
+  static int GetDefaultNumberOfThreads();
+
+protected:
+  void RunWorker();
+
+  std::vector<std::thread> Threads;
+  std::deque<Task>         Tasks;
+  std::mutex               Mutex;
+  std::condition_variable  TaskAvailable;
+  std::condition_variable  TasksCompleted;
+  int                      NumberOfActiveTasks;
+  bool                     Stopping;
+
+private:
+  vtkSlicerIGSIOThreadPool(const vtkSlicerIGSIOThreadPool&); // Not implemented
+  void operator=(const vtkSlicerIGSIOThreadPool&);           // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOThreadPool_h
@@ -0,0 +1,375 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#include "vtkSlicerIGSIOTransformSequence.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerIGSIOTransformSequence);
+
+namespace
+{
+  struct SequenceTransforms
+  {
+    vtkWeakPointer<vtkMRMLSequenceNode> SequenceNode;
+    vtkSmartPointer<vtkSlicerIGSIOTransformSequence> Transforms;
+  };
+
+  // Shared compact transforms, by sequence node
+  std::map<vtkMRMLSequenceNode*, SequenceTransforms> SequenceTransformsMap;
+
+  const int MATRIX_ELEMENT_COUNT = 16;
+}
+
+//---------------------------------------------------------------------------
+class vtkSlicerIGSIOTransformSequence::vtkInternal
+{
+public:
+  std::string TransformName;
+
+  // Per transform
+  std::vector<double> Timestamps;
+  std::vector<double> MatrixElements;
+  std::vector<unsigned char> ValidFlags;
+
+  bool IsValidTransformNumber(int n)
+  {
+    return n >= 0 && n < static_cast<int>(this->Timestamps.size());
+  }
+};
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOTransformSequence::vtkSlicerIGSIOTransformSequence()
+{
+  this->Internal = new vtkInternal();
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOTransformSequence::~vtkSlicerIGSIOTransformSequence()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "TransformName: " << this->Internal->TransformName << "\n";
+  os << indent << "NumberOfTransforms: " << this->Internal->Timestamps.size() << "\n";
+  os << indent << "MemorySize: " << this->GetMemorySize() << "\n";
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOTransformSequence* vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(vtkMRMLSequenceNode* sequenceNode)
+{
+  if (!sequenceNode)
+  {
+    return nullptr;
+  }
+
+  std::map<vtkMRMLSequenceNode*, SequenceTransforms>::iterator sequenceTransformsIt = SequenceTransformsMap.find(sequenceNode);
+  if (sequenceTransformsIt == SequenceTransformsMap.end())
+  {
+    return nullptr;
+  }
+  if (sequenceTransformsIt->second.SequenceNode != sequenceNode)
+  {
+    // A deleted sequence node was at the same address
+    SequenceTransformsMap.erase(sequenceTransformsIt);
+    return nullptr;
+  }
+  return sequenceTransformsIt->second.Transforms;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::SetSequenceTransforms(vtkMRMLSequenceNode* sequenceNode, vtkSlicerIGSIOTransformSequence* transformSequence)
+{
+  if (!sequenceNode)
+  {
+    return;
+  }
+  if (!transformSequence)
+  {
+    SequenceTransformsMap.erase(sequenceNode);
+    return;
+  }
+
+  SequenceTransforms& sequenceTransforms = SequenceTransformsMap[sequenceNode];
+  sequenceTransforms.SequenceNode = sequenceNode;
+  sequenceTransforms.Transforms = transformSequence;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::RemoveSequenceTransforms(vtkMRMLSequenceNode* sequenceNode)
+{
+  SequenceTransformsMap.erase(sequenceNode);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOTransformSequence::ExpandSequenceTransforms(vtkMRMLSequenceNode* sequenceNode)
+{
+  vtkSmartPointer<vtkSlicerIGSIOTransformSequence> transformSequence = vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(sequenceNode);
+  if (!transformSequence)
+  {
+    return false;
+  }
+  if (!transformSequence->WriteToSequence(sequenceNode))
+  {
+    return false;
+  }
+  // The proxy node is now updated from the data nodes
+  vtkSlicerIGSIOTransformSequence::RemoveSequenceTransforms(sequenceNode);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!browserNode || SequenceTransformsMap.empty())
+  {
+    return 0;
+  }
+
+  vtkMRMLSequenceNode* masterSequenceNode = browserNode->GetMasterSequenceNode();
+  int selectedItemNumber = browserNode->GetSelectedItemNumber();
+  if (!masterSequenceNode || selectedItemNumber < 0 || selectedItemNumber >= masterSequenceNode->GetNumberOfDataNodes())
+  {
+    return 0;
+  }
+  double timestamp = std::strtod(masterSequenceNode->GetNthIndexValue(selectedItemNumber).c_str(), nullptr);
+
+  int numberOfUpdatedProxyNodes = 0;
+  vtkNew<vtkMatrix4x4> matrix;
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    vtkSlicerIGSIOTransformSequence* transformSequence = vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(sequenceNode);
+    if (!transformSequence)
+    {
+      continue;
+    }
+
+    vtkMRMLLinearTransformNode* proxyNode = vtkMRMLLinearTransformNode::SafeDownCast(browserNode->GetProxyNode(sequenceNode));
+    int transformNumber = transformSequence->GetTransformNumberFromTimestamp(timestamp);
+    if (!proxyNode || !transformSequence->GetNthTransform(transformNumber, matrix))
+    {
+      continue;
+    }
+    proxyNode->SetMatrixTransformToParent(matrix);
+    ++numberOfUpdatedProxyNodes;
+  }
+  return numberOfUpdatedProxyNodes;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::SetTransformName(const std::string& transformName)
+{
+  if (this->Internal->TransformName == transformName)
+  {
+    return;
+  }
+  this->Internal->TransformName = transformName;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerIGSIOTransformSequence::GetTransformName()
+{
+  return this->Internal->TransformName;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::Reserve(int numberOfTransforms)
+{
+  if (numberOfTransforms < 0)
+  {
+    return;
+  }
+  this->Internal->Timestamps.reserve(numberOfTransforms);
+  this->Internal->MatrixElements.reserve(static_cast<size_t>(numberOfTransforms) * MATRIX_ELEMENT_COUNT);
+  this->Internal->ValidFlags.reserve(numberOfTransforms);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::Clear()
+{
+  this->Internal->Timestamps.clear();
+  this->Internal->MatrixElements.clear();
+  this->Internal->ValidFlags.clear();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIGSIOTransformSequence::AddTransform(double timestamp, vtkMatrix4x4* matrix, bool valid)
+{
+  if (!matrix)
+  {
+    vtkErrorMacro("AddTransform: Invalid matrix");
+    return;
+  }
+  if (!this->Internal->Timestamps.empty() && timestamp < this->Internal->Timestamps.back())
+  {
+    vtkErrorMacro("AddTransform: Transforms must be added in increasing order of timestamp");
+    return;
+  }
+
+  this->Internal->Timestamps.push_back(timestamp);
+  const double* elements = &matrix->Element[0][0];
+  this->Internal->MatrixElements.insert(this->Internal->MatrixElements.end(), elements, elements + MATRIX_ELEMENT_COUNT);
+  this->Internal->ValidFlags.push_back(valid ? 1 : 0);
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOTransformSequence::GetNumberOfTransforms()
+{
+  return static_cast<int>(this->Internal->Timestamps.size());
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerIGSIOTransformSequence::GetNthTimestamp(int n)
+{
+  if (!this->Internal->IsValidTransformNumber(n))
+  {
+    vtkErrorMacro("GetNthTimestamp: Invalid transform number " << n);
+    return 0.0;
+  }
+  return this->Internal->Timestamps[n];
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOTransformSequence::GetNthTransform(int n, vtkMatrix4x4* matrix)
+{
+  if (!matrix || !this->Internal->IsValidTransformNumber(n))
+  {
+    return false;
+  }
+  matrix->DeepCopy(&this->Internal->MatrixElements[static_cast<size_t>(n) * MATRIX_ELEMENT_COUNT]);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOTransformSequence::GetNthTransformValid(int n)
+{
+  if (!this->Internal->IsValidTransformNumber(n))
+  {
+    return false;
+  }
+  return this->Internal->ValidFlags[n] != 0;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerIGSIOTransformSequence::GetTransformNumberFromTimestamp(double timestamp)
+{
+  const std::vector<double>& timestamps = this->Internal->Timestamps;
+  if (timestamps.empty())
+  {
+    return -1;
+  }
+
+  std::vector<double>::const_iterator upperIt = std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+  if (upperIt == timestamps.begin())
+  {
+    return 0;
+  }
+  if (upperIt == timestamps.end())
+  {
+    return static_cast<int>(timestamps.size()) - 1;
+  }
+  std::vector<double>::const_iterator lowerIt = upperIt - 1;
+  if (timestamp - *lowerIt <= *upperIt - timestamp)
+  {
+    return static_cast<int>(lowerIt - timestamps.begin());
+  }
+  return static_cast<int>(upperIt - timestamps.begin());
+}
+
+//---------------------------------------------------------------------------
+unsigned long long vtkSlicerIGSIOTransformSequence::GetMemorySize()
+{
+  return this->Internal->Timestamps.capacity() * sizeof(double)
+    + this->Internal->MatrixElements.capacity() * sizeof(double)
+    + this->Internal->ValidFlags.capacity() * sizeof(unsigned char);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerIGSIOTransformSequence::WriteToSequence(vtkMRMLSequenceNode* sequenceNode)
+{
+  if (!sequenceNode)
+  {
+    vtkErrorMacro("WriteToSequence: Invalid sequence node");
+    return false;
+  }
+
+  int numberOfTransforms = this->GetNumberOfTransforms();
+  int frameNumberMaxLength = numberOfTransforms > 0 ? static_cast<int>(std::floor(std::log10(numberOfTransforms))) + 1 : 1;
+  vtkMRMLScene* scene = sequenceNode->GetScene();
+
+  int wasModifying = sequenceNode->StartModify();
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < numberOfTransforms; ++i)
+  {
+    vtkSmartPointer<vtkMRMLLinearTransformNode> transformNode;
+    if (scene)
+    {
+      transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::Take(vtkMRMLLinearTransformNode::SafeDownCast(scene->CreateNodeByClass("vtkMRMLLinearTransformNode")));
+    }
+    if (!transformNode)
+    {
+      transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+    }
+    this->GetNthTransform(i, matrix);
+    transformNode->SetMatrixTransformToParent(matrix);
+
+    // Generating a unique name is important because that will be used to generate the filename by default
+    std::string transformNodeName = this->Internal->TransformName + "Transform_";
+    char frameNumber[32];
+    snprintf(frameNumber, sizeof(frameNumber), "%0*d", frameNumberMaxLength, i);
+    transformNodeName += frameNumber;
+    transformNode->SetName(transformNodeName.c_str());
+
+    char indexValue[32];
+    snprintf(indexValue, sizeof(indexValue), "%g", this->Internal->Timestamps[i]);
+    sequenceNode->SetDataNodeAtValue(transformNode, indexValue);
+  }
+  sequenceNode->EndModify(wasModifying);
+  return true;
+}
@@ -0,0 +1,122 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerIGSIOTransformSequence_h
+#define __vtkSlicerIGSIOTransformSequence_h
+
+// vtkSlicerIGSIOCommon includes
+#include "vtkSlicerIGSIOCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+class vtkMatrix4x4;
+class vtkMRMLSequenceBrowserNode;
+class vtkMRMLSequenceNode;
+
+/// Compact storage of the transforms of a tracked tool.
+///
+/// The transforms are stored in contiguous arrays: the 16 elements of each matrix (row-major), the timestamp and a
+/// status flag that is true if the tool was tracked. This uses about 140 bytes per frame, instead of a
+/// vtkMRMLLinearTransformNode and vtkMatrix4x4 in the sequence for every frame.
+///
+/// A sequence node that stores compact transforms has no data nodes. The compact transforms of the sequence are shared
+/// using GetSequenceTransforms, and the proxy transform node of the sequence is set from them by UpdateProxyNodes
+/// when the selected item of the browser changes. The Sequences module does not know about compact transforms, so
+/// UpdateProxyNodes is called by vtkSlicerVideoUtilLogic for the browsers in its scene. Applications that do not
+/// load the VideoUtil module must call it after changing the selected item.
+///
+/// The sequence storage nodes only write data nodes, so ExpandSequenceTransforms must be called before a compact
+/// sequence is saved. vtkSlicerVideoUtilLogic does this for all sequences of the scene when the scene is saved.
+/// Must be used on the main thread.
+class VTK_SLICERIGSIOCOMMON_EXPORT vtkSlicerIGSIOTransformSequence : public vtkObject
+{
+public:
+  static vtkSlicerIGSIOTransformSequence* New();
+  vtkTypeMacro(vtkSlicerIGSIOTransformSequence, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Get the compact transforms of the sequence, or nullptr if the sequence does not store compact transforms.
+  static vtkSlicerIGSIOTransformSequence* GetSequenceTransforms(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Set the compact transforms of the sequence. The transforms are removed if transformSequence is nullptr.
+  static void SetSequenceTransforms(vtkMRMLSequenceNode* sequenceNode, vtkSlicerIGSIOTransformSequence* transformSequence);
+
+  /// Remove the compact transforms of the sequence.
+  static void RemoveSequenceTransforms(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Add a data node to the sequence for each compact transform using WriteToSequence, and remove the compact transforms,
+  /// so that the sequence can be saved. Returns false if the sequence does not store compact transforms.
+  static bool ExpandSequenceTransforms(vtkMRMLSequenceNode* sequenceNode);
+
+  /// Set the proxy transform nodes of the synchronized sequences of the browser that store compact transforms,
+  /// using the transform with the closest timestamp to the index value of the selected item of the master sequence.
+  /// Called by vtkSlicerVideoUtilLogic when the browser is modified.
+  /// Returns the number of proxy nodes that were updated.
+  static int UpdateProxyNodes(vtkMRMLSequenceBrowserNode* browserNode);
+
+  /// Name of the transform, used to name the data nodes that are created by WriteToSequence.
+  void SetTransformName(const std::string& transformName);
+  std::string GetTransformName();
+
+  /// Reserve memory for the specified number of transforms.
+  void Reserve(int numberOfTransforms);
+
+  /// Remove all transforms.
+  void Clear();
+
+  /// Add a transform. The transforms must be added in increasing order of timestamp.
+  void AddTransform(double timestamp, vtkMatrix4x4* matrix, bool valid);
+
+  /// Number of transforms in the sequence.
+  int GetNumberOfTransforms();
+
+  //@{
+  /// Get the timestamp, the matrix and the status flag of the nth transform.
+  double GetNthTimestamp(int n);
+  bool GetNthTransform(int n, vtkMatrix4x4* matrix);
+  bool GetNthTransformValid(int n);
+  //@}
+
+  /// Get the number of the transform with the closest timestamp, or -1 if the sequence is empty.
+  int GetTransformNumberFromTimestamp(double timestamp);
+
+  /// Memory that is used by the transforms, in bytes.
+  unsigned long long GetMemorySize();
+
+  /// Add a linear transform data node to the sequence for each transform, using the formatted timestamps as index values.
+  bool WriteToSequence(vtkMRMLSequenceNode* sequenceNode);
+
+protected:
+  vtkSlicerIGSIOTransformSequence();
+  ~vtkSlicerIGSIOTransformSequence() override;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkSlicerIGSIOTransformSequence(const vtkSlicerIGSIOTransformSequence&); // Not implemented
+  void operator=(const vtkSlicerIGSIOTransformSequence&);                  // Not implemented
+};
+
+#endif // __vtkSlicerIGSIOTransformSequence_h
@@ -36,8 +36,24 @@ Care Ontario.
 // VideoUtil includes
 #include "vtkSlicerVideoUtilLogic.h"
 
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIODecodedFrameCache.h>
+#include <vtkSlicerIGSIOFramePrefetcher.h>
+#include <vtkSlicerIGSIOKeyFrameIndex.h>
+#include <vtkSlicerIGSIOProxyDecoder.h>
+#include <vtkSlicerIGSIOTransformSequence.h>
+
+// Sequences MRML includes
+#include <vtkMRMLSequenceNode.h>
+
 // VTK includes
+#include <vtkFloatArray.h>
+#include <vtkIntArray.h>
 #include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerVideoUtilLogic);
@@ -51,6 +67,8 @@ public:
   ~vtkInternal();
 
   vtkSlicerVideoUtilLogic* External;
+  vtkNew<vtkSlicerIGSIOFramePrefetcher> FramePrefetcher;
+  vtkNew<vtkSlicerIGSIOProxyDecoder> ProxyDecoder;
 };
 
 //----------------------------------------------------------------------------
@@ -72,6 +90,9 @@ vtkSlicerVideoUtilLogic::vtkInternal::~vtkInternal()
 
 //---------------------------------------------------------------------------
 vtkSlicerVideoUtilLogic::vtkSlicerVideoUtilLogic()
+  : DecodedFrameCacheEnabled(false)
+  , PrefetchEnabled(false)
+  , ProxyDecodingInBackground(false)
 {
   this->Internal = new vtkInternal(this);
 }
@@ -95,9 +116,164 @@ void vtkSlicerVideoUtilLogic::RegisterNodes()
   }
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::StartSaveEvent);
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(node);
+  if (!browserNode)
+  {
+    return;
+  }
+
+  // The proxy nodes are updated by the Sequences logic when the browser is modified.
+  // The observer has a lower priority, so that the decoded image is set after the proxy nodes have been updated.
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  vtkNew<vtkFloatArray> priorities;
+  priorities->InsertNextValue(-1.0);
+  this->GetMRMLNodesObserverManager()->AddObjectEvents(browserNode, events, priorities);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  if (vtkMRMLSequenceBrowserNode::SafeDownCast(node))
+  {
+    vtkUnObserveMRMLNodeMacro(node);
+    this->Internal->FramePrefetcher->RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode::SafeDownCast(node));
+    this->Internal->ProxyDecoder->RemoveSequenceBrowser(vtkMRMLSequenceBrowserNode::SafeDownCast(node));
+  }
+  else if (vtkMRMLSequenceNode::SafeDownCast(node))
+  {
+    vtkSlicerIGSIODecodedFrameCache::GetInstance()->RemoveSequence(vtkMRMLSequenceNode::SafeDownCast(node));
+    vtkSlicerIGSIOKeyFrameIndex::RemoveSequenceIndex(vtkMRMLSequenceNode::SafeDownCast(node));
+    vtkSlicerIGSIOTransformSequence::RemoveSequenceTransforms(vtkMRMLSequenceNode::SafeDownCast(node));
+    this->Internal->FramePrefetcher->RemoveSequence(vtkMRMLSequenceNode::SafeDownCast(node));
+    this->Internal->ProxyDecoder->RemoveSequence(vtkMRMLSequenceNode::SafeDownCast(node));
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(caller);
+  if (browserNode && event == vtkCommand::ModifiedEvent)
+  {
+    // The Sequences module does not update the proxy nodes of compact transform sequences
+    vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(browserNode);
+    this->UpdateProxyNodesFromDecodedFrameCache(browserNode);
+    return;
+  }
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::ProcessMRMLSceneEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  if (event == vtkMRMLScene::StartSaveEvent)
+  {
+    // Compact transform sequences have no data nodes, so they would be saved empty
+    this->ExpandCompactTransformSequences();
+  }
+  this->Superclass::ProcessMRMLSceneEvents(caller, event, callData);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::UpdateProxyNodesFromDecodedFrameCache(vtkMRMLSequenceBrowserNode* browserNode)
+{
+  if (!this->DecodedFrameCacheEnabled || !browserNode)
+  {
+    return;
+  }
+
+  // Selections made by export or by a script must update the proxy nodes before they return
+  if (this->ProxyDecodingInBackground && browserNode->GetPlaybackActive())
+  {
+    this->Internal->ProxyDecoder->RequestUpdate(browserNode);
+  }
+  else
+  {
+    // Images of earlier background requests must not replace the images of the selected item
+    this->Internal->ProxyDecoder->RemoveSequenceBrowser(browserNode);
+
+    std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+    browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+    for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+    {
+      if (!sequenceNode || sequenceNode->GetNumberOfDataNodes() < 1
+        || !vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(0)))
+      {
+        continue;
+      }
+      vtkSlicerIGSIODecodedFrameCache::GetInstance()->UpdateProxyNode(browserNode, sequenceNode);
+    }
+  }
+
+  if (this->PrefetchEnabled)
+  {
+    this->Internal->FramePrefetcher->Update(browserNode);
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOFramePrefetcher* vtkSlicerVideoUtilLogic::GetFramePrefetcher()
+{
+  return this->Internal->FramePrefetcher;
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerIGSIOProxyDecoder* vtkSlicerVideoUtilLogic::GetProxyDecoder()
+{
+  return this->Internal->ProxyDecoder;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoUtilLogic::ProcessDecodedProxyNodes()
+{
+  if (!this->Internal->ProxyDecoder->HasCompletedRequests())
+  {
+    return;
+  }
+  this->Internal->ProxyDecoder->ProcessCompletedRequests();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerVideoUtilLogic::ExpandCompactTransformSequences()
+{
+  if (!this->GetMRMLScene())
+  {
+    return 0;
+  }
+
+  int numberOfExpandedSequences = 0;
+  std::vector<vtkMRMLNode*> sequenceNodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLSequenceNode", sequenceNodes);
+  for (vtkMRMLNode* node : sequenceNodes)
+  {
+    if (vtkSlicerIGSIOTransformSequence::ExpandSequenceTransforms(vtkMRMLSequenceNode::SafeDownCast(node)))
+    {
+      ++numberOfExpandedSequences;
+    }
+  }
+  return numberOfExpandedSequences;
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerVideoUtilLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->vtkObject::PrintSelf(os, indent);
   os << indent << "vtkSlicerVideoUtilLogic:             " << this->GetClassName() << "\n";
+  os << indent << "DecodedFrameCacheEnabled: " << (this->DecodedFrameCacheEnabled ? "true" : "false") << "\n";
+  os << indent << "PrefetchEnabled: " << (this->PrefetchEnabled ? "true" : "false") << "\n";
+  os << indent << "ProxyDecodingInBackground: " << (this->ProxyDecodingInBackground ? "true" : "false") << "\n";
 }
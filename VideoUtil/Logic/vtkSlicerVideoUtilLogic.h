@@ -35,6 +35,8 @@ Care Ontario.
 #include <vtkMRMLSequenceBrowserNode.h>
 
 class vtkMRMLIGTLConnectorNode;
+class vtkSlicerIGSIOFramePrefetcher;
+class vtkSlicerIGSIOProxyDecoder;
 
 /// \ingroup Slicer_QtModules_VideoUtil
 class VTK_SLICER_VIDEOUTIL_MODULE_LOGIC_EXPORT vtkSlicerVideoUtilLogic : public vtkSlicerModuleLogic
@@ -58,7 +60,57 @@ public:
   // MRML Management
   //----------------------------------------------------------------
 
+  /// If enabled, the proxy nodes of streaming volume sequences are updated using the shared decoded frame cache
+  /// (vtkSlicerIGSIODecodedFrameCache) when the selected item of a sequence browser changes, so that frames
+  /// that were already decoded are not decoded again. Disabled by default.
+  vtkSetMacro(DecodedFrameCacheEnabled, bool);
+  vtkGetMacro(DecodedFrameCacheEnabled, bool);
+  vtkBooleanMacro(DecodedFrameCacheEnabled, bool);
+
+  /// If enabled, the frames that follow the selected item of a sequence browser in the direction of playback
+  /// are decoded on a background thread and added to the decoded frame cache. Requires DecodedFrameCacheEnabled.
+  /// Disabled by default.
+  vtkSetMacro(PrefetchEnabled, bool);
+  vtkGetMacro(PrefetchEnabled, bool);
+  vtkBooleanMacro(PrefetchEnabled, bool);
+
+  /// Prefetcher that decodes the upcoming frames of the sequence browsers.
+  vtkSlicerIGSIOFramePrefetcher* GetFramePrefetcher();
+
+  /// If enabled, the frames of the proxy nodes that are not in the decoded frame cache are decoded on a worker thread
+  /// while the browser is playing, and the proxy nodes are updated by ProcessDecodedProxyNodes. Only the most recently
+  /// selected item is decoded, and the proxy nodes keep the previous image until then. Items that are selected while the
+  /// browser is not playing, for example by export or by a script, are decoded immediately, so the proxy nodes always
+  /// contain the image of the selected item. Requires DecodedFrameCacheEnabled. Disabled by default.
+  vtkSetMacro(ProxyDecodingInBackground, bool);
+  vtkGetMacro(ProxyDecodingInBackground, bool);
+  vtkBooleanMacro(ProxyDecodingInBackground, bool);
+
+  /// Decoder that decodes the frames of the proxy nodes on a worker thread.
+  vtkSlicerIGSIOProxyDecoder* GetProxyDecoder();
+
+  /// Set the images that were decoded by the proxy decoder in the proxy nodes.
+  /// Must be called periodically on the main thread, for example from a timer.
+  void ProcessDecodedProxyNodes();
+
+  /// Add the data nodes of the compact transform sequences of the scene (see vtkSlicerIGSIOTransformSequence),
+  /// so that they are written by the sequence storage nodes. Called when the scene is saved.
+  /// Returns the number of sequences that were expanded.
+  int ExpandCompactTransformSequences();
+
 protected:
+  void SetMRMLSceneInternal(vtkMRMLScene* newScene) override;
+  void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
+  void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
+  void ProcessMRMLSceneEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
+  /// Update the proxy nodes of the streaming volume sequences of the browser from the decoded frame cache.
+  void UpdateProxyNodesFromDecodedFrameCache(vtkMRMLSequenceBrowserNode* browserNode);
+
+  bool DecodedFrameCacheEnabled;
+  bool PrefetchEnabled;
+  bool ProxyDecodingInBackground;
 
   //----------------------------------------------------------------
   // Constructor, destructor etc.
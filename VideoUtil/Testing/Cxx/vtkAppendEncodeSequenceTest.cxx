@@ -0,0 +1,233 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncoderState.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+//---------------------------------------------------------------------------
+void AddTestingFrames(vtkMRMLSequenceNode* sequenceNode, int startFrame, int numFrames)
+{
+  for (int i = startFrame; i < startFrame + numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+}
+
+//---------------------------------------------------------------------------
+vtkStreamingVolumeFrame* GetTestingFrame(vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+{
+  vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber));
+  return streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+}
+
+//---------------------------------------------------------------------------
+// Check that all frames are encoded, and that the frames decode to the values of the testing frames
+bool CheckTestingFrames(vtkMRMLSequenceNode* sequenceNode)
+{
+  vtkNew<vtkImageData> imageData;
+  vtkNew<vtkMRMLStreamingVolumeNode> decodingNode;
+  for (int i = 0; i < sequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    vtkStreamingVolumeFrame* frame = GetTestingFrame(sequenceNode, i);
+    if (!frame)
+    {
+      std::cerr << "Frame " << i << " was not encoded" << std::endl;
+      return false;
+    }
+    if (frame->GetCodecFourCC() != "TIFC")
+    {
+      continue;
+    }
+
+    // The inter frames can only be decoded after the previous frames
+    decodingNode->SetAndObserveFrame(frame);
+    vtkImageData* decodedImageData = decodingNode->GetImageData();
+    unsigned char* pixels = decodedImageData ? static_cast<unsigned char*>(decodedImageData->GetScalarPointer()) : nullptr;
+    int expectedValue = atoi(sequenceNode->GetNthIndexValue(i).c_str());
+    if (!pixels || pixels[0] != expectedValue)
+    {
+      std::cerr << "Frame " << i << " was not decoded correctly" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkAppendEncodeSequenceTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  AddTestingFrames(sequenceNode, 0, 20);
+
+  std::string codecFourCC = "RV24";
+  std::map<std::string, std::string> codecParameters;
+
+  // First save encodes the whole sequence
+  vtkNew<vtkSlicerIGSIOEncoderState> encoderState;
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(sequenceNode, codecFourCC, codecParameters, encoderState)
+    || !encoderState->GetLastUpdateWasFull()
+    || encoderState->GetNumberOfFramesEncodedInLastUpdate() != 20
+    || encoderState->GetLastEncodedItemNumber() != 19)
+  {
+    encoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Only the appended frames are encoded by the next save
+  AddTestingFrames(sequenceNode, 20, 5);
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(sequenceNode, codecFourCC, codecParameters, encoderState)
+    || encoderState->GetLastUpdateWasFull()
+    || encoderState->GetNumberOfFramesEncodedInLastUpdate() != 5
+    || encoderState->GetLastEncodedItemNumber() != 24)
+  {
+    encoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < sequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+    if (!streamingVolumeNode || !streamingVolumeNode->GetFrame())
+    {
+      std::cerr << "Frame " << i << " was not encoded" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Nothing to do if no frames were added
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(sequenceNode, codecFourCC, codecParameters, encoderState)
+    || encoderState->GetLastUpdateWasFull()
+    || encoderState->GetNumberOfFramesEncodedInLastUpdate() != 0)
+  {
+    encoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Removing the last encoded frame invalidates the state
+  sequenceNode->RemoveDataNodeAtValue("24");
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(sequenceNode, codecFourCC, codecParameters, encoderState)
+    || !encoderState->GetLastUpdateWasFull()
+    || encoderState->GetLastEncodedItemNumber() != 23)
+  {
+    encoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Replacing a frame in the middle of the sequence invalidates the state, and only the replaced frame is re-encoded
+  AddTestingFrames(sequenceNode, 10, 1);
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(sequenceNode, codecFourCC, codecParameters, encoderState)
+    || !encoderState->GetLastUpdateWasFull()
+    || encoderState->GetNumberOfFramesEncodedInLastUpdate() != 1
+    || encoderState->GetLastEncodedItemNumber() != 23
+    || !CheckTestingFrames(sequenceNode))
+  {
+    encoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Appended frames of an inter-frame codec continue the stream of the last encoded frame
+  vtkTestingInterFrameCodec::Register();
+  vtkNew<vtkMRMLSequenceNode> interFrameSequenceNode;
+  scene->AddNode(interFrameSequenceNode);
+  AddTestingFrames(interFrameSequenceNode, 0, 10);
+  vtkNew<vtkSlicerIGSIOEncoderState> interFrameEncoderState;
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, interFrameEncoderState)
+    || !interFrameEncoderState->GetLastUpdateWasFull()
+    || interFrameEncoderState->GetNumberOfFramesEncodedInLastUpdate() != 10
+    || !CheckTestingFrames(interFrameSequenceNode))
+  {
+    interFrameEncoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The codec of the full encoding is not kept, so the first appended frame is a keyframe
+  AddTestingFrames(interFrameSequenceNode, 10, 5);
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, interFrameEncoderState)
+    || interFrameEncoderState->GetLastUpdateWasFull()
+    || interFrameEncoderState->GetNumberOfFramesEncodedInLastUpdate() != 5
+    || !GetTestingFrame(interFrameSequenceNode, 10)->IsKeyFrame()
+    || GetTestingFrame(interFrameSequenceNode, 14)->GetPreviousFrame() != GetTestingFrame(interFrameSequenceNode, 13)
+    || !CheckTestingFrames(interFrameSequenceNode))
+  {
+    interFrameEncoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The next appended frames are encoded by the same codec, so they reference the last encoded frame
+  AddTestingFrames(interFrameSequenceNode, 15, 3);
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, interFrameEncoderState)
+    || interFrameEncoderState->GetLastUpdateWasFull()
+    || interFrameEncoderState->GetNumberOfFramesEncodedInLastUpdate() != 3
+    || GetTestingFrame(interFrameSequenceNode, 15)->IsKeyFrame()
+    || GetTestingFrame(interFrameSequenceNode, 15)->GetPreviousFrame() != GetTestingFrame(interFrameSequenceNode, 14)
+    || !CheckTestingFrames(interFrameSequenceNode))
+  {
+    interFrameEncoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Replacing an inter frame in the middle of the stream invalidates the state, and the stream is re-encoded from there
+  AddTestingFrames(interFrameSequenceNode, 12, 1);
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, interFrameEncoderState)
+    || !interFrameEncoderState->GetLastUpdateWasFull()
+    || interFrameEncoderState->GetNumberOfFramesEncodedInLastUpdate() < 1
+    || interFrameEncoderState->GetLastEncodedItemNumber() != 17
+    || !CheckTestingFrames(interFrameSequenceNode))
+  {
+    interFrameEncoderState->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOBufferPool.h>
+
+//---------------------------------------------------------------------------
+int vtkBufferPoolTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSlicerIGSIOBufferPool> pool;
+
+  // Images are reused if the dimensions and type match
+  int dimensions[3] = { 10, 10, 1 };
+  vtkSmartPointer<vtkImageData> imageData = pool->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 3);
+  void* scalarPointer = imageData->GetScalarPointer();
+  pool->ReleaseImageData(imageData);
+  imageData = nullptr;
+
+  imageData = pool->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 3);
+  if (imageData->GetScalarPointer() != scalarPointer
+    || pool->GetNumberOfImageHits() != 1 || pool->GetNumberOfImageMisses() != 1)
+  {
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Images that are referenced elsewhere are not pooled
+  vtkSmartPointer<vtkImageData> otherReference = imageData;
+  pool->ReleaseImageData(imageData);
+  if (pool->GetPooledBytes() != 0)
+  {
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  otherReference = nullptr;
+  imageData = nullptr;
+
+  // Different number of components is a miss
+  imageData = pool->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 1);
+  if (pool->GetNumberOfImageMisses() != 2 || imageData->GetNumberOfScalarComponents() != 1)
+  {
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  imageData = nullptr;
+
+  // Images that exceed the limit are not pooled
+  pool->Clear();
+  pool->SetMaximumPooledBytes(100);
+  imageData = pool->AcquireImageData(dimensions, VTK_UNSIGNED_CHAR, 3);
+  pool->ReleaseImageData(imageData);
+  imageData = nullptr;
+  if (pool->GetPooledBytes() != 0)
+  {
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOBufferPool.h>
+#include <vtkSlicerIGSIOCommon.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+//---------------------------------------------------------------------------
+int vtkBulkDecodeSequenceTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int numFrames = 10;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 8, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // All frames are decoded into one slice each
+  vtkNew<vtkImageData> outputImageData;
+  if (!vtkSlicerIGSIOCommon::DecodeVideoSequence(sequenceNode, outputImageData))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // The decoding buffers are freed when the decoding is finished
+  if (vtkSlicerIGSIOBufferPool::GetInstance()->GetPooledBytes() != 0)
+  {
+    vtkSlicerIGSIOBufferPool::GetInstance()->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  int dimensions[3] = { 0, 0, 0 };
+  outputImageData->GetDimensions(dimensions);
+  if (dimensions[0] != 10 || dimensions[1] != 8 || dimensions[2] != numFrames
+    || outputImageData->GetNumberOfScalarComponents() != 3)
+  {
+    outputImageData->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFrames; ++i)
+  {
+    if (outputImageData->GetScalarComponentAsDouble(9, 7, i, 2) != i)
+    {
+      std::cerr << "Incorrect decoded slice " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Only every third frame of the range is stored
+  if (!vtkSlicerIGSIOCommon::DecodeVideoSequence(sequenceNode, outputImageData, 1, 8, 3))
+  {
+    return EXIT_FAILURE;
+  }
+  outputImageData->GetDimensions(dimensions);
+  if (dimensions[2] != 3)
+  {
+    outputImageData->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    if (outputImageData->GetScalarComponentAsDouble(0, 0, i, 0) != 1 + 3 * i)
+    {
+      std::cerr << "Incorrect decoded slice " << i << " with stride" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Groups of an inter-frame stream are decoded in batches, and the skipped frames are decoded as references
+  vtkTestingInterFrameCodec::Register();
+  vtkNew<vtkMRMLSequenceNode> interFrameSequenceNode;
+  scene->AddNode(interFrameSequenceNode);
+  std::map<std::string, std::string> codecParameters;
+  codecParameters["KeyFrameDistance"] = "3";
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, interFrameSequenceNode, 0, -1, "TIFC", codecParameters, true))
+  {
+    return EXIT_FAILURE;
+  }
+  if (!vtkSlicerIGSIOCommon::DecodeVideoSequence(interFrameSequenceNode, outputImageData, 1, -1, 2, 2))
+  {
+    return EXIT_FAILURE;
+  }
+  outputImageData->GetDimensions(dimensions);
+  if (dimensions[2] != 5)
+  {
+    outputImageData->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < 5; ++i)
+  {
+    if (outputImageData->GetScalarComponentAsDouble(0, 0, i, 0) != 1 + 2 * i)
+    {
+      std::cerr << "Incorrect decoded slice " << i << " of the inter-frame stream" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Monochrome streams are decoded into single component images
+  vtkNew<vtkMRMLSequenceNode> graySequenceNode;
+  scene->AddNode(graySequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 8, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    imageData->GetPointData()->GetScalars()->Fill(10 * i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    graySequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(graySequenceNode, 0, -1, "RV24")
+    || !vtkSlicerIGSIOCommon::IsMonochromeSequence(graySequenceNode)
+    || !vtkSlicerIGSIOCommon::IsLumaOnlyDecoding(graySequenceNode))
+  {
+    std::cerr << "Encoded gray sequence is not monochrome" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!vtkSlicerIGSIOCommon::DecodeVideoSequence(graySequenceNode, outputImageData)
+    || outputImageData->GetNumberOfScalarComponents() != 1
+    || outputImageData->GetScalarComponentAsDouble(3, 3, numFrames - 1, 0) != 10 * (numFrames - 1))
+  {
+    outputImageData->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The decode mode attribute overrides the monochrome flag
+  graySequenceNode->SetAttribute(vtkSlicerIGSIOCommon::GetDecodeModeAttributeName(), "RGB");
+  if (!vtkSlicerIGSIOCommon::DecodeVideoSequence(graySequenceNode, outputImageData)
+    || outputImageData->GetNumberOfScalarComponents() != 3)
+  {
+    outputImageData->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Frames with different dimensions cannot be stored in the same image
+  vtkSmartPointer<vtkImageData> smallImageData = vtkSmartPointer<vtkImageData>::New();
+  smallImageData->SetDimensions(4, 4, 1);
+  smallImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  vtkSmartPointer<vtkMRMLStreamingVolumeNode> smallVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+  smallVolumeNode->SetAndObserveImageData(smallImageData);
+  sequenceNode->SetDataNodeAtValue(smallVolumeNode, sequenceNode->GetNthIndexValue(numFrames - 1));
+  if (vtkSlicerIGSIOCommon::DecodeVideoSequence(sequenceNode, outputImageData))
+  {
+    std::cerr << "Frames with different dimensions should not be decoded" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
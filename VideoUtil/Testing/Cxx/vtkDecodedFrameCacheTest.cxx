@@ -0,0 +1,134 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIODecodedFrameCache.h>
+
+//---------------------------------------------------------------------------
+int vtkDecodedFrameCacheTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  int numFrames = 10;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Each image is 300 bytes, so only 4 images fit in the cache
+  vtkNew<vtkSlicerIGSIODecodedFrameCache> cache;
+  cache->SetMaximumCacheBytes(1200);
+
+  // The first request of each frame is decoded
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = cache->GetDecodedImage(sequenceNode, i);
+    if (!imageData || imageData->GetScalarComponentAsDouble(0, 0, 0, 0) != i)
+    {
+      std::cerr << "Incorrect decoded image for item " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (cache->GetNumberOfMisses() != numFrames || cache->GetNumberOfCachedImages() != 4 || cache->GetCachedBytes() > 1200)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Scrubbing back over the last frames is served from the cache
+  for (int i = numFrames - 1; i >= numFrames - 4; --i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = cache->GetDecodedImage(sequenceNode, i);
+    if (!imageData || imageData->GetScalarComponentAsDouble(0, 0, 0, 0) != i)
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  if (cache->GetNumberOfHits() != 4 || cache->GetNumberOfMisses() != numFrames)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The least recently used image was evicted
+  cache->GetDecodedImage(sequenceNode, 0);
+  if (cache->GetNumberOfMisses() != numFrames + 1 || cache->GetNumberOfCachedImages() != 4)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Replacing the frame of an item invalidates the cached image
+  vtkSmartPointer<vtkMRMLStreamingVolumeNode> replacementNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+  replacementNode->SetAndObserveFrame(vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(1))->GetFrame());
+  sequenceNode->SetDataNodeAtValue(replacementNode, sequenceNode->GetNthIndexValue(numFrames - 1));
+  vtkSmartPointer<vtkImageData> replacedImageData = cache->GetDecodedImage(sequenceNode, numFrames - 1);
+  if (!replacedImageData || replacedImageData->GetScalarComponentAsDouble(0, 0, 0, 0) != 1
+    || cache->GetNumberOfMisses() != numFrames + 2)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  cache->RemoveSequence(sequenceNode);
+  if (cache->GetNumberOfCachedImages() != 0 || cache->GetCachedBytes() != 0)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingPlan.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+//---------------------------------------------------------------------------
+static unsigned char GetTestingPixelValue(int frame, int x, int y, int c)
+{
+  return static_cast<unsigned char>((frame * 5 + x + 2 * y + 3 * c) % 256);
+}
+
+//---------------------------------------------------------------------------
+int vtkEncodeDimensionChangeTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkTestingInterFrameCodec::Register();
+
+  // The frame size changes in the middle of the sequence
+  int numFrames = 20;
+  int dimensionChangeFrame = 12;
+  int firstDimensions[3] = { 10, 8, 1 };
+  int secondDimensions[3] = { 6, 14, 1 };
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    int* dimensions = i < dimensionChangeFrame ? firstDimensions : secondDimensions;
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(dimensions);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    unsigned char* pointer = static_cast<unsigned char*>(imageData->GetScalarPointer());
+    for (int y = 0; y < dimensions[1]; ++y)
+    {
+      for (int x = 0; x < dimensions[0]; ++x)
+      {
+        for (int c = 0; c < 3; ++c)
+        {
+          *pointer++ = GetTestingPixelValue(i, x, y, c);
+        }
+      }
+    }
+
+    vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+
+  // The frames with the new size are planned as a separate block that starts a new segment
+  vtkNew<vtkSlicerIGSIOEncodingPlan> plan;
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(sequenceNode, sequenceNode, 0, -1, "TIFC", false, false, plan)
+    || plan->GetNumberOfFrameBlocks() != 2
+    || plan->GetFrameBlockStartsNewSegment(0) || !plan->GetFrameBlockStartsNewSegment(1)
+    || plan->GetFrameBlockStartIndex(1) != dimensionChangeFrame || plan->GetFrameBlockEndIndex(1) != numFrames - 1
+    || !plan->GetFrameBlockReEncodingRequired(0) || !plan->GetFrameBlockReEncodingRequired(1))
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The codec only creates a keyframe at the start of a stream, so the keyframe of the second segment
+  // shows that it was encoded by a new codec instance
+  vtkNew<vtkMRMLSequenceNode> outputSequenceNode;
+  scene->AddNode(outputSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, outputSequenceNode, 0, -1, "TIFC", std::map<std::string, std::string>()))
+  {
+    return EXIT_FAILURE;
+  }
+  if (outputSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkTestingInterFrameCodec> decoder;
+  vtkStreamingVolumeFrame* previousFrame = nullptr;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(outputSequenceNode->GetNthDataNode(i));
+    vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+    bool segmentStart = i == 0 || i == dimensionChangeFrame;
+    if (!frame || frame->IsKeyFrame() != segmentStart || (!segmentStart && frame->GetPreviousFrame() != previousFrame))
+    {
+      std::cerr << "Unexpected keyframe structure at frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    previousFrame = frame;
+
+    // Each segment is decoded with the size of its frames
+    int* expectedDimensions = i < dimensionChangeFrame ? firstDimensions : secondDimensions;
+    vtkNew<vtkImageData> imageData;
+    if (!decoder->DecodeFrame(frame, imageData))
+    {
+      std::cerr << "Could not decode frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    int dimensions[3] = { 0, 0, 0 };
+    imageData->GetDimensions(dimensions);
+    if (dimensions[0] != expectedDimensions[0] || dimensions[1] != expectedDimensions[1] || dimensions[2] != 1)
+    {
+      std::cerr << "Incorrect dimensions of frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    unsigned char* pointer = static_cast<unsigned char*>(imageData->GetScalarPointer());
+    for (int y = 0; y < dimensions[1]; ++y)
+    {
+      for (int x = 0; x < dimensions[0]; ++x)
+      {
+        for (int c = 0; c < 3; ++c)
+        {
+          if (*pointer++ != GetTestingPixelValue(i, x, y, c))
+          {
+            std::cerr << "Incorrect pixel value in frame " << i << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+
+  // The encoded sequence already consists of two valid segments, so nothing needs to be re-encoded
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(outputSequenceNode, outputSequenceNode, 0, -1, "TIFC", false, false, plan)
+    || plan->GetNumberOfFramesToEncode() != 0 || plan->GetNumberOfFrameBlocks() != 2 || !plan->GetFrameBlockStartsNewSegment(1))
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
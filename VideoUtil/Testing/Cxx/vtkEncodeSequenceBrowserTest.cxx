@@ -0,0 +1,181 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingJob.h>
+#include <vtkSlicerIGSIOEncodingStatistics.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  // Create a sequence of uncompressed video frames. The pixels of each frame are filled with the frame offset + frame index.
+  void AddVideoSequence(vtkMRMLScene* scene, vtkMRMLSequenceNode* sequenceNode, int numFrames, int frameOffset)
+  {
+    scene->AddNode(sequenceNode);
+    for (int i = 0; i < numFrames; ++i)
+    {
+      vtkNew<vtkImageData> imageData;
+      imageData->SetDimensions(8, 6, 1);
+      imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+      imageData->GetPointData()->GetScalars()->Fill(frameOffset + i);
+
+      vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+      streamingVolumeNode->SetAndObserveImageData(imageData);
+      std::stringstream indexValue;
+      indexValue << i;
+      sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // Check that all frames of the sequence are encoded as a single stream, and that they decode to the original pixels
+  bool CheckEncodedSequence(vtkMRMLSequenceNode* sequenceNode, int numFrames, int frameOffset)
+  {
+    if (sequenceNode->GetNumberOfDataNodes() != numFrames)
+    {
+      std::cerr << "Expected " << numFrames << " frames in " << sequenceNode->GetName()
+        << ", got " << sequenceNode->GetNumberOfDataNodes() << std::endl;
+      return false;
+    }
+
+    vtkNew<vtkTestingInterFrameCodec> decoder;
+    for (int i = 0; i < numFrames; ++i)
+    {
+      vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+      vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+      if (!frame || frame->GetCodecFourCC() != "TIFC" || frame->IsKeyFrame() != (i == 0))
+      {
+        std::cerr << "Frame " << i << " of " << sequenceNode->GetName() << " was not encoded" << std::endl;
+        return false;
+      }
+      vtkNew<vtkImageData> imageData;
+      if (!decoder->DecodeFrame(frame, imageData) || imageData->GetScalarComponentAsDouble(3, 2, 0, 1) != frameOffset + i)
+      {
+        std::cerr << "Incorrect pixel value in frame " << i << " of " << sequenceNode->GetName() << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkEncodeSequenceBrowserTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkTestingInterFrameCodec::Register();
+
+  int numFirstFrames = 30;
+  int numSecondFrames = 12;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> firstSequenceNode;
+  firstSequenceNode->SetName("First");
+  AddVideoSequence(scene, firstSequenceNode, numFirstFrames, 0);
+  vtkNew<vtkMRMLSequenceNode> secondSequenceNode;
+  secondSequenceNode->SetName("Second");
+  AddVideoSequence(scene, secondSequenceNode, numSecondFrames, 100);
+
+  // Sequences that are not video streams must be left unchanged
+  vtkNew<vtkMRMLSequenceNode> transformSequenceNode;
+  scene->AddNode(transformSequenceNode);
+  std::vector<vtkMRMLNode*> transformNodes;
+  for (int i = 0; i < numFirstFrames; ++i)
+  {
+    vtkNew<vtkMRMLLinearTransformNode> transformNode;
+    std::stringstream indexValue;
+    indexValue << i;
+    transformSequenceNode->SetDataNodeAtValue(transformNode, indexValue.str());
+    transformNodes.push_back(transformSequenceNode->GetNthDataNode(i));
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  browserNode->SetAndObserveMasterSequenceNodeID(firstSequenceNode->GetID());
+  browserNode->AddSynchronizedSequenceNode(secondSequenceNode);
+  browserNode->AddSynchronizedSequenceNode(transformSequenceNode);
+
+  // The sequences are encoded together by the threads of the job
+  vtkNew<vtkSlicerIGSIOEncodingJob> encodingJob;
+  encodingJob->SetNumberOfThreads(4);
+  vtkNew<vtkSlicerIGSIOEncodingStatistics> statistics;
+  if (!vtkSlicerIGSIOCommon::EncodeSequenceBrowser(browserNode, "TIFC", false, false, encodingJob, nullptr, statistics))
+  {
+    std::cerr << "Could not encode the sequence browser" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckEncodedSequence(firstSequenceNode, numFirstFrames, 0)
+    || !CheckEncodedSequence(secondSequenceNode, numSecondFrames, 100))
+  {
+    return EXIT_FAILURE;
+  }
+  if (statistics->GetNumberOfFrames() != numFirstFrames + numSecondFrames
+    || statistics->GetNumberOfReEncodedFrames() != numFirstFrames + numSecondFrames
+    || statistics->GetNumberOfKeyFrames() != 2)
+  {
+    statistics->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  if (transformSequenceNode->GetNumberOfDataNodes() != numFirstFrames)
+  {
+    std::cerr << "The number of transforms was changed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFirstFrames; ++i)
+  {
+    if (transformSequenceNode->GetNthDataNode(i) != transformNodes[i])
+    {
+      std::cerr << "Transform " << i << " was changed" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The sequences are already encoded with the codec, so encoding them again does not change any frames
+  if (!vtkSlicerIGSIOCommon::EncodeSequenceBrowser(browserNode, "TIFC", false, false, encodingJob, nullptr, statistics)
+    || statistics->GetNumberOfReEncodedFrames() != 0
+    || !CheckEncodedSequence(firstSequenceNode, numFirstFrames, 0)
+    || !CheckEncodedSequence(secondSequenceNode, numSecondFrames, 100))
+  {
+    statistics->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingJob.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+namespace
+{
+  const int NUMBER_OF_FRAMES = 40;
+  const int KEYFRAME_DISTANCE = 10;
+
+  //---------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> CreateTestingImage(int value)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(8, 6, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(value);
+    return imageData;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string GetIndexValue(int i)
+  {
+    std::stringstream indexValue;
+    indexValue << i;
+    return indexValue.str();
+  }
+
+  //---------------------------------------------------------------------------
+  // Encoded blocks of KEYFRAME_DISTANCE frames, which are encoded in parallel as separate chunks
+  void AddInterFrameStream(vtkMRMLSequenceNode* sequenceNode)
+  {
+    vtkNew<vtkTestingInterFrameCodec> codec;
+    for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+    {
+      vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+      codec->EncodeImageData(CreateTestingImage(i), frame, i % KEYFRAME_DISTANCE == 0);
+      vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+      streamingVolumeNode->SetAndObserveFrame(frame);
+      sequenceNode->SetDataNodeAtValue(streamingVolumeNode, GetIndexValue(i));
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // Uncompressed frames that are replaced by the encoding
+  void AddOriginalFrames(vtkMRMLSequenceNode* sequenceNode, std::vector<vtkMRMLNode*>& originalDataNodes)
+  {
+    for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+    {
+      vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+      streamingVolumeNode->SetAndObserveImageData(CreateTestingImage(255 - i));
+      sequenceNode->SetDataNodeAtValue(streamingVolumeNode, GetIndexValue(i));
+    }
+    originalDataNodes.clear();
+    for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+    {
+      originalDataNodes.push_back(sequenceNode->GetNthDataNode(i));
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  bool IsEncodedFrame(vtkMRMLNode* dataNode, std::string codecFourCC)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(dataNode);
+    return streamingVolumeNode && streamingVolumeNode->GetFrame() && streamingVolumeNode->GetFrame()->GetCodecFourCC() == codecFourCC;
+  }
+
+  //---------------------------------------------------------------------------
+  // Cancel the job as soon as the output sequence is modified, which is while the frames of the first chunk are added
+  void CancelJobCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eventId), void* clientData, void* vtkNotUsed(callData))
+  {
+    static_cast<vtkSlicerIGSIOEncodingJob*>(clientData)->Cancel();
+  }
+
+  //---------------------------------------------------------------------------
+  bool HasCheckpoint(vtkMRMLSequenceNode* sequenceNode)
+  {
+    return sequenceNode->GetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName()) != nullptr;
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkEncodingJobTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkTestingInterFrameCodec::Register();
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> inputSequenceNode;
+  scene->AddNode(inputSequenceNode);
+  AddInterFrameStream(inputSequenceNode);
+
+  vtkNew<vtkMRMLSequenceNode> outputSequenceNode;
+  scene->AddNode(outputSequenceNode);
+  std::vector<vtkMRMLNode*> originalDataNodes;
+  AddOriginalFrames(outputSequenceNode, originalDataNodes);
+
+  vtkNew<vtkSlicerIGSIOEncodingJob> encodingJob;
+  if (!encodingJob->GetCodecRequiresRGBInput("RV24") || encodingJob->GetCodecRequiresRGBInput("VP90"))
+  {
+    std::cerr << "By default only RV24 should require RGB input" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkSlicerIGSIOEncodingJob> otherEncodingJob;
+  otherEncodingJob->SetCodecRequiresRGBInput("RV24", false);
+  if (!encodingJob->GetCodecRequiresRGBInput("RV24"))
+  {
+    std::cerr << "Codec settings should not be shared between encoding jobs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  encodingJob->SetNumberOfThreads(NUMBER_OF_FRAMES / KEYFRAME_DISTANCE);
+  vtkNew<vtkCallbackCommand> cancelCallback;
+  cancelCallback->SetCallback(CancelJobCallback);
+  cancelCallback->SetClientData(encodingJob.GetPointer());
+  unsigned long cancelObserver = outputSequenceNode->AddObserver(vtkCommand::ModifiedEvent, cancelCallback);
+
+  // Cancel with rollback: the output is exactly as it was before
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob))
+  {
+    std::cerr << "Cancelled encoding should fail" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (outputSequenceNode->GetNumberOfDataNodes() != NUMBER_OF_FRAMES || HasCheckpoint(outputSequenceNode)
+    || !encodingJob->GetCheckpointIndexValue().empty())
+  {
+    std::cerr << "Cancelled encoding was not rolled back" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+  {
+    if (outputSequenceNode->GetNthDataNode(i) != originalDataNodes[i])
+    {
+      std::cerr << "Frame " << i << " was not restored by the rollback" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Cancel without rollback: the output contains the first chunk, and the checkpoint is its last frame
+  encodingJob->Reset();
+  encodingJob->RollbackOnCancelOff();
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob))
+  {
+    std::cerr << "Cancelled encoding should fail" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string checkpointIndexValue = GetIndexValue(KEYFRAME_DISTANCE - 1);
+  const char* checkpointAttribute = outputSequenceNode->GetAttribute(vtkSlicerIGSIOEncodingJob::GetCheckpointAttributeName());
+  if (!checkpointAttribute || checkpointIndexValue != checkpointAttribute || encodingJob->GetCheckpointIndexValue() != checkpointIndexValue)
+  {
+    std::cerr << "Incorrect checkpoint after cancelling the encoding" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<vtkMRMLNode*> prefixDataNodes;
+  for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+  {
+    vtkMRMLNode* dataNode = outputSequenceNode->GetNthDataNode(i);
+    bool encoded = i < KEYFRAME_DISTANCE;
+    if (encoded != IsEncodedFrame(dataNode, "RV24") || encoded == (dataNode == originalDataNodes[i]))
+    {
+      std::cerr << "Frame " << i << " is not part of a consistent prefix" << std::endl;
+      return EXIT_FAILURE;
+    }
+    prefixDataNodes.push_back(dataNode);
+  }
+
+  // Resume from the checkpoint: only the frames after the checkpoint are encoded
+  outputSequenceNode->RemoveObserver(cancelObserver);
+  encodingJob->Reset();
+  encodingJob->ResumeFromCheckpointOn();
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob))
+  {
+    std::cerr << "Resumed encoding failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (outputSequenceNode->GetNumberOfDataNodes() != NUMBER_OF_FRAMES || HasCheckpoint(outputSequenceNode))
+  {
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < NUMBER_OF_FRAMES; ++i)
+  {
+    vtkMRMLNode* dataNode = outputSequenceNode->GetNthDataNode(i);
+    if (!IsEncodedFrame(dataNode, "RV24") || (i < KEYFRAME_DISTANCE) != (dataNode == prefixDataNodes[i]))
+    {
+      std::cerr << "Frame " << i << " was not resumed correctly" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A frame that cannot be decoded makes the encoding fail. No checkpoint is left behind, with or without a job.
+  int corruptFrame = 2 * KEYFRAME_DISTANCE + KEYFRAME_DISTANCE / 2;
+  vtkNew<vtkStreamingVolumeFrame> corruptedFrame;
+  vtkNew<vtkUnsignedCharArray> corruptedFrameData;
+  corruptedFrameData->SetNumberOfValues(3);
+  int dimensions[3] = { 8, 6, 1 };
+  corruptedFrame->SetFrameType(vtkStreamingVolumeFrame::IFrame);
+  corruptedFrame->SetFrameData(corruptedFrameData);
+  corruptedFrame->SetDimensions(dimensions);
+  corruptedFrame->SetVTKScalarType(VTK_UNSIGNED_CHAR);
+  corruptedFrame->SetNumberOfComponents(3);
+  corruptedFrame->SetCodecFourCC("TIFC");
+  vtkNew<vtkMRMLStreamingVolumeNode> corruptedStreamingVolumeNode;
+  corruptedStreamingVolumeNode->SetAndObserveFrame(corruptedFrame);
+  inputSequenceNode->SetDataNodeAtValue(corruptedStreamingVolumeNode, GetIndexValue(corruptFrame));
+
+  vtkNew<vtkMRMLSequenceNode> failedOutputSequenceNode;
+  scene->AddNode(failedOutputSequenceNode);
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, failedOutputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false) || HasCheckpoint(failedOutputSequenceNode))
+  {
+    std::cerr << "Failed encoding without a job should not store a checkpoint" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  encodingJob->Reset();
+  encodingJob->ResumeFromCheckpointOff();
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, failedOutputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob)
+    || HasCheckpoint(failedOutputSequenceNode) || !encodingJob->GetCheckpointIndexValue().empty())
+  {
+    std::cerr << "Failed encoding should clear the checkpoint" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
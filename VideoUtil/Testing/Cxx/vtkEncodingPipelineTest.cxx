@@ -0,0 +1,264 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <algorithm>
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkUnsignedCharArray.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingJob.h>
+#include <vtkSlicerIGSIOEncodingStatistics.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+//---------------------------------------------------------------------------
+static unsigned char GetTestingPixelValue(int frame, int x, int y)
+{
+  return static_cast<unsigned char>((frame * 7 + x + 3 * y) % 256);
+}
+
+//---------------------------------------------------------------------------
+// Check that the encoded RGB frame contains the single component testing image of the frame in each channel
+static bool CheckEncodedFrame(vtkMRMLSequenceNode* sequenceNode, int frame, int width, int height)
+{
+  vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(frame));
+  if (!streamingVolumeNode || !streamingVolumeNode->GetFrame())
+  {
+    return false;
+  }
+  vtkNew<vtkMRMLStreamingVolumeNode> decodingNode;
+  decodingNode->SetAndObserveFrame(streamingVolumeNode->GetFrame());
+  vtkImageData* imageData = decodingNode->GetImageData();
+  if (!imageData || imageData->GetNumberOfScalarComponents() != 3)
+  {
+    return false;
+  }
+  unsigned char* pointer = static_cast<unsigned char*>(imageData->GetScalarPointer());
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        if (*pointer != GetTestingPixelValue(frame, x, y))
+        {
+          return false;
+        }
+        ++pointer;
+      }
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkEncodingPipelineTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkTestingInterFrameCodec::Register();
+
+  int width = 16;
+  int height = 12;
+  int numFrames = 60;
+
+  // Single component inter-frame stream, so that every frame has to be decoded, converted to RGB and encoded
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  vtkNew<vtkTestingInterFrameCodec> inputCodec;
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > inputFrames;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(width, height, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* pointer = static_cast<unsigned char*>(imageData->GetScalarPointer());
+    for (int y = 0; y < height; ++y)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        *pointer++ = GetTestingPixelValue(i, x, y);
+      }
+    }
+
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    if (!inputCodec->EncodeImageData(imageData, frame))
+    {
+      return EXIT_FAILURE;
+    }
+    inputFrames.push_back(frame);
+
+    vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+    streamingVolumeNode->SetAndObserveFrame(frame);
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+
+  // The three stages of the block are run as tasks of the three encoding threads, with a single frame between the stages
+  vtkNew<vtkSlicerIGSIOEncodingJob> encodingJob;
+  encodingJob->SetNumberOfThreads(3);
+  encodingJob->SetPipelineQueueDepth(1);
+  vtkNew<vtkSlicerIGSIOEncodingStatistics> statistics;
+  vtkNew<vtkMRMLSequenceNode> outputSequenceNode;
+  scene->AddNode(outputSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, outputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob, nullptr, statistics))
+  {
+    return EXIT_FAILURE;
+  }
+  if (outputSequenceNode->GetNumberOfDataNodes() != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageDecode) != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageConvert) != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageEncode) != numFrames)
+  {
+    statistics->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFrames; ++i)
+  {
+    if (!CheckEncodedFrame(outputSequenceNode, i, width, height)
+      || outputSequenceNode->GetNthIndexValue(i) != sequenceNode->GetNthIndexValue(i))
+    {
+      std::cerr << "Incorrect pipelined encoding of frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Only codecs that require RGB input get the converted images, other codecs encode the single component images
+  vtkNew<vtkMRMLSequenceNode> grayOutputSequenceNode;
+  scene->AddNode(grayOutputSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, grayOutputSequenceNode, 0, -1, "TIFC",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob, nullptr, statistics))
+  {
+    return EXIT_FAILURE;
+  }
+  vtkMRMLStreamingVolumeNode* grayStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(grayOutputSequenceNode->GetNthDataNode(0));
+  if (statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageConvert) != 0
+    || !grayStreamingVolumeNode || !grayStreamingVolumeNode->GetFrame()
+    || grayStreamingVolumeNode->GetFrame()->GetNumberOfComponents() != 1)
+  {
+    std::cerr << "Single component images should not be converted for TIFC" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // 16-bit frames are mapped to 8 bits with one window for the whole sequence, so the same value has the same gray level in each frame.
+  // The range of the sequence is 1000-3000, while the first frame only contains 1000-2000.
+  vtkNew<vtkMRMLSequenceNode> shortSequenceNode;
+  scene->AddNode(shortSequenceNode);
+  for (int i = 0; i < 2; ++i)
+  {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(width, height, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+    unsigned short* pointer = static_cast<unsigned short*>(imageData->GetScalarPointer());
+    std::fill(pointer, pointer + width * height, static_cast<unsigned short>(i == 0 ? 1000 : 3000));
+    pointer[0] = i == 0 ? 2000 : 1000;
+
+    vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+    std::stringstream indexValue;
+    indexValue << i;
+    shortSequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(shortSequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+  const double expectedGrayLevels[2][2] = { { 128.0, 0.0 }, { 0.0, 255.0 } };
+  for (int i = 0; i < 2; ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(shortSequenceNode->GetNthDataNode(i));
+    vtkNew<vtkMRMLStreamingVolumeNode> decodingNode;
+    decodingNode->SetAndObserveFrame(streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr);
+    vtkImageData* imageData = decodingNode->GetImageData();
+    if (!imageData || imageData->GetNumberOfScalarComponents() != 3
+      || imageData->GetScalarComponentAsDouble(0, 0, 0, 0) != expectedGrayLevels[i][0]
+      || imageData->GetScalarComponentAsDouble(1, 0, 0, 0) != expectedGrayLevels[i][1])
+    {
+      std::cerr << "Incorrect window/level mapping of 16-bit frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A frame that cannot be decoded stops the decode stage. The later stages must stop as well, and the
+  // frames of the block are not added to the output.
+  int corruptFrame = numFrames / 2;
+  vtkNew<vtkStreamingVolumeFrame> corruptedFrame;
+  vtkNew<vtkUnsignedCharArray> corruptedFrameData;
+  corruptedFrameData->SetNumberOfValues(3);
+  int dimensions[3] = { width, height, 1 };
+  corruptedFrame->SetFrameType(vtkStreamingVolumeFrame::IFrame);
+  corruptedFrame->SetFrameData(corruptedFrameData);
+  corruptedFrame->SetDimensions(dimensions);
+  corruptedFrame->SetVTKScalarType(VTK_UNSIGNED_CHAR);
+  corruptedFrame->SetNumberOfComponents(1);
+  corruptedFrame->SetCodecFourCC("TIFC");
+  vtkNew<vtkMRMLStreamingVolumeNode> corruptedStreamingVolumeNode;
+  corruptedStreamingVolumeNode->SetAndObserveFrame(corruptedFrame);
+  sequenceNode->SetDataNodeAtValue(corruptedStreamingVolumeNode, sequenceNode->GetNthIndexValue(corruptFrame));
+
+  vtkNew<vtkMRMLSequenceNode> failedOutputSequenceNode;
+  scene->AddNode(failedOutputSequenceNode);
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, failedOutputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob, nullptr, statistics))
+  {
+    std::cerr << "Encoding of a corrupted frame should fail" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (failedOutputSequenceNode->GetNumberOfDataNodes() != 0
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageEncode) > corruptFrame)
+  {
+    statistics->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Cancelling the job aborts all of the stages
+  vtkNew<vtkMRMLStreamingVolumeNode> restoredStreamingVolumeNode;
+  restoredStreamingVolumeNode->SetAndObserveFrame(inputFrames[corruptFrame]);
+  sequenceNode->SetDataNodeAtValue(restoredStreamingVolumeNode, sequenceNode->GetNthIndexValue(corruptFrame));
+  encodingJob->Cancel();
+  vtkNew<vtkMRMLSequenceNode> cancelledOutputSequenceNode;
+  scene->AddNode(cancelledOutputSequenceNode);
+  if (vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, cancelledOutputSequenceNode, 0, -1, "RV24",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob))
+  {
+    std::cerr << "Cancelled encoding should fail" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cancelledOutputSequenceNode->GetNumberOfDataNodes() != 0)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+#include <set>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkNew.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingJob.h>
+#include <vtkSlicerIGSIOEncodingPlan.h>
+#include <vtkSlicerIGSIOKeyFramePolicy.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+// SequenceIO includes
+#include <vtkSlicerSequenceIOLogic.h>
+
+//---------------------------------------------------------------------------
+int vtkEncodingPlanTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int width = 10;
+  int height = 10;
+  int numFrames = 25;
+
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(width, height, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+
+  std::string codecFourCC = "RV24";
+
+  // Frames without an encoded frame must be encoded
+  vtkNew<vtkSlicerIGSIOEncodingPlan> plan;
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(sequenceNode, sequenceNode, 0, -1, codecFourCC, false, false, plan))
+  {
+    return EXIT_FAILURE;
+  }
+  if (!plan->IsReEncodingRequired()
+    || plan->GetNumberOfFramesToEncode() != numFrames
+    || plan->GetEstimatedNumberOfEncodes() != numFrames
+    || plan->GetEstimatedNumberOfDecodes() != 0
+    || !(plan->GetFrameBlockReEncodingReasons(0) & vtkSlicerIGSIOEncodingPlan::ReEncodingReasonMissingFrame))
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, codecFourCC))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Encoded sequence with the same codec does not need to be changed
+  vtkNew<vtkMRMLSequenceNode> outputSequenceNode;
+  scene->AddNode(outputSequenceNode);
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(sequenceNode, outputSequenceNode, 0, -1, codecFourCC, false, false, plan))
+  {
+    return EXIT_FAILURE;
+  }
+  if (plan->IsReEncodingRequired()
+    || plan->GetEstimatedNumberOfEncodes() != 0
+    || plan->GetNumberOfPassThroughFrames() != numFrames)
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Uncompressed frames are all keyframes, so they already satisfy the keyframe policy
+  vtkNew<vtkSlicerIGSIOKeyFramePolicy> keyFramePolicy;
+  keyFramePolicy->SetMaximumKeyFrameDistance(10);
+  keyFramePolicy->SetTargetSeekCost(1);
+  keyFramePolicy->AddForcedKeyFrameIndexValue("10");
+  if (keyFramePolicy->GetEffectiveMaximumKeyFrameDistance() != 1)
+  {
+    keyFramePolicy->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(sequenceNode, outputSequenceNode, 0, -1, codecFourCC, false, false, plan, keyFramePolicy))
+  {
+    return EXIT_FAILURE;
+  }
+  if (plan->IsReEncodingRequired())
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Forced re-encoding decodes and encodes every frame
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(sequenceNode, sequenceNode, 0, -1, codecFourCC, true, false, plan))
+  {
+    return EXIT_FAILURE;
+  }
+  if (!plan->IsReEncodingRequired()
+    || plan->GetEstimatedNumberOfEncodes() != numFrames
+    || plan->GetEstimatedNumberOfDecodes() != numFrames
+    || plan->GetNumberOfPassThroughFrames() != 0)
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < plan->GetNumberOfFrameBlocks(); ++i)
+  {
+    if (!(plan->GetFrameBlockReEncodingReasons(i) & vtkSlicerIGSIOEncodingPlan::ReEncodingReasonForced))
+    {
+      plan->Print(std::cerr);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Pass-through copy shares the encoded frames
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, outputSequenceNode, 0, -1, codecFourCC, std::map<std::string, std::string>()))
+  {
+    return EXIT_FAILURE;
+  }
+  if (outputSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+    vtkMRMLStreamingVolumeNode* outputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(outputSequenceNode->GetNthDataNode(i));
+    if (!inputStreamingVolumeNode || !outputStreamingVolumeNode || !outputStreamingVolumeNode->GetFrame()
+      || outputStreamingVolumeNode->GetFrame()->GetFrameData() != inputStreamingVolumeNode->GetFrame()->GetFrameData())
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Inter-frame stream with a single keyframe violates the keyframe policy
+  vtkTestingInterFrameCodec::Register();
+  int numInterFrames = 30;
+  vtkNew<vtkMRMLSequenceNode> interFrameSequenceNode;
+  scene->AddNode(interFrameSequenceNode);
+  vtkNew<vtkTestingInterFrameCodec> interFrameCodec;
+  for (int i = 0; i < numInterFrames; ++i)
+  {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(width, height, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+    vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    if (!interFrameCodec->EncodeImageData(imageData, frame))
+    {
+      return EXIT_FAILURE;
+    }
+
+    vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+    streamingVolumeNode->SetAndObserveFrame(frame);
+    std::stringstream indexValue;
+    indexValue << i;
+    interFrameSequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+
+  vtkNew<vtkSlicerIGSIOKeyFramePolicy> interFrameKeyFramePolicy;
+  interFrameKeyFramePolicy->SetMaximumKeyFrameDistance(8);
+  interFrameKeyFramePolicy->AddForcedKeyFrameIndexValue("13");
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(interFrameSequenceNode, interFrameSequenceNode, 0, -1, "TIFC", false, false,
+    plan, interFrameKeyFramePolicy))
+  {
+    return EXIT_FAILURE;
+  }
+  if (plan->GetNumberOfFrameBlocks() != 1 || plan->GetNumberOfFramesToEncode() != numInterFrames
+    || !(plan->GetFrameBlockReEncodingReasons(0) & vtkSlicerIGSIOEncodingPlan::ReEncodingReasonKeyFrameDistance)
+    || !(plan->GetFrameBlockReEncodingReasons(0) & vtkSlicerIGSIOEncodingPlan::ReEncodingReasonForcedKeyFrame)
+    || (plan->GetFrameBlockReEncodingReasons(0) & vtkSlicerIGSIOEncodingPlan::ReEncodingReasonCodecMismatch))
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The keyframes are forced by the codec within a single stream, so there are no other keyframes even with several threads.
+  // The maximum distance is counted from the forced keyframe.
+  vtkNew<vtkSlicerIGSIOEncodingJob> encodingJob;
+  encodingJob->SetNumberOfThreads(4);
+  vtkNew<vtkMRMLSequenceNode> policyOutputSequenceNode;
+  scene->AddNode(policyOutputSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(interFrameSequenceNode, policyOutputSequenceNode, 0, -1, "TIFC",
+    std::map<std::string, std::string>(), false, false, nullptr, encodingJob, interFrameKeyFramePolicy))
+  {
+    return EXIT_FAILURE;
+  }
+  std::set<int> expectedKeyFrames = { 0, 8, 13, 21, 29 };
+  for (int i = 0; i < numInterFrames; ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(policyOutputSequenceNode->GetNthDataNode(i));
+    vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+    if (!frame || frame->IsKeyFrame() != (expectedKeyFrames.count(i) > 0))
+    {
+      std::cerr << "Unexpected keyframe structure at frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The encoded stream satisfies the policy
+  if (!vtkSlicerIGSIOCommon::PlanVideoSequenceEncoding(policyOutputSequenceNode, policyOutputSequenceNode, 0, -1, "TIFC", false, false,
+    plan, interFrameKeyFramePolicy)
+    || plan->IsReEncodingRequired())
+  {
+    plan->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIODecodedFrameCache.h>
+#include <vtkSlicerIGSIOFramePrefetcher.h>
+
+//---------------------------------------------------------------------------
+int vtkFramePrefetcherTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  int numFrames = 20;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  browserNode->SetPlaybackRateFps(10.0);
+  browserNode->SetPlaybackLooped(false);
+
+  vtkNew<vtkSlicerIGSIODecodedFrameCache> cache;
+  vtkNew<vtkSlicerIGSIOFramePrefetcher> prefetcher;
+  prefetcher->SetDecodedFrameCache(cache);
+  prefetcher->SetPrefetchDuration(0.5);
+  int numberOfFramesToPrefetch = prefetcher->GetNumberOfFramesToPrefetch(browserNode);
+  if (numberOfFramesToPrefetch != 5)
+  {
+    std::cerr << "Expected 5 frames to prefetch, got " << numberOfFramesToPrefetch << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Nothing is prefetched while the selected item is changed without playback
+  browserNode->SetSelectedItemNumber(2);
+  prefetcher->Update(browserNode);
+  browserNode->SetSelectedItemNumber(3);
+  prefetcher->Update(browserNode);
+  prefetcher->Wait();
+  if (prefetcher->GetNumberOfPrefetchedFrames() != 0 || cache->GetNumberOfCachedImages() != 0)
+  {
+    prefetcher->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Moving forward during playback prefetches the following frames
+  browserNode->SetPlaybackActive(true);
+  browserNode->SetSelectedItemNumber(10);
+  prefetcher->Update(browserNode);
+  browserNode->SetSelectedItemNumber(11);
+  prefetcher->Update(browserNode);
+  prefetcher->Wait();
+  if (prefetcher->GetPlaybackDirection(browserNode) != 1)
+  {
+    return EXIT_FAILURE;
+  }
+  for (int i = 12; i <= 16; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = cache->GetDecodedImage(sequenceNode, i);
+    if (!imageData || imageData->GetScalarComponentAsDouble(0, 0, 0, 0) != i)
+    {
+      std::cerr << "Incorrect prefetched image for item " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (cache->GetNumberOfHits() != 5 || cache->GetNumberOfMisses() != 0)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Moving backward prefetches the preceding frames
+  cache->ResetStatistics();
+  browserNode->SetSelectedItemNumber(8);
+  prefetcher->Update(browserNode);
+  prefetcher->Wait();
+  if (prefetcher->GetPlaybackDirection(browserNode) != -1)
+  {
+    return EXIT_FAILURE;
+  }
+  for (int i = 7; i >= 3; --i)
+  {
+    if (!cache->GetDecodedImage(sequenceNode, i))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  if (cache->GetNumberOfHits() != 5 || cache->GetNumberOfMisses() != 0)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // No frames are prefetched past the end of the sequence if playback is not looped
+  browserNode->SetSelectedItemNumber(numFrames - 2);
+  prefetcher->Update(browserNode);
+  browserNode->SetSelectedItemNumber(numFrames - 1);
+  prefetcher->Update(browserNode);
+  prefetcher->Wait();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncoderState.h>
+#include <vtkSlicerIGSIOKeyFrameIndex.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+//---------------------------------------------------------------------------
+static void AddTestingFrame(vtkMRMLSequenceNode* sequenceNode, int i)
+{
+  vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+  imageData->SetDimensions(10, 10, 1);
+  imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  imageData->GetPointData()->GetScalars()->Fill(i);
+
+  vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+  streamingVolumeNode->SetAndObserveImageData(imageData);
+
+  std::stringstream indexValue;
+  indexValue << i;
+  sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+}
+
+//---------------------------------------------------------------------------
+int vtkKeyFrameIndexTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  int numFrames = 10;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    AddTestingFrame(sequenceNode, i);
+  }
+
+  // Items that are not encoded have no keyframe
+  vtkSlicerIGSIOKeyFrameIndex* keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode);
+  if (!keyFrameIndex || keyFrameIndex != vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(sequenceNode)
+    || keyFrameIndex->GetNumberOfItems() != numFrames || keyFrameIndex->GetNumberOfKeyFrames() != 0
+    || keyFrameIndex->GetChainLength(0) != 0 || keyFrameIndex->GetKeyFrameItemNumber(0) != -1
+    || keyFrameIndex->GetPreviousKeyFrameItemNumber(numFrames - 1) != -1)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The index is rebuilt after the sequence is encoded. Uncompressed frames are all keyframes.
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+  if (keyFrameIndex->GetNumberOfKeyFrames() != numFrames)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFrames; ++i)
+  {
+    if (!keyFrameIndex->IsKeyFrame(i) || keyFrameIndex->GetNthKeyFrameItemNumber(i) != i
+      || keyFrameIndex->GetKeyFrameItemNumber(i) != i || keyFrameIndex->GetChainLength(i) != 1
+      || keyFrameIndex->GetPreviousKeyFrameItemNumber(i) != i)
+    {
+      std::cerr << "Incorrect keyframe index for item " << i << std::endl;
+      keyFrameIndex->Print(std::cerr);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Appending an item that is not encoded updates the index
+  AddTestingFrame(sequenceNode, numFrames);
+  if (keyFrameIndex->GetNumberOfItems() != numFrames + 1 || keyFrameIndex->IsKeyFrame(numFrames)
+    || keyFrameIndex->GetPreviousKeyFrameItemNumber(numFrames) != numFrames - 1)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  vtkSlicerIGSIOKeyFrameIndex::RemoveSequenceIndex(sequenceNode);
+
+  // Inter-frame stream with keyframes at items 0, 5 and 10
+  vtkTestingInterFrameCodec::Register();
+  vtkNew<vtkMRMLSequenceNode> interFrameSequenceNode;
+  scene->AddNode(interFrameSequenceNode);
+  for (int i = 0; i < 12; ++i)
+  {
+    AddTestingFrame(interFrameSequenceNode, i);
+  }
+  std::map<std::string, std::string> codecParameters;
+  codecParameters["KeyFrameDistance"] = "5";
+  vtkNew<vtkSlicerIGSIOEncoderState> encoderState;
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, encoderState))
+  {
+    return EXIT_FAILURE;
+  }
+  keyFrameIndex = vtkSlicerIGSIOKeyFrameIndex::GetSequenceIndex(interFrameSequenceNode);
+  if (keyFrameIndex->GetNumberOfKeyFrames() != 3 || keyFrameIndex->GetNthKeyFrameItemNumber(1) != 5
+    || keyFrameIndex->GetChainLength(4) != 5 || keyFrameIndex->GetKeyFrameItemNumber(9) != 5
+    || keyFrameIndex->GetLastChainRunItemNumber(0) != 4 || keyFrameIndex->GetLastChainRunItemNumber(7) != 9
+    || keyFrameIndex->GetLastChainRunItemNumber(10) != 11)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Appended frames start a new stream at item 12. The index is extended with the appended items.
+  for (int i = 12; i < 15; ++i)
+  {
+    AddTestingFrame(interFrameSequenceNode, i);
+  }
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, encoderState)
+    || keyFrameIndex->GetNumberOfItems() != 15 || keyFrameIndex->GetNumberOfKeyFrames() != 4
+    || keyFrameIndex->GetLastChainRunItemNumber(10) != 11 || keyFrameIndex->GetLastChainRunItemNumber(12) != 14)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Frames that continue the stream extend the run of the last item
+  for (int i = 15; i < 17; ++i)
+  {
+    AddTestingFrame(interFrameSequenceNode, i);
+  }
+  if (!vtkSlicerIGSIOCommon::EncodeAppendedVideoFrames(interFrameSequenceNode, "TIFC", codecParameters, encoderState)
+    || keyFrameIndex->GetNumberOfItems() != 17 || keyFrameIndex->GetLastChainRunItemNumber(12) != 16
+    || keyFrameIndex->GetChainLength(16) != 5 || keyFrameIndex->GetKeyFrameItemNumber(16) != 12)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Replacing an item in the middle of a run splits the run, and the next item is no longer decoded from the keyframe
+  AddTestingFrame(interFrameSequenceNode, 7);
+  if (keyFrameIndex->GetNumberOfItems() != 17 || keyFrameIndex->GetLastChainRunItemNumber(5) != 6
+    || keyFrameIndex->GetKeyFrameItemNumber(7) != -1 || keyFrameIndex->GetKeyFrameItemNumber(8) != -1
+    || keyFrameIndex->GetLastChainRunItemNumber(8) != 9)
+  {
+    keyFrameIndex->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  vtkSlicerIGSIOKeyFrameIndex::RemoveSequenceIndex(interFrameSequenceNode);
+  return EXIT_SUCCESS;
+}
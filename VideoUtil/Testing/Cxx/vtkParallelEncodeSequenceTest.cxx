@@ -0,0 +1,234 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOEncodingJob.h>
+#include <vtkSlicerIGSIOEncodingStatistics.h>
+
+#include "vtkTestingInterFrameCodec.h"
+
+// SequenceIO includes
+#include <vtkSlicerSequenceIOLogic.h>
+
+//---------------------------------------------------------------------------
+static void SetTestingImageDataForValue(vtkImageData* image, unsigned char value)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+
+  unsigned char* imageDataScalars = (unsigned char*)image->GetScalarPointer();
+  for (int y = 0; y < dimensions[1]; ++y)
+  {
+    for (int x = 0; x < dimensions[0]; ++x)
+    {
+      unsigned char red = 255 * (x / (double)dimensions[0]);
+      unsigned char green = 255 * (y / (double)dimensions[1]);
+      imageDataScalars[0] = red;
+      imageDataScalars[1] = green;
+      imageDataScalars[2] = value;
+      imageDataScalars += 3;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkParallelEncodeSequenceTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int width = 10;
+  int height = 10;
+  int numFrames = 200;
+
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance(); 
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+
+  std::vector<vtkSmartPointer<vtkImageData>> images;
+
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(width, height, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    unsigned char value = 255 * (i / (double)numFrames);
+    SetTestingImageDataForValue(imageData, value);
+    images.push_back(imageData);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+    if (streamingVolumeNode->GetFrame())
+    {
+      return EXIT_FAILURE;
+    }
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+
+  vtkNew<vtkSlicerIGSIOEncodingJob> encodingJob;
+  encodingJob->SetNumberOfThreads(4);
+
+  vtkNew<vtkMRMLSequenceNode> outputSequenceNode;
+  scene->AddNode(outputSequenceNode);
+
+  std::string codecFourCC = "RV24";
+  vtkNew<vtkSlicerIGSIOEncodingStatistics> statistics;
+  // The overload without codec parameters is the one that is available from Python
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode.GetPointer(), outputSequenceNode.GetPointer(), 0, -1,
+    codecFourCC, true, false, encodingJob, nullptr, statistics))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Every frame is encoded and inserted once, in order. The input images are not encoded, so there is nothing to decode.
+  if (statistics->GetNumberOfFrames() != numFrames
+    || statistics->GetNumberOfReEncodedFrames() != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageEncode) != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageNodeInsertion) != numFrames
+    || statistics->GetStageNumberOfSamples(vtkSlicerIGSIOEncodingStatistics::StageDecode) != 0
+    || statistics->GetTotalBytesIn() != static_cast<long long>(numFrames) * width * height * 3
+    || statistics->GetFrameIndexValue(numFrames - 1) != sequenceNode->GetNthIndexValue(numFrames - 1)
+    || statistics->GetStagePercentileTime(vtkSlicerIGSIOEncodingStatistics::StageEncode, 50.0)
+      > statistics->GetStageMaximumTime(vtkSlicerIGSIOEncodingStatistics::StageEncode)
+    || statistics->GetWallTime() <= 0.0)
+  {
+    statistics->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  if (outputSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    std::cerr << "Expected " << numFrames << " frames in the output sequence, got " << outputSequenceNode->GetNumberOfDataNodes() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (int i = 0; i < outputSequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(outputSequenceNode->GetNthDataNode(i));
+    if (!streamingVolumeNode || !streamingVolumeNode->GetFrame())
+    {
+      return EXIT_FAILURE;
+    }
+    if (outputSequenceNode->GetNthIndexValue(i) != sequenceNode->GetNthIndexValue(i))
+    {
+      std::cerr << "Frame order mismatch at index " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (int i = 0; i < outputSequenceNode->GetNumberOfDataNodes(); ++i)
+  {
+    vtkMRMLStreamingVolumeNode* inputStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(outputSequenceNode->GetNthDataNode(i));
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> outputStreamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    outputStreamingVolumeNode->SetAndObserveFrame(inputStreamingVolumeNode->GetFrame());
+
+    vtkImageData* inputImage = images[i];
+    vtkImageData* outputImage = outputStreamingVolumeNode->GetImageData();
+    if (!inputImage || !outputImage)
+    {
+      return EXIT_FAILURE;
+    }
+
+    unsigned char* inputImagePointer = (unsigned char*)inputImage->GetScalarPointer();
+    unsigned char* outputImagePointer = (unsigned char*)outputImage->GetScalarPointer();
+    for (int y = 0; y < height; y++)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        for (int c = 0; c < 3; c++)
+        {
+          if (*inputImagePointer != *outputImagePointer)
+          {
+            return EXIT_FAILURE;
+          }
+          ++inputImagePointer;
+          ++outputImagePointer;
+        }
+      }
+    }
+  }
+
+  // Encode the input as an inter-frame stream with a keyframe every 25 frames.
+  // The uncompressed input has no keyframe blocks, so it is encoded by a single codec.
+  vtkTestingInterFrameCodec::Register();
+  int keyFrameDistance = 25;
+  std::map<std::string, std::string> codecParameters;
+  codecParameters["KeyFrameDistance"] = "25";
+  vtkNew<vtkMRMLSequenceNode> interFrameSequenceNode;
+  scene->AddNode(interFrameSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(sequenceNode, interFrameSequenceNode, 0, -1, "TIFC", codecParameters,
+    true, false, nullptr, encodingJob))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Transcode with more threads than keyframe blocks. The blocks are encoded in parallel, but they are never split,
+  // so the output only has keyframes where the input had them, although the codec would not add any keyframes itself.
+  encodingJob->SetNumberOfThreads(16);
+  vtkNew<vtkMRMLSequenceNode> transcodedSequenceNode;
+  scene->AddNode(transcodedSequenceNode);
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(interFrameSequenceNode, transcodedSequenceNode, 0, -1, "TIFC",
+    std::map<std::string, std::string>(), true, false, nullptr, encodingJob))
+  {
+    return EXIT_FAILURE;
+  }
+  if (transcodedSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    return EXIT_FAILURE;
+  }
+  vtkStreamingVolumeFrame* previousFrame = nullptr;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(transcodedSequenceNode->GetNthDataNode(i));
+    vtkStreamingVolumeFrame* frame = streamingVolumeNode ? streamingVolumeNode->GetFrame() : nullptr;
+    if (!frame || frame->IsKeyFrame() != (i % keyFrameDistance == 0)
+      || (!frame->IsKeyFrame() && frame->GetPreviousFrame() != previousFrame))
+    {
+      std::cerr << "Unexpected keyframe structure at frame " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+    previousFrame = frame;
+  }
+
+  return EXIT_SUCCESS;
+}
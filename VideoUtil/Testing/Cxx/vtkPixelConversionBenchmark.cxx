@@ -0,0 +1,175 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// Measures the time of the pixel conversion stage that runs before the codec. Not run by ctest.
+// Usage: vtkPixelConversionBenchmark [number of frames] [width] [height]
+
+// std includes
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOPixelConversion.h>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  // Per-pixel conversion of a 16-bit image to RGB, without the vectorized stage
+  void ScalarWindowLevelToRGB(const unsigned short* input, unsigned char* output, vtkIdType numberOfPixels, double window, double level)
+  {
+    double lower = level - window / 2.0;
+    double scale = 255.0 / window;
+    for (vtkIdType i = 0; i < numberOfPixels; ++i)
+    {
+      double value = std::min(std::max((input[i] - lower) * scale + 0.5, 0.0), 255.0);
+      output[3 * i] = output[3 * i + 1] = output[3 * i + 2] = static_cast<unsigned char>(value);
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // Per-pixel conversion of an 8-bit image to RGB, without the vectorized stage
+  void ScalarGrayToRGB(const unsigned char* input, unsigned char* output, vtkIdType numberOfPixels)
+  {
+    for (vtkIdType i = 0; i < numberOfPixels; ++i)
+    {
+      output[3 * i] = output[3 * i + 1] = output[3 * i + 2] = input[i];
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // BT.601 conversion of an RGB image to planar I420 with 2x2 chroma averaging, which an encoder with I420 input
+  // has to do for every RGB frame. Width and height must be even.
+  void ScalarRGBToI420(const unsigned char* input, unsigned char* output, int width, int height)
+  {
+    unsigned char* uPlane = output + width * height;
+    unsigned char* vPlane = uPlane + (width / 2) * (height / 2);
+    for (int i = 0; i < width * height; ++i)
+    {
+      output[i] = static_cast<unsigned char>(((66 * input[3 * i] + 129 * input[3 * i + 1] + 25 * input[3 * i + 2] + 128) >> 8) + 16);
+    }
+    for (int y = 0; y < height / 2; ++y)
+    {
+      const unsigned char* row0 = input + 3 * width * (2 * y);
+      const unsigned char* row1 = row0 + 3 * width;
+      for (int x = 0; x < width / 2; ++x)
+      {
+        int sum[3] = { 0, 0, 0 };
+        for (int c = 0; c < 3; ++c)
+        {
+          sum[c] = (row0[6 * x + c] + row0[6 * x + 3 + c] + row1[6 * x + c] + row1[6 * x + 3 + c] + 2) >> 2;
+        }
+        uPlane[y * (width / 2) + x] = static_cast<unsigned char>(((-38 * sum[0] - 74 * sum[1] + 112 * sum[2] + 128) >> 8) + 128);
+        vPlane[y * (width / 2) + x] = static_cast<unsigned char>(((112 * sum[0] - 94 * sum[1] - 18 * sum[2] + 128) >> 8) + 128);
+      }
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  template<typename ConvertFunction>
+  double GetMillisecondsPerFrame(int numFrames, ConvertFunction convert)
+  {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < numFrames; ++i)
+    {
+      convert();
+    }
+    return 1000.0 * std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() / numFrames;
+  }
+
+  //---------------------------------------------------------------------------
+  void PrintResult(const std::string& name, double referenceMilliseconds, double milliseconds)
+  {
+    std::cout << std::left << std::setw(50) << name << std::fixed << std::setprecision(3)
+      << referenceMilliseconds << " ms -> " << milliseconds << " ms per frame ("
+      << std::setprecision(1) << referenceMilliseconds / milliseconds << "x)" << std::endl;
+  }
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  int numFrames = argc > 1 ? atoi(argv[1]) : 500;
+  int width = argc > 2 ? atoi(argv[2]) : 640;
+  int height = argc > 3 ? atoi(argv[3]) : 480;
+  if (numFrames < 1 || width < 2 || height < 2 || width % 2 != 0 || height % 2 != 0)
+  {
+    std::cerr << "Usage: vtkPixelConversionBenchmark [number of frames] [even width] [even height]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkIdType numberOfPixels = static_cast<vtkIdType>(width) * height;
+  double window = 4096.0;
+  double level = 2048.0;
+
+  vtkNew<vtkImageData> grayImageData;
+  grayImageData->SetDimensions(width, height, 1);
+  grayImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* gray = static_cast<unsigned char*>(grayImageData->GetScalarPointer());
+  vtkNew<vtkImageData> shortImageData;
+  shortImageData->SetDimensions(width, height, 1);
+  shortImageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  unsigned short* values = static_cast<unsigned short*>(shortImageData->GetScalarPointer());
+  for (vtkIdType i = 0; i < numberOfPixels; ++i)
+  {
+    gray[i] = static_cast<unsigned char>(i * 7);
+    values[i] = static_cast<unsigned short>((i * 13) % 4096);
+  }
+
+  vtkNew<vtkImageData> rgbImageData;
+  rgbImageData->SetDimensions(width, height, 1);
+  rgbImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  unsigned char* rgb = static_cast<unsigned char*>(rgbImageData->GetScalarPointer());
+  std::vector<unsigned char> i420(numberOfPixels + numberOfPixels / 2);
+
+  std::cout << numFrames << " frames of " << width << "x" << height << " pixels, instruction set: "
+    << vtkSlicerIGSIOPixelConversion::GetInstructionSet() << std::endl;
+
+  // Conversion stage of codecs that require RGB input, compared with per-pixel conversion
+  PrintResult("8-bit gray to RGB",
+    GetMillisecondsPerFrame(numFrames, [&]() { ScalarGrayToRGB(gray, rgb, numberOfPixels); }),
+    GetMillisecondsPerFrame(numFrames, [&]() { vtkSlicerIGSIOPixelConversion::ConvertToRGB(grayImageData, rgbImageData, window, level); }));
+  PrintResult("16-bit window/level to RGB",
+    GetMillisecondsPerFrame(numFrames, [&]() { ScalarWindowLevelToRGB(values, rgb, numberOfPixels, window, level); }),
+    GetMillisecondsPerFrame(numFrames, [&]() { vtkSlicerIGSIOPixelConversion::ConvertToRGB(shortImageData, rgbImageData, window, level); }));
+
+  // Conversion that could be saved if a codec with I420 input accepted an I420 buffer: a gray image is expanded to RGB
+  // by the stage and converted to I420 by the codec, instead of copying the luma and filling the chroma planes.
+  PrintResult("8-bit gray to I420 through RGB / directly",
+    GetMillisecondsPerFrame(numFrames, [&]()
+      {
+        vtkSlicerIGSIOPixelConversion::ConvertToRGB(grayImageData, rgbImageData, window, level);
+        ScalarRGBToI420(rgb, i420.data(), width, height);
+      }),
+    GetMillisecondsPerFrame(numFrames, [&]()
+      {
+        memcpy(i420.data(), gray, numberOfPixels);
+        memset(i420.data() + numberOfPixels, 128, numberOfPixels / 2);
+      }));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <algorithm>
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOPixelConversion.h>
+
+//---------------------------------------------------------------------------
+int vtkPixelConversionTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Odd dimensions, so that both the vectorized loops and the remaining pixels are tested
+  int width = 37;
+  int height = 5;
+
+  vtkNew<vtkImageData> grayImageData;
+  grayImageData->SetDimensions(width, height, 1);
+  grayImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* gray = static_cast<unsigned char*>(grayImageData->GetScalarPointer());
+  for (int i = 0; i < width * height; ++i)
+  {
+    gray[i] = static_cast<unsigned char>(i);
+  }
+
+  vtkNew<vtkImageData> rgbImageData;
+  if (!vtkSlicerIGSIOPixelConversion::GrayToRGB(grayImageData, rgbImageData)
+    || rgbImageData->GetNumberOfScalarComponents() != 3)
+  {
+    std::cerr << "GrayToRGB failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned char* rgb = static_cast<unsigned char*>(rgbImageData->GetScalarPointer());
+  for (int i = 0; i < width * height; ++i)
+  {
+    if (rgb[3 * i] != gray[i] || rgb[3 * i + 1] != gray[i] || rgb[3 * i + 2] != gray[i])
+    {
+      std::cerr << "Invalid RGB value at pixel " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Gray RGB pixels are converted back to the same luma
+  vtkNew<vtkImageData> lumaImageData;
+  if (!vtkSlicerIGSIOPixelConversion::RGBToGray(rgbImageData, lumaImageData)
+    || lumaImageData->GetNumberOfScalarComponents() != 1
+    || !std::equal(gray, gray + width * height, static_cast<unsigned char*>(lumaImageData->GetScalarPointer())))
+  {
+    std::cerr << "RGBToGray failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // 16-bit values below the window are black and values above it are white
+  vtkNew<vtkImageData> shortImageData;
+  shortImageData->SetDimensions(width, height, 1);
+  shortImageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  unsigned short* values = static_cast<unsigned short*>(shortImageData->GetScalarPointer());
+  for (int i = 0; i < width * height; ++i)
+  {
+    values[i] = static_cast<unsigned short>(i * 300);
+  }
+  vtkNew<vtkImageData> windowLevelImageData;
+  if (!vtkSlicerIGSIOPixelConversion::WindowLevelToGray(shortImageData, windowLevelImageData, 25500.0, 22750.0))
+  {
+    std::cerr << "WindowLevelToGray failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned char* mapped = static_cast<unsigned char*>(windowLevelImageData->GetScalarPointer());
+  for (int i = 0; i < width * height; ++i)
+  {
+    int expected = std::min(std::max((values[i] - 10000) / 100, 0), 255);
+    if (mapped[i] != expected)
+    {
+      std::cerr << "Invalid window/level value at pixel " << i << ": " << int(mapped[i]) << " != " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // 16-bit images are expanded to RGB after the window and level are applied
+  vtkNew<vtkImageData> windowLevelRGBImageData;
+  if (!vtkSlicerIGSIOPixelConversion::ConvertToRGB(shortImageData, windowLevelRGBImageData, 25500.0, 22750.0)
+    || windowLevelRGBImageData->GetNumberOfScalarComponents() != 3)
+  {
+    std::cerr << "ConvertToRGB failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned char* mappedRGB = static_cast<unsigned char*>(windowLevelRGBImageData->GetScalarPointer());
+  for (int i = 0; i < width * height; ++i)
+  {
+    if (mappedRGB[3 * i] != mapped[i] || mappedRGB[3 * i + 1] != mapped[i] || mappedRGB[3 * i + 2] != mapped[i])
+    {
+      std::cerr << "Invalid converted RGB value at pixel " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
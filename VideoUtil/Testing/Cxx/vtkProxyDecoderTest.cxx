@@ -0,0 +1,140 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIODecodedFrameCache.h>
+#include <vtkSlicerIGSIOProxyDecoder.h>
+
+//---------------------------------------------------------------------------
+int vtkProxyDecoderTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int numFrames = 20;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  vtkNew<vtkMRMLStreamingVolumeNode> proxyNode;
+  scene->AddNode(proxyNode);
+  browserNode->AddProxyNode(proxyNode, sequenceNode, false);
+  browserNode->SetSaveChanges(sequenceNode, false);
+
+  vtkNew<vtkSlicerIGSIODecodedFrameCache> cache;
+  vtkNew<vtkSlicerIGSIOProxyDecoder> proxyDecoder;
+  proxyDecoder->SetDecodedFrameCache(cache);
+
+  // Frames that are not cached are set in the proxy node after they are decoded
+  browserNode->SetSelectedItemNumber(5);
+  proxyDecoder->RequestUpdate(browserNode);
+  proxyDecoder->Wait();
+  if (!proxyDecoder->HasCompletedRequests() || proxyDecoder->ProcessCompletedRequests() != 1
+    || proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 5)
+  {
+    std::cerr << "Proxy node was not updated with the decoded image" << std::endl;
+    proxyDecoder->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Only the latest request is shown
+  for (int i = 6; i <= 12; ++i)
+  {
+    browserNode->SetSelectedItemNumber(i);
+    proxyDecoder->RequestUpdate(browserNode);
+  }
+  proxyDecoder->Wait();
+  if (proxyDecoder->ProcessCompletedRequests() != 1
+    || proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 12)
+  {
+    std::cerr << "Proxy node was not updated with the image of the latest request" << std::endl;
+    proxyDecoder->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  if (proxyDecoder->GetNumberOfDecodedRequests() + proxyDecoder->GetNumberOfSupersededRequests() != 8)
+  {
+    proxyDecoder->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Cached frames are set immediately
+  browserNode->SetSelectedItemNumber(5);
+  proxyDecoder->RequestUpdate(browserNode);
+  if (proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 5 || proxyDecoder->HasCompletedRequests())
+  {
+    std::cerr << "Cached image was not set in the proxy node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The proxy node does not share the image object of the cache
+  if (proxyNode->GetImageData() == cache->GetDecodedImage(sequenceNode, 5).GetPointer())
+  {
+    std::cerr << "Cached image was set in the proxy node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Images of removed browsers are discarded
+  browserNode->SetSelectedItemNumber(15);
+  proxyDecoder->RequestUpdate(browserNode);
+  proxyDecoder->RemoveSequenceBrowser(browserNode);
+  proxyDecoder->Wait();
+  if (proxyDecoder->ProcessCompletedRequests() != 0)
+  {
+    std::cerr << "Image of a removed browser was set in the proxy node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioTransformName.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// Sequences logic includes
+#include <vtkSlicerSequencesLogic.h>
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+
+// VideoUtil includes
+#include "vtkTestingInterFrameCodec.h"
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  // Export the browser without selecting its items, and check the images and transforms of the frames
+  bool TestDirectExport(vtkMRMLSequenceBrowserNode* browserNode, int numFrames)
+  {
+    browserNode->SetSelectedItemNumber(3);
+    vtkMTimeType browserMTime = browserNode->GetMTime();
+
+    vtkNew<vtkIGSIOTrackedFrameList> exportedTrackedFrameList;
+    if (!vtkSlicerIGSIOCommon::SequenceBrowserToTrackedFrameList(browserNode, exportedTrackedFrameList, true))
+    {
+      std::cerr << "Could not export the sequence browser" << std::endl;
+      return false;
+    }
+    if (exportedTrackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numFrames))
+    {
+      std::cerr << "Expected " << numFrames << " tracked frames, got " << exportedTrackedFrameList->GetNumberOfTrackedFrames() << std::endl;
+      return false;
+    }
+    if (browserNode->GetSelectedItemNumber() != 3 || browserNode->GetMTime() != browserMTime)
+    {
+      std::cerr << "The sequence browser was modified by the export" << std::endl;
+      return false;
+    }
+
+    igsioTrackedFrame* trackedFrame = exportedTrackedFrameList->GetTrackedFrame(42);
+    vtkNew<vtkMatrix4x4> matrix;
+    if (trackedFrame->GetFrameTransform(igsioTransformName("Probe", "Tracker"), matrix) != IGSIO_SUCCESS
+      || matrix->GetElement(0, 3) != 42.0)
+    {
+      std::cerr << "Unexpected transform of frame 42" << std::endl;
+      return false;
+    }
+    if (trackedFrame->GetFrameTransform(igsioTransformName("Image", "World"), matrix) != IGSIO_SUCCESS)
+    {
+      std::cerr << "No image transform in frame 42" << std::endl;
+      return false;
+    }
+    vtkImageData* imageData = trackedFrame->GetImageData()->GetImage();
+    if (!imageData || imageData->GetScalarComponentAsDouble(0, 0, 0, 0) != 42.0)
+    {
+      std::cerr << "Unexpected image of frame 42" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  bool CheckSameTransform(igsioTrackedFrame* directTrackedFrame, igsioTrackedFrame* proxyTrackedFrame, const igsioTransformName& transformName, int frameNumber)
+  {
+    vtkNew<vtkMatrix4x4> directMatrix;
+    vtkNew<vtkMatrix4x4> proxyMatrix;
+    if (directTrackedFrame->GetFrameTransform(transformName, directMatrix) != IGSIO_SUCCESS
+      || proxyTrackedFrame->GetFrameTransform(transformName, proxyMatrix) != IGSIO_SUCCESS)
+    {
+      std::cerr << "Missing transform " << transformName.GetTransformName() << " in frame " << frameNumber << std::endl;
+      return false;
+    }
+    for (int row = 0; row < 4; ++row)
+    {
+      for (int column = 0; column < 4; ++column)
+      {
+        if (std::abs(directMatrix->GetElement(row, column) - proxyMatrix->GetElement(row, column)) > 1e-6)
+        {
+          std::cerr << "Transform " << transformName.GetTransformName() << " of frame " << frameNumber
+            << " differs between direct and proxy export" << std::endl;
+          directMatrix->Print(std::cerr);
+          proxyMatrix->Print(std::cerr);
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  // Export the browser directly and through the proxy nodes, and check that the images and transforms are the same
+  bool TestDirectExportMatchesProxyExport(vtkMRMLSequenceBrowserNode* browserNode, const std::string& transformName)
+  {
+    vtkNew<vtkIGSIOTrackedFrameList> directTrackedFrameList;
+    vtkNew<vtkIGSIOTrackedFrameList> proxyTrackedFrameList;
+    if (!vtkSlicerIGSIOCommon::SequenceBrowserToTrackedFrameList(browserNode, directTrackedFrameList, true)
+      || !vtkSlicerIGSIOCommon::SequenceBrowserToTrackedFrameList(browserNode, proxyTrackedFrameList, false))
+    {
+      std::cerr << "Could not export the sequence browser" << std::endl;
+      return false;
+    }
+    if (directTrackedFrameList->GetNumberOfTrackedFrames() != proxyTrackedFrameList->GetNumberOfTrackedFrames())
+    {
+      std::cerr << "Direct export has " << directTrackedFrameList->GetNumberOfTrackedFrames() << " frames, proxy export has "
+        << proxyTrackedFrameList->GetNumberOfTrackedFrames() << std::endl;
+      return false;
+    }
+
+    for (unsigned int i = 0; i < directTrackedFrameList->GetNumberOfTrackedFrames(); ++i)
+    {
+      igsioTrackedFrame* directTrackedFrame = directTrackedFrameList->GetTrackedFrame(i);
+      igsioTrackedFrame* proxyTrackedFrame = proxyTrackedFrameList->GetTrackedFrame(i);
+      if (!CheckSameTransform(directTrackedFrame, proxyTrackedFrame, igsioTransformName(transformName), i)
+        || !CheckSameTransform(directTrackedFrame, proxyTrackedFrame, igsioTransformName("Image", "World"), i))
+      {
+        return false;
+      }
+
+      vtkImageData* directImageData = directTrackedFrame->GetImageData()->GetImage();
+      vtkImageData* proxyImageData = proxyTrackedFrame->GetImageData()->GetImage();
+      if (!directImageData || !proxyImageData
+        || directImageData->GetNumberOfScalarComponents() != proxyImageData->GetNumberOfScalarComponents()
+        || directImageData->GetScalarComponentAsDouble(1, 1, 0, 0) != i
+        || proxyImageData->GetScalarComponentAsDouble(1, 1, 0, 0) != i)
+      {
+        std::cerr << "Image of frame " << i << " differs between direct and proxy export" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkSequenceBrowserToTrackedFrameListTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int numFrames = 100;
+
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  trackedFrameList->SetCustomString("TrackName", "Image");
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(4, 4, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    image->GetPointData()->GetScalars()->Fill(i);
+    igsioVideoFrame videoFrame;
+    videoFrame.DeepCopyFrom(image);
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(videoFrame);
+    trackedFrame.SetTimestamp(0.1 * i);
+    matrix->SetElement(0, 3, i);
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    trackedFrame.SetFrameTransform(probeToTracker, matrix);
+    trackedFrame.SetFrameTransformStatus(probeToTracker, ToolStatus::TOOL_OK);
+    trackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+
+  // Transforms that are stored as data nodes
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, browserNode)
+    || !TestDirectExport(browserNode, numFrames))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Compact transforms are read from the transform sequence, not from the proxy node
+  vtkNew<vtkMRMLSequenceBrowserNode> compactBrowserNode;
+  scene->AddNode(compactBrowserNode);
+  bool success = vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, compactBrowserNode, false, true);
+  if (!success || !TestDirectExport(compactBrowserNode, numFrames))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Encoded inter-frames, an image with a parent transform, and tracking timestamps that do not match the video
+  // are exported the same way directly and through the proxy nodes
+  vtkTestingInterFrameCodec::Register();
+  vtkNew<vtkMRMLScene> encodedScene;
+  vtkNew<vtkSlicerSequencesLogic> sequencesLogic;
+  sequencesLogic->SetMRMLScene(encodedScene);
+
+  int numEncodedFrames = 20;
+  vtkNew<vtkMRMLSequenceNode> rawSequenceNode;
+  encodedScene->AddNode(rawSequenceNode);
+  vtkNew<vtkMRMLSequenceNode> probeToTrackerSequenceNode;
+  encodedScene->AddNode(probeToTrackerSequenceNode);
+  for (int i = 0; i < numEncodedFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(8, 6, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+    streamingVolumeNode->SetSpacing(0.5, 0.5, 1.0);
+    streamingVolumeNode->SetOrigin(10.0, 20.0, 30.0);
+    std::stringstream imageIndexValue;
+    imageIndexValue << 0.1 * i;
+    rawSequenceNode->SetDataNodeAtValue(streamingVolumeNode, imageIndexValue.str());
+
+    vtkSmartPointer<vtkMRMLLinearTransformNode> transformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+    matrix->Identity();
+    matrix->SetElement(0, 3, i);
+    matrix->SetElement(1, 1, 0.0);
+    matrix->SetElement(1, 2, -1.0);
+    matrix->SetElement(2, 1, 1.0);
+    matrix->SetElement(2, 2, 0.0);
+    transformNode->SetMatrixTransformToParent(matrix);
+    std::stringstream transformIndexValue;
+    transformIndexValue << 0.1 * i + 0.03;
+    probeToTrackerSequenceNode->SetDataNodeAtValue(transformNode, transformIndexValue.str());
+  }
+
+  vtkNew<vtkMRMLSequenceNode> videoSequenceNode;
+  encodedScene->AddNode(videoSequenceNode);
+  std::map<std::string, std::string> codecParameters;
+  codecParameters["KeyFrameDistance"] = "4";
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(rawSequenceNode, videoSequenceNode, 0, -1, "TIFC", codecParameters, true))
+  {
+    std::cerr << "Could not encode the video sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> encodedBrowserNode;
+  encodedScene->AddNode(encodedBrowserNode);
+  encodedBrowserNode->SetAndObserveMasterSequenceNodeID(videoSequenceNode->GetID());
+  encodedBrowserNode->AddSynchronizedSequenceNodeID(probeToTrackerSequenceNode->GetID());
+  vtkNew<vtkMRMLStreamingVolumeNode> videoProxyNode;
+  encodedScene->AddNode(videoProxyNode);
+  encodedBrowserNode->AddProxyNode(videoProxyNode, videoSequenceNode, false);
+  encodedBrowserNode->SetSaveChanges(videoSequenceNode, false);
+  vtkNew<vtkMRMLLinearTransformNode> probeToTrackerProxyNode;
+  probeToTrackerProxyNode->SetName("ProbeToTracker");
+  encodedScene->AddNode(probeToTrackerProxyNode);
+  encodedBrowserNode->AddProxyNode(probeToTrackerProxyNode, probeToTrackerSequenceNode, false);
+  encodedBrowserNode->SetSaveChanges(probeToTrackerSequenceNode, false);
+  videoProxyNode->SetAndObserveTransformNodeID(probeToTrackerProxyNode->GetID());
+  encodedBrowserNode->SetSelectedItemNumber(0);
+
+  if (!TestDirectExportMatchesProxyExport(encodedBrowserNode, "ProbeToTracker"))
+  {
+    return EXIT_FAILURE;
+  }
+  sequencesLogic->SetMRMLScene(nullptr);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+#ifndef __vtkTestingInterFrameCodec_h
+#define __vtkTestingInterFrameCodec_h
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+#include <vtkStreamingVolumeFrame.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// Lossless inter-frame codec that is used to test encoded sequences with previous frame chains.
+///
+/// Each frame stores the complete image, but only the first frame, frames that are forced to be keyframes, and every
+/// "KeyFrameDistance" frames are marked as keyframes. The other frames reference the previously encoded frame.
+/// Decoding an inter-frame fails if the decoder has not decoded its previous frame, like a real inter-frame codec.
+class vtkTestingInterFrameCodec : public vtkStreamingVolumeCodec
+{
+public:
+  static vtkTestingInterFrameCodec* New()
+  {
+    VTK_STANDARD_NEW_BODY(vtkTestingInterFrameCodec);
+  }
+  vtkTypeMacro(vtkTestingInterFrameCodec, vtkStreamingVolumeCodec);
+
+  vtkStreamingVolumeCodec* CreateCodecInstance() override
+  {
+    return vtkTestingInterFrameCodec::New();
+  }
+
+  std::string GetFourCC() override
+  {
+    return "TIFC";
+  }
+
+  /// Register the codec with the codec factory, if it has not been registered yet.
+  static void Register()
+  {
+    vtkStreamingVolumeCodecFactory* factory = vtkStreamingVolumeCodecFactory::GetInstance();
+    std::vector<std::string> fourCCs = factory->GetStreamingCodecFourCCs();
+    if (std::find(fourCCs.begin(), fourCCs.end(), "TIFC") == fourCCs.end())
+    {
+      factory->RegisterStreamingCodec(vtkSmartPointer<vtkTestingInterFrameCodec>::New());
+    }
+  }
+
+  /// Number of frames that were encoded by this codec instance
+  int NumberOfEncodedFrames;
+
+protected:
+  vtkTestingInterFrameCodec()
+    : NumberOfEncodedFrames(0)
+    , KeyFrameDistance(0)
+  {
+  }
+  ~vtkTestingInterFrameCodec() override = default;
+
+  bool DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool vtkNotUsed(saveDecodedImage)) override
+  {
+    if (!inputFrame->IsKeyFrame() && inputFrame->GetPreviousFrame() != this->PreviousDecodedFrame)
+    {
+      return false;
+    }
+    int dimensions[3] = { 0, 0, 0 };
+    inputFrame->GetDimensions(dimensions);
+    outputImageData->SetDimensions(dimensions);
+    outputImageData->AllocateScalars(inputFrame->GetVTKScalarType(), inputFrame->GetNumberOfComponents());
+    vtkUnsignedCharArray* frameData = inputFrame->GetFrameData();
+    if (!frameData || frameData->GetNumberOfValues() != static_cast<vtkIdType>(outputImageData->GetScalarSize())
+      * dimensions[0] * dimensions[1] * dimensions[2] * inputFrame->GetNumberOfComponents())
+    {
+      return false;
+    }
+    memcpy(outputImageData->GetScalarPointer(), frameData->GetPointer(0), frameData->GetNumberOfValues());
+    this->PreviousDecodedFrame = inputFrame;
+    return true;
+  }
+
+  bool EncodeImageDataInternal(vtkImageData* inputImageData, vtkStreamingVolumeFrame* outputFrame, bool forceKeyFrame) override
+  {
+    int dimensions[3] = { 0, 0, 0 };
+    inputImageData->GetDimensions(dimensions);
+    vtkIdType numberOfBytes = static_cast<vtkIdType>(inputImageData->GetScalarSize()) * inputImageData->GetNumberOfScalarComponents()
+      * dimensions[0] * dimensions[1] * dimensions[2];
+
+    vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    frameData->SetNumberOfValues(numberOfBytes);
+    memcpy(frameData->GetPointer(0), inputImageData->GetScalarPointer(), numberOfBytes);
+
+    bool keyFrame = forceKeyFrame || !this->PreviousEncodedFrame
+      || (this->KeyFrameDistance > 0 && this->NumberOfEncodedFrames % this->KeyFrameDistance == 0);
+    outputFrame->SetFrameType(keyFrame ? vtkStreamingVolumeFrame::IFrame : vtkStreamingVolumeFrame::PFrame);
+    outputFrame->SetPreviousFrame(keyFrame ? nullptr : this->PreviousEncodedFrame.GetPointer());
+    outputFrame->SetFrameData(frameData);
+    outputFrame->SetDimensions(dimensions);
+    outputFrame->SetVTKScalarType(inputImageData->GetScalarType());
+    outputFrame->SetNumberOfComponents(inputImageData->GetNumberOfScalarComponents());
+    outputFrame->SetCodecFourCC(this->GetFourCC());
+    this->PreviousEncodedFrame = outputFrame;
+    ++this->NumberOfEncodedFrames;
+    return true;
+  }
+
+  bool UpdateParameterInternal(std::string parameterValue, std::string parameterName) override
+  {
+    if (parameterName == "KeyFrameDistance")
+    {
+      this->KeyFrameDistance = std::atoi(parameterValue.c_str());
+      return true;
+    }
+    return false;
+  }
+
+  int KeyFrameDistance;
+  vtkSmartPointer<vtkStreamingVolumeFrame> PreviousEncodedFrame;
+  vtkSmartPointer<vtkStreamingVolumeFrame> PreviousDecodedFrame;
+
+private:
+  vtkTestingInterFrameCodec(const vtkTestingInterFrameCodec&); // Not implemented
+  void operator=(const vtkTestingInterFrameCodec&);            // Not implemented
+};
+
+#endif // __vtkTestingInterFrameCodec_h
@@ -0,0 +1,171 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// Measures the time to convert a tracked frame list to a volume sequence. Not run by ctest.
+// Usage: vtkTrackedFrameListToVolumeSequenceBenchmark [number of frames] [width] [height]
+
+// std includes
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkVariant.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioTransformName.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  // Conversion as it was done before the bulk import: each data node is inserted separately, with the modified events
+  // of the sequence invoked for every frame, and the status, index value and name are formatted with streams.
+  void PerFrameTrackedFrameListToVolumeSequence(vtkIGSIOTrackedFrameList* trackedFrameList, vtkMRMLSequenceNode* sequenceNode)
+  {
+    vtkMRMLScene* scene = sequenceNode->GetScene();
+    int frameNumberMaxLength = std::floor(std::log10(trackedFrameList->GetNumberOfTrackedFrames())) + 1;
+    igsioTransformName imageToPhysicalTransformName("Image", "Physical");
+    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+    {
+      igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
+      std::string frameStatus = trackedFrame->GetFrameField("FrameStatus");
+      if (vtkVariant(frameStatus.c_str()).ToInt() != 0)
+      {
+        continue;
+      }
+
+      std::stringstream timestampSS;
+      timestampSS << trackedFrame->GetTimestamp();
+
+      vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::Take(
+        vtkMRMLScalarVolumeNode::SafeDownCast(scene->CreateNodeByClass("vtkMRMLScalarVolumeNode")));
+      volumeNode->SetAndObserveImageData(trackedFrame->GetImageData()->GetImage());
+
+      vtkNew<vtkMatrix4x4> ijkToRASTransformMatrix;
+      if (trackedFrame->GetFrameTransform(imageToPhysicalTransformName, ijkToRASTransformMatrix) == IGSIO_SUCCESS)
+      {
+        volumeNode->SetIJKToRASMatrix(ijkToRASTransformMatrix);
+      }
+
+      std::stringstream frameNumberSS;
+      frameNumberSS << std::setw(frameNumberMaxLength) << std::setfill('0') << i;
+      std::ostringstream nameStr;
+      nameStr << "Image_" << frameNumberSS.str() << std::ends;
+      volumeNode->SetName(nameStr.str().c_str());
+      sequenceNode->SetDataNodeAtValue(volumeNode, timestampSS.str());
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  double GetElapsedSeconds(std::chrono::steady_clock::time_point startTime)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  int numFrames = argc > 1 ? atoi(argv[1]) : 50000;
+  int width = argc > 2 ? atoi(argv[2]) : 16;
+  int height = argc > 3 ? atoi(argv[3]) : 16;
+  if (numFrames < 1 || width < 1 || height < 1)
+  {
+    std::cerr << "Usage: vtkTrackedFrameListToVolumeSequenceBenchmark [number of frames] [width] [height]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  trackedFrameList->SetCustomString("TrackName", "Image");
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(width, height, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+    igsioVideoFrame videoFrame;
+    videoFrame.DeepCopyFrom(image);
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(videoFrame);
+    trackedFrame.SetTimestamp(0.1 * i);
+    vtkNew<vtkMatrix4x4> imageToPhysical;
+    imageToPhysical->SetElement(0, 3, i);
+    trackedFrame.SetFrameTransform(igsioTransformName("Image", "Physical"), imageToPhysical);
+    trackedFrame.SetFrameField("FrameStatus", "0");
+    trackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+
+  vtkNew<vtkMRMLScene> perFrameScene;
+  vtkNew<vtkMRMLSequenceNode> perFrameSequenceNode;
+  perFrameScene->AddNode(perFrameSequenceNode);
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  PerFrameTrackedFrameListToVolumeSequence(trackedFrameList, perFrameSequenceNode);
+  double perFrameSeconds = GetElapsedSeconds(startTime);
+
+  vtkNew<vtkMRMLScene> bulkScene;
+  vtkNew<vtkMRMLSequenceNode> bulkSequenceNode;
+  bulkScene->AddNode(bulkSequenceNode);
+  startTime = std::chrono::steady_clock::now();
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, bulkSequenceNode))
+  {
+    std::cerr << "Could not convert the tracked frame list!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double bulkSeconds = GetElapsedSeconds(startTime);
+
+  vtkNew<vtkMRMLScene> consumeScene;
+  vtkNew<vtkMRMLSequenceNode> consumeSequenceNode;
+  consumeScene->AddNode(consumeSequenceNode);
+  startTime = std::chrono::steady_clock::now();
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, consumeSequenceNode, true))
+  {
+    std::cerr << "Could not convert the tracked frame list!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double consumeSeconds = GetElapsedSeconds(startTime);
+
+  std::cout << numFrames << " frames of " << width << "x" << height << " pixels" << std::endl;
+  std::cout << "Per-frame insertion: " << perFrameSeconds << "s" << std::endl;
+  std::cout << "Bulk insertion: " << bulkSeconds << "s (" << perFrameSeconds / bulkSeconds << "x)" << std::endl;
+  std::cout << "Bulk insertion, consuming the frames: " << consumeSeconds << "s (" << perFrameSeconds / consumeSeconds << "x)" << std::endl;
+
+  return EXIT_SUCCESS;
+}
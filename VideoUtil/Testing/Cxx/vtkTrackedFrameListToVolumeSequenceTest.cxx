@@ -0,0 +1,187 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+#include <sstream>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioTransformName.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  void CountModifiedEvents(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eventId), void* clientData, void* vtkNotUsed(callData))
+  {
+    int* numberOfModifiedEvents = static_cast<int*>(clientData);
+    ++(*numberOfModifiedEvents);
+  }
+}
+
+//---------------------------------------------------------------------------
+int vtkTrackedFrameListToVolumeSequenceTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int width = 64;
+  int height = 64;
+  int numFrames = 1000;
+
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  trackedFrameList->SetCustomString("TrackName", "Image");
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(width, height, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+    igsioVideoFrame videoFrame;
+    videoFrame.DeepCopyFrom(image);
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(videoFrame);
+    trackedFrame.SetTimestamp(0.1 * i);
+    vtkNew<vtkMatrix4x4> imageToPhysical;
+    imageToPhysical->SetElement(0, 3, i);
+    trackedFrame.SetFrameTransform(igsioTransformName("Image", "Physical"), imageToPhysical);
+    // Every tenth frame is skipped
+    trackedFrame.SetFrameField("FrameStatus", i % 10 == 9 ? "1" : "0");
+    trackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+  int numValidFrames = numFrames - numFrames / 10;
+
+  // Reference: insert each data node separately
+  vtkNew<vtkMRMLScene> referenceScene;
+  vtkNew<vtkMRMLSequenceNode> referenceSequenceNode;
+  referenceScene->AddNode(referenceSequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    if (i % 10 == 9)
+    {
+      continue;
+    }
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    volumeNode->SetAndObserveImageData(trackedFrameList->GetTrackedFrame(i)->GetImageData()->GetImage());
+    std::stringstream timestampSS;
+    timestampSS << trackedFrameList->GetTrackedFrame(i)->GetTimestamp();
+    referenceSequenceNode->SetDataNodeAtValue(volumeNode, timestampSS.str());
+  }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+
+  int numberOfModifiedEvents = 0;
+  vtkNew<vtkCallbackCommand> modifiedCallback;
+  modifiedCallback->SetCallback(CountModifiedEvents);
+  modifiedCallback->SetClientData(&numberOfModifiedEvents);
+  sequenceNode->AddObserver(vtkCommand::ModifiedEvent, modifiedCallback);
+
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, sequenceNode))
+  {
+    std::cerr << "Could not convert the tracked frame list!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (sequenceNode->GetNumberOfDataNodes() != numValidFrames)
+  {
+    std::cerr << "Expected " << numValidFrames << " data nodes, got " << sequenceNode->GetNumberOfDataNodes() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The modified events of the sequence are only invoked once for the inserted data nodes
+  if (numberOfModifiedEvents > 10)
+  {
+    std::cerr << "Too many modified events: " << numberOfModifiedEvents << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Index values and names are formatted the same way as before
+  for (int i = 0; i < numValidFrames; ++i)
+  {
+    if (sequenceNode->GetNthIndexValue(i) != referenceSequenceNode->GetNthIndexValue(i))
+    {
+      std::cerr << "Index value mismatch at item " << i << ": " << sequenceNode->GetNthIndexValue(i)
+        << " != " << referenceSequenceNode->GetNthIndexValue(i) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (std::string(sequenceNode->GetNthDataNode(0)->GetName()) != "Image_0000"
+    || std::string(sequenceNode->GetNthDataNode(9)->GetName()) != "Image_0010")
+  {
+    std::cerr << "Unexpected data node names: " << sequenceNode->GetNthDataNode(0)->GetName()
+      << ", " << sequenceNode->GetNthDataNode(9)->GetName() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The geometry is read from the ImageToPhysical transform of each frame
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(numValidFrames - 1))->GetIJKToRASMatrix(ijkToRAS);
+  if (ijkToRAS->GetElement(0, 3) != numFrames - 2)
+  {
+    std::cerr << "Unexpected IJKToRAS translation: " << ijkToRAS->GetElement(0, 3) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Frames are removed from the list as they are converted if the list is consumed
+  unsigned int numberOfTrackedFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  vtkNew<vtkMRMLSequenceNode> consumedSequenceNode;
+  scene->AddNode(consumedSequenceNode);
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToVolumeSequence(trackedFrameList, consumedSequenceNode, true))
+  {
+    std::cerr << "Could not consume the tracked frame list!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (trackedFrameList->GetNumberOfTrackedFrames() != 0 || numberOfTrackedFrames != static_cast<unsigned int>(numFrames)
+    || consumedSequenceNode->GetNumberOfDataNodes() != numValidFrames)
+  {
+    std::cerr << "Expected an empty list and " << numValidFrames << " data nodes, got " << trackedFrameList->GetNumberOfTrackedFrames()
+      << " frames and " << consumedSequenceNode->GetNumberOfDataNodes() << " data nodes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numValidFrames; ++i)
+  {
+    if (consumedSequenceNode->GetNthIndexValue(i) != sequenceNode->GetNthIndexValue(i)
+      || std::string(consumedSequenceNode->GetNthDataNode(i)->GetName()) != sequenceNode->GetNthDataNode(i)->GetName())
+    {
+      std::cerr << "Consumed item mismatch at item " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioTransformName.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+#include <vtkMRMLSequenceStorageNode.h>
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOTransformSequence.h>
+
+// VideoUtil includes
+#include <vtkSlicerVideoUtilLogic.h>
+
+//---------------------------------------------------------------------------
+int vtkTransformSequenceSaveTest(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: vtkTransformSequenceSaveTest <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string fileName = std::string(argv[1]) + "/vtkTransformSequenceSaveTest.seq.mrb";
+  int numFrames = 50;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerVideoUtilLogic> logic;
+  logic->SetMRMLScene(scene);
+
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  trackedFrameList->SetCustomString("TrackName", "Image");
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(4, 4, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    igsioVideoFrame videoFrame;
+    videoFrame.DeepCopyFrom(image);
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(videoFrame);
+    trackedFrame.SetTimestamp(0.1 * i);
+    matrix->SetElement(0, 3, i);
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    trackedFrame.SetFrameTransform(probeToTracker, matrix);
+    trackedFrame.SetFrameTransformStatus(probeToTracker, ToolStatus::TOOL_OK);
+    trackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  bool success = vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, browserNode, false, true);
+  if (!success)
+  {
+    std::cerr << "Could not convert the tracked frame list" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkMRMLSequenceNode* transformSequenceNode = nullptr;
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    if (vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(sequenceNode))
+    {
+      transformSequenceNode = sequenceNode;
+    }
+  }
+  if (!transformSequenceNode || transformSequenceNode->GetNumberOfDataNodes() != 0)
+  {
+    std::cerr << "Expected a compact transform sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The compact transforms are expanded into data nodes when the scene is saved
+  vtkNew<vtkMRMLSequenceStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  transformSequenceNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  scene->StartState(vtkMRMLScene::SaveState);
+  success = storageNode->WriteData(transformSequenceNode) != 0;
+  scene->EndState(vtkMRMLScene::SaveState);
+  if (!success)
+  {
+    std::cerr << "Could not write the transform sequence to " << fileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (transformSequenceNode->GetNumberOfDataNodes() != numFrames
+    || vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(transformSequenceNode))
+  {
+    std::cerr << "Compact transform sequence was not expanded before saving" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // All transforms are read back from the file
+  vtkNew<vtkMatrix4x4> foundMatrix;
+  vtkNew<vtkMRMLScene> readScene;
+  vtkNew<vtkMRMLSequenceNode> readSequenceNode;
+  readScene->AddNode(readSequenceNode);
+  vtkNew<vtkMRMLSequenceStorageNode> readStorageNode;
+  readScene->AddNode(readStorageNode);
+  readStorageNode->SetFileName(fileName.c_str());
+  if (!readStorageNode->ReadData(readSequenceNode) || readSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    std::cerr << "Expected " << numFrames << " transforms in " << fileName << ", got "
+      << readSequenceNode->GetNumberOfDataNodes() << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(readSequenceNode->GetNthDataNode(i));
+    if (!transformNode || readSequenceNode->GetNthIndexValue(i) != transformSequenceNode->GetNthIndexValue(i))
+    {
+      std::cerr << "Unexpected item " << i << " in the saved sequence" << std::endl;
+      return EXIT_FAILURE;
+    }
+    transformNode->GetMatrixTransformToParent(foundMatrix);
+    if (foundMatrix->GetElement(0, 3) != i)
+    {
+      std::cerr << "Unexpected transform at item " << i << ": " << foundMatrix->GetElement(0, 3) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  logic->SetMRMLScene(nullptr);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioTransformName.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIOTransformSequence.h>
+
+//---------------------------------------------------------------------------
+int vtkTransformSequenceTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int numFrames = 200;
+
+  // Transforms are found by the closest timestamp
+  vtkNew<vtkSlicerIGSIOTransformSequence> transformSequence;
+  transformSequence->Reserve(numFrames);
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < numFrames; ++i)
+  {
+    matrix->SetElement(0, 3, i);
+    transformSequence->AddTransform(0.1 * i, matrix, i % 2 == 0);
+  }
+  if (transformSequence->GetNumberOfTransforms() != numFrames
+    || transformSequence->GetTransformNumberFromTimestamp(-1.0) != 0
+    || transformSequence->GetTransformNumberFromTimestamp(0.42) != 4
+    || transformSequence->GetTransformNumberFromTimestamp(0.48) != 5
+    || transformSequence->GetTransformNumberFromTimestamp(1000.0) != numFrames - 1
+    || transformSequence->GetNthTransformValid(3) || !transformSequence->GetNthTransformValid(4))
+  {
+    transformSequence->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkMatrix4x4> foundMatrix;
+  if (!transformSequence->GetNthTransform(7, foundMatrix) || foundMatrix->GetElement(0, 3) != 7.0)
+  {
+    std::cerr << "Unexpected transform" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (transformSequence->GetMemorySize() > 200 * static_cast<unsigned long long>(numFrames))
+  {
+    transformSequence->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Data nodes can be created from the compact transforms
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> expandedSequenceNode;
+  scene->AddNode(expandedSequenceNode);
+  transformSequence->SetTransformName("ProbeToTracker");
+  if (!transformSequence->WriteToSequence(expandedSequenceNode) || expandedSequenceNode->GetNumberOfDataNodes() != numFrames)
+  {
+    std::cerr << "Could not write the transforms to the sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Import a tracked frame list with compact transform sequences
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  trackedFrameList->SetCustomString("TrackName", "Image");
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(4, 4, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    igsioVideoFrame videoFrame;
+    videoFrame.DeepCopyFrom(image);
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(videoFrame);
+    trackedFrame.SetTimestamp(0.1 * i);
+    matrix->SetElement(0, 3, i);
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    trackedFrame.SetFrameTransform(probeToTracker, matrix);
+    trackedFrame.SetFrameTransformStatus(probeToTracker, ToolStatus::TOOL_OK);
+    trackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  bool success = vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, browserNode, false, true);
+  if (!success)
+  {
+    std::cerr << "Could not convert the tracked frame list" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkMRMLSequenceNode* masterSequenceNode = browserNode->GetMasterSequenceNode();
+  vtkMRMLSequenceNode* transformSequenceNode = nullptr;
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  browserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    if (vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(sequenceNode))
+    {
+      transformSequenceNode = sequenceNode;
+    }
+  }
+  if (!masterSequenceNode || masterSequenceNode->GetNumberOfDataNodes() != numFrames
+    || !transformSequenceNode || transformSequenceNode->GetNumberOfDataNodes() != 0
+    || vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(transformSequenceNode)->GetNumberOfTransforms() != numFrames)
+  {
+    std::cerr << "Expected a video sequence with " << numFrames << " items and a compact transform sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The proxy transform follows the selected item of the browser
+  browserNode->SetSelectedItemNumber(42);
+  vtkSlicerIGSIOTransformSequence::UpdateProxyNodes(browserNode);
+  vtkMRMLLinearTransformNode* proxyNode = vtkMRMLLinearTransformNode::SafeDownCast(browserNode->GetProxyNode(transformSequenceNode));
+  if (!proxyNode)
+  {
+    std::cerr << "No proxy node for the compact transform sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+  proxyNode->GetMatrixTransformToParent(foundMatrix);
+  if (foundMatrix->GetElement(0, 3) != 42.0)
+  {
+    std::cerr << "Unexpected proxy transform: " << foundMatrix->GetElement(0, 3) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSlicerIGSIOTransformSequence::RemoveSequenceTransforms(transformSequenceNode);
+
+  // Without compact transforms, a data node is added for every frame
+  vtkNew<vtkMRMLSequenceBrowserNode> fullBrowserNode;
+  scene->AddNode(fullBrowserNode);
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, fullBrowserNode))
+  {
+    std::cerr << "Could not convert the tracked frame list" << std::endl;
+    return EXIT_FAILURE;
+  }
+  sequenceNodes.clear();
+  fullBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+  transformSequenceNode = nullptr;
+  for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+  {
+    const char* source = sequenceNode->GetAttribute("Sequences.Source");
+    if (source && std::string(source) == "ProbeToTracker")
+    {
+      transformSequenceNode = sequenceNode;
+    }
+  }
+  if (!transformSequenceNode || transformSequenceNode->GetNumberOfDataNodes() != numFrames
+    || transformSequenceNode->GetNthIndexValue(42) != "4.2"
+    || std::string(transformSequenceNode->GetNthDataNode(42)->GetName()) != "ProbeToTrackerTransform_042")
+  {
+    std::cerr << "Expected a transform sequence with " << numFrames << " items" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkMRMLLinearTransformNode::SafeDownCast(transformSequenceNode->GetNthDataNode(42))->GetMatrixTransformToParent(foundMatrix);
+  if (foundMatrix->GetElement(0, 3) != 42.0)
+  {
+    std::cerr << "Unexpected transform: " << foundMatrix->GetElement(0, 3) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Tools that first appear after the first frame get their own transform sequence
+  int needleFirstFrame = numFrames / 2;
+  vtkNew<vtkIGSIOTrackedFrameList> lateToolTrackedFrameList;
+  lateToolTrackedFrameList->SetCustomString("TrackName", "Image");
+  for (int i = 0; i < numFrames; ++i)
+  {
+    igsioTrackedFrame trackedFrame(*trackedFrameList->GetTrackedFrame(i));
+    if (i >= needleFirstFrame)
+    {
+      matrix->SetElement(0, 3, -i);
+      igsioTransformName needleToTracker("Needle", "Tracker");
+      trackedFrame.SetFrameTransform(needleToTracker, matrix);
+      trackedFrame.SetFrameTransformStatus(needleToTracker, ToolStatus::TOOL_OK);
+    }
+    lateToolTrackedFrameList->AddTrackedFrame(&trackedFrame);
+  }
+
+  for (bool compactTransformSequences : { false, true })
+  {
+    vtkNew<vtkMRMLSequenceBrowserNode> lateToolBrowserNode;
+    scene->AddNode(lateToolBrowserNode);
+    if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(lateToolTrackedFrameList, lateToolBrowserNode, false, compactTransformSequences))
+    {
+      std::cerr << "Could not convert the tracked frame list with a late tool" << std::endl;
+      return EXIT_FAILURE;
+    }
+    sequenceNodes.clear();
+    lateToolBrowserNode->GetSynchronizedSequenceNodes(sequenceNodes, true);
+    vtkMRMLSequenceNode* needleSequenceNode = nullptr;
+    for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+    {
+      const char* source = sequenceNode->GetAttribute("Sequences.Source");
+      if (source && std::string(source) == "NeedleToTracker")
+      {
+        needleSequenceNode = sequenceNode;
+      }
+    }
+    if (!needleSequenceNode)
+    {
+      std::cerr << "No transform sequence for the tool that appears in frame " << needleFirstFrame << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    int numberOfNeedleTransforms = needleSequenceNode->GetNumberOfDataNodes();
+    vtkSlicerIGSIOTransformSequence* needleTransforms = vtkSlicerIGSIOTransformSequence::GetSequenceTransforms(needleSequenceNode);
+    if (compactTransformSequences)
+    {
+      numberOfNeedleTransforms = needleTransforms ? needleTransforms->GetNumberOfTransforms() : 0;
+    }
+    if (numberOfNeedleTransforms != numFrames - needleFirstFrame)
+    {
+      std::cerr << "Expected " << numFrames - needleFirstFrame << " needle transforms, found " << numberOfNeedleTransforms << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (compactTransformSequences)
+    {
+      needleTransforms->GetNthTransform(0, foundMatrix);
+    }
+    else
+    {
+      vtkMRMLLinearTransformNode::SafeDownCast(needleSequenceNode->GetNthDataNode(0))->GetMatrixTransformToParent(foundMatrix);
+    }
+    if (foundMatrix->GetElement(0, 3) != -needleFirstFrame)
+    {
+      std::cerr << "Unexpected first needle transform: " << foundMatrix->GetElement(0, 3) << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+    {
+      vtkSlicerIGSIOTransformSequence::RemoveSequenceTransforms(sequenceNode);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
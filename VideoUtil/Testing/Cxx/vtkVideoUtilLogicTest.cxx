@@ -0,0 +1,150 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkNew.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+#include <vtkSlicerIGSIODecodedFrameCache.h>
+#include <vtkSlicerIGSIOProxyDecoder.h>
+
+// VideoUtil includes
+#include <vtkSlicerVideoUtilLogic.h>
+
+//---------------------------------------------------------------------------
+int vtkVideoUtilLogicTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  int numFrames = 10;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerVideoUtilLogic> logic;
+  logic->SetMRMLScene(scene);
+
+  // Frames are only cached, prefetched and decoded in the background if the application enables it
+  if (logic->GetDecodedFrameCacheEnabled() || logic->GetPrefetchEnabled() || logic->GetProxyDecodingInBackground())
+  {
+    logic->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkSmartPointer<vtkMRMLStreamingVolumeNode> streamingVolumeNode = vtkSmartPointer<vtkMRMLStreamingVolumeNode>::New();
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // The browser is observed by the logic when it is added to the scene
+  vtkNew<vtkMRMLSequenceBrowserNode> browserNode;
+  scene->AddNode(browserNode);
+  browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  vtkNew<vtkMRMLStreamingVolumeNode> proxyNode;
+  scene->AddNode(proxyNode);
+  browserNode->AddProxyNode(proxyNode, sequenceNode, false);
+  browserNode->SetSaveChanges(sequenceNode, false);
+
+  vtkSlicerIGSIODecodedFrameCache* cache = vtkSlicerIGSIODecodedFrameCache::GetInstance();
+  browserNode->SetSelectedItemNumber(3);
+  if (cache->GetNumberOfCachedImages() != 0)
+  {
+    std::cerr << "Frame was cached while the decoded frame cache was disabled" << std::endl;
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Selecting an item decodes the frame into the cache and sets the image in the proxy node
+  logic->DecodedFrameCacheEnabledOn();
+  logic->ProxyDecodingInBackgroundOff();
+  browserNode->SetSelectedItemNumber(4);
+  if (!proxyNode->GetImageData() || proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 4
+    || cache->GetNumberOfCachedImages() != 1 || cache->GetNumberOfMisses() != 1)
+  {
+    std::cerr << "Proxy node was not updated from the decoded frame cache" << std::endl;
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // The proxy node does not share the image object of the cache
+  vtkSmartPointer<vtkImageData> cachedImageData = cache->GetDecodedImage(sequenceNode, 4);
+  if (proxyNode->GetImageData() == cachedImageData.GetPointer())
+  {
+    std::cerr << "Cached image was set in the proxy node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Selecting a cached item again does not decode the frame
+  browserNode->SetSelectedItemNumber(5);
+  browserNode->SetSelectedItemNumber(4);
+  if (proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 4 || cache->GetNumberOfMisses() != 2)
+  {
+    std::cerr << "Cached image was not used for the proxy node" << std::endl;
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  // Items that are selected while the browser is not playing are decoded immediately, even if background decoding is enabled
+  logic->ProxyDecodingInBackgroundOn();
+  browserNode->SetSelectedItemNumber(6);
+  if (proxyNode->GetImageData()->GetScalarComponentAsDouble(0, 0, 0, 0) != 6
+    || logic->GetProxyDecoder()->GetNumberOfDecodedRequests() != 0)
+  {
+    std::cerr << "Proxy node was not updated immediately when the browser is not playing" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Removing the sequence removes its images from the cache
+  scene->RemoveNode(browserNode);
+  scene->RemoveNode(sequenceNode);
+  if (cache->GetNumberOfCachedImages() != 0)
+  {
+    cache->Print(std::cerr);
+    return EXIT_FAILURE;
+  }
+
+  logic->SetMRMLScene(nullptr);
+  return EXIT_SUCCESS;
+}
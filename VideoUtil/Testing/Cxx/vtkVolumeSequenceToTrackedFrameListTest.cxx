@@ -0,0 +1,108 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+This file was originally developed by Kyle Sunderland, PerkLab, Queen's University
+and was supported through CANARIE's Research Software Program, and Cancer
+Care Ontario.
+
+==============================================================================*/
+
+// std includes
+#include <iostream>
+#include <sstream>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <igsioVideoFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceNode.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// SlicerIGSIOCommon includes
+#include <vtkSlicerIGSIOCommon.h>
+
+//---------------------------------------------------------------------------
+int vtkVolumeSequenceToTrackedFrameListTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkStreamingVolumeCodecFactory> factory = vtkStreamingVolumeCodecFactory::GetInstance();
+
+  int numFrames = 20;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  sequenceNode->SetIndexName("time");
+  scene->AddNode(sequenceNode);
+  for (int i = 0; i < numFrames; ++i)
+  {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(10, 10, 1);
+    imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+    imageData->GetPointData()->GetScalars()->Fill(i);
+
+    vtkNew<vtkMRMLStreamingVolumeNode> streamingVolumeNode;
+    streamingVolumeNode->SetAndObserveImageData(imageData);
+
+    std::stringstream indexValue;
+    indexValue << 0.5 * i;
+    sequenceNode->SetDataNodeAtValue(streamingVolumeNode, indexValue.str());
+  }
+  if (!vtkSlicerIGSIOCommon::ReEncodeVideoSequence(sequenceNode, 0, -1, "RV24"))
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkIGSIOTrackedFrameList> trackedFrameList;
+  if (!vtkSlicerIGSIOCommon::VolumeSequenceToTrackedFrameList(sequenceNode, trackedFrameList))
+  {
+    std::cerr << "Could not export the sequence" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numFrames))
+  {
+    std::cerr << "Expected " << numFrames << " tracked frames, got " << trackedFrameList->GetNumberOfTrackedFrames() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The encoded frames of the sequence are shared by the tracked frames, not copied
+  for (int i = 0; i < numFrames; ++i)
+  {
+    igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
+    vtkMRMLStreamingVolumeNode* streamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(i));
+    if (trackedFrame->GetImageData()->GetEncodedFrame() != streamingVolumeNode->GetFrame())
+    {
+      std::cerr << "The encoded frame of item " << i << " is not shared" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (trackedFrame->GetTimestamp() != 0.5 * i || trackedFrame->GetFrameField("FrameStatus") != "0")
+    {
+      std::cerr << "Unexpected timestamp or status of item " << i << ": " << trackedFrame->GetTimestamp()
+        << ", " << trackedFrame->GetFrameField("FrameStatus") << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
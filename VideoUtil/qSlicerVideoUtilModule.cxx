@@ -45,6 +45,12 @@ Care Ontario.
 // vtkAddon include
 #include <vtkStreamingVolumeCodecFactory.h>
 
+// Qt includes
+#include <QTimer>
+
+// Interval at which the images that were decoded in the background are set in the proxy nodes
+static const int PROXY_DECODE_TIMER_INTERVAL_MS = 15;
+
 //-----------------------------------------------------------------------------
 #include <QtGlobal>
 #if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
@@ -58,6 +64,7 @@ class qSlicerVideoUtilModulePrivate
 public:
   qSlicerVideoUtilModulePrivate();
 
+  QTimer ProxyDecodeTimer;
 };
 
 //-----------------------------------------------------------------------------
@@ -144,6 +151,21 @@ void qSlicerVideoUtilModule::setup()
 #ifdef IGSIO_USE_VP9
   codecFactory->RegisterStreamingCodec(vtkSmartPointer<vtkVP9VolumeCodec>::New());
 #endif
+
+  // Proxy nodes can only be modified on the main thread, so the decoded images are collected by a timer
+  Q_D(qSlicerVideoUtilModule);
+  connect(&d->ProxyDecodeTimer, SIGNAL(timeout()), this, SLOT(processDecodedProxyNodes()));
+  d->ProxyDecodeTimer.start(PROXY_DECODE_TIMER_INTERVAL_MS);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoUtilModule::processDecodedProxyNodes()
+{
+  vtkSlicerVideoUtilLogic* logic = vtkSlicerVideoUtilLogic::SafeDownCast(this->logic());
+  if (logic)
+  {
+    logic->ProcessDecodedProxyNodes();
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -78,6 +78,10 @@ protected:
 public slots:
   virtual void setMRMLScene(vtkMRMLScene*) override;
 
+protected slots:
+  /// Set the images that were decoded in the background in the proxy nodes
+  void processDecodedProxyNodes();
+
 protected:
   QScopedPointer<qSlicerVideoUtilModulePrivate> d_ptr;
 
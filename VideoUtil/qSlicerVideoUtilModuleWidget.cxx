@@ -34,10 +34,12 @@ Care Ontario.
 #include <vtkStreamingVolumeCodecFactory.h>
 
 // SequenceMRML includes
+#include <vtkMRMLSequenceBrowserNode.h>
 #include <vtkMRMLSequenceNode.h>
 
 // SlicerIGSIOCommon includes
 #include "vtkSlicerIGSIOCommon.h"
+#include "vtkSlicerIGSIOEncodingJob.h"
 
 // qMRMLWidgets includes
 #include <qMRMLNodeFactory.h>
@@ -61,7 +63,17 @@ protected:
 public:
   qSlicerVideoUtilModuleWidgetPrivate(qSlicerVideoUtilModuleWidget& object);
   ~qSlicerVideoUtilModuleWidgetPrivate();
+
+  /// Get the codec parameters from the parameter table
+  std::map<std::string, std::string> encodingParameters();
+
+  /// Show the progress dialog and create a new encoding job
+  void startEncoding(QWidget* parent);
+
+  /// Hide the progress dialog and remove the encoding job
+  void stopEncoding();
   QProgressDialog* EncodingProgressDialog;
+  vtkSmartPointer<vtkSlicerIGSIOEncodingJob> EncodingJob;
 
 };
 
@@ -80,6 +92,57 @@ qSlicerVideoUtilModuleWidgetPrivate::~qSlicerVideoUtilModuleWidgetPrivate()
 {
 }
 
+//-----------------------------------------------------------------------------
+std::map<std::string, std::string> qSlicerVideoUtilModuleWidgetPrivate::encodingParameters()
+{
+  std::map<std::string, std::string> parameters;
+  for (int i = 0; i < this->encodingParameterTable->rowCount(); ++i)
+  {
+    QLabel* nameLabel = qobject_cast<QLabel*>(this->encodingParameterTable->cellWidget(i, PARAMETER_NAME_COLUMN));
+    std::string parameterName = nameLabel->text().toStdString();
+
+    QLineEdit* valueTextEdit = qobject_cast<QLineEdit*>(this->encodingParameterTable->cellWidget(i, PARAMETER_VALUE_COLUMN));
+    std::string parameterValue = valueTextEdit->text().toStdString();
+    if (parameterValue == "")
+    {
+      continue;
+    }
+    parameters[parameterName] = parameterValue;
+  }
+  return parameters;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoUtilModuleWidgetPrivate::startEncoding(QWidget* parent)
+{
+  if (!this->EncodingProgressDialog)
+  {
+    this->EncodingProgressDialog = new QProgressDialog("Sequence encoding", "Cancel",
+      0, 100, parent);
+    this->EncodingProgressDialog->setWindowTitle(QString("Encoding sequence..."));
+    this->EncodingProgressDialog->setWindowFlags(this->EncodingProgressDialog->windowFlags()
+      & ~Qt::WindowCloseButtonHint & ~Qt::WindowContextHelpButtonHint);
+    this->EncodingProgressDialog->setFixedSize(this->EncodingProgressDialog->sizeHint());
+    this->EncodingProgressDialog->setWindowModality(Qt::WindowModal);
+  }
+
+  // Output sequences are restored if the encoding is cancelled
+  this->EncodingJob = vtkSmartPointer<vtkSlicerIGSIOEncodingJob>::New();
+  this->EncodingJob->RollbackOnCancelOn();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoUtilModuleWidgetPrivate::stopEncoding()
+{
+  this->EncodingJob = nullptr;
+
+  if (this->EncodingProgressDialog)
+  {
+    delete this->EncodingProgressDialog;
+    this->EncodingProgressDialog = nullptr;
+  }
+}
+
 //-----------------------------------------------------------------------------
 // qSlicerVideoUtilModuleWidget methods
 
@@ -103,6 +166,7 @@ void qSlicerVideoUtilModuleWidget::setup()
   this->Superclass::setup();
 
   connect(d->encodeButton, SIGNAL(clicked()), this, SLOT(encodeVideo()));
+  connect(d->encodeBrowserButton, SIGNAL(clicked()), this, SLOT(encodeSequenceBrowser()));
   connect(d->codecSelector, SIGNAL(currentIndexChanged(const QString&)), this, SLOT(onCodecChanged(QString)));
 
   std::vector<std::string> codecFourCCs = vtkStreamingVolumeCodecFactory::GetInstance()->GetStreamingCodecFourCCs();
@@ -169,45 +233,61 @@ void qSlicerVideoUtilModuleWidget::encodeVideo()
     return;
   }
 
-  std::map<std::string, std::string> parameters;
-  for (int i = 0; i < d->encodingParameterTable->rowCount(); ++i)
-  {
-    QLabel* nameLabel = qobject_cast<QLabel*>(d->encodingParameterTable->cellWidget(i, PARAMETER_NAME_COLUMN));
-    std::string parameterName = nameLabel->text().toStdString();
+  std::map<std::string, std::string> parameters = d->encodingParameters();
 
-    QLineEdit* valueTextEdit = qobject_cast<QLineEdit*>(d->encodingParameterTable->cellWidget(i, PARAMETER_VALUE_COLUMN));
-    std::string parameterValue = valueTextEdit->text().toStdString();
-    if (parameterValue == "")
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetClientData(this);
+  progressCallback->SetCallback(qSlicerVideoUtilModuleWidget::updateProgress);
+
+  d->startEncoding(this);
+
+  std::string encoding = d->codecSelector->currentText().toStdString();
+  if (!vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, 0, -1, encoding, parameters, true, false, progressCallback, d->EncodingJob))
+  {
+    if (d->EncodingJob->IsCancelled())
     {
-      continue;
+      qDebug() << "Sequence encoding cancelled";
     }
-    parameters[parameterName] = parameterValue;
+    else
+    {
+      qCritical() << "Sequence encoding failed!";
+    }
+  }
+  d->stopEncoding();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoUtilModuleWidget::encodeSequenceBrowser()
+{
+  Q_D(qSlicerVideoUtilModuleWidget);
+  vtkMRMLSequenceBrowserNode* sequenceBrowserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(d->sequenceBrowserNodeSelector->currentNode());
+  if (!sequenceBrowserNode)
+  {
+    qCritical() << "Invalid sequence browser node!";
+    return;
   }
 
+  std::map<std::string, std::string> parameters = d->encodingParameters();
+
   vtkNew<vtkCallbackCommand> progressCallback;
   progressCallback->SetClientData(this);
   progressCallback->SetCallback(qSlicerVideoUtilModuleWidget::updateProgress);
 
-  if (!d->EncodingProgressDialog)
-  {
-    d->EncodingProgressDialog = new QProgressDialog("Sequence encoding", "",
-      0, 100, this);
-    d->EncodingProgressDialog->setWindowTitle(QString("Encoding sequence..."));
-    d->EncodingProgressDialog->setCancelButton(nullptr);
-    d->EncodingProgressDialog->setWindowFlags(d->EncodingProgressDialog->windowFlags()
-      & ~Qt::WindowCloseButtonHint & ~Qt::WindowContextHelpButtonHint);
-    d->EncodingProgressDialog->setFixedSize(d->EncodingProgressDialog->sizeHint());
-    d->EncodingProgressDialog->setWindowModality(Qt::WindowModal);
-  }
+  d->startEncoding(this);
 
   std::string encoding = d->codecSelector->currentText().toStdString();
-  vtkSlicerIGSIOCommon::EncodeVideoSequence(inputSequenceNode, outputSequenceNode, 0, -1, encoding, parameters, true, false, progressCallback);
-
-  if (d->EncodingProgressDialog)
+  if (!vtkSlicerIGSIOCommon::EncodeSequenceBrowser(sequenceBrowserNode, encoding, parameters, true, false, progressCallback, d->EncodingJob))
   {
-    delete d->EncodingProgressDialog;
-    d->EncodingProgressDialog = nullptr;
+    if (d->EncodingJob->IsCancelled())
+    {
+      qDebug() << "Sequence browser encoding cancelled";
+    }
+    else
+    {
+      qCritical() << "Sequence browser encoding failed!";
+    }
   }
+  d->stopEncoding();
 }
 
 //-----------------------------------------------------------------------------
@@ -220,6 +300,12 @@ void qSlicerVideoUtilModuleWidget::updateProgress(vtkObject* caller, unsigned lo
   //vtkWarningWithObjectMacro(nullptr, << *progress);
   d->EncodingProgressDialog->setValue(100 * (*progress));
   d->EncodingProgressDialog->update();
+
+  // Events are processed by the modal progress dialog when the value is set, so the cancel button can be pressed while encoding
+  if (d->EncodingProgressDialog->wasCanceled() && d->EncodingJob)
+  {
+    d->EncodingJob->Cancel();
+  }
 }
 
 //-----------------------------------------------------------------------------
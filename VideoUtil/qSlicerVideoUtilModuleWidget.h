@@ -48,6 +48,7 @@ public slots:
 
   void onCodecChanged(const QString& fourCC);
   void encodeVideo();
+  void encodeSequenceBrowser();
 
 protected:
   QScopedPointer<qSlicerVideoUtilModuleWidgetPrivate> d_ptr;
@@ -133,7 +133,11 @@ bool qSlicerVideoUtilReader::load(const IOProperties& properties)
   sequenceBrowserNode->SetName(this->mrmlScene()->GetUniqueNameByString(sequenceBrowserName.c_str()));
   this->mrmlScene()->AddNode(sequenceBrowserNode);
 
-  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, sequenceBrowserNode))
+  // The tracked frames are consumed by the conversion, so the codec is read from the list first
+  std::string encodingFourCC;
+  trackedFrameList->GetEncodingFourCC(encodingFourCC);
+
+  if (!vtkSlicerIGSIOCommon::TrackedFrameListToSequenceBrowser(trackedFrameList, sequenceBrowserNode, true))
   {
     this->mrmlScene()->RemoveNode(sequenceBrowserNode);
     qCritical() << Q_FUNC_INFO << " could not convert tracked frame list to sequence browser node";
@@ -159,8 +163,7 @@ bool qSlicerVideoUtilReader::load(const IOProperties& properties)
     vtkSmartPointer<vtkMRMLStreamingVolumeSequenceStorageNode> storageNode = vtkSmartPointer<vtkMRMLStreamingVolumeSequenceStorageNode>::New();
     this->mrmlScene()->AddNode(storageNode.GetPointer());
     sequenceNode->SetAndObserveStorageNodeID(storageNode->GetID());
-    std::string encodingFourCC;
-    if (trackedFrameList->GetEncodingFourCC(encodingFourCC))
+    if (!encodingFourCC.empty())
     {
       storageNode->SetCodecFourCC(encodingFourCC);
     }